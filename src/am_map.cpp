@@ -89,6 +89,7 @@ static const double M_ZOOMIN = 2; // how much zoom-in per second
 static const double M_ZOOMOUT = 0.2; // how much zoom-out per second
 static const double M_OLDZOOMIN = (1.02); // for am_zoom
 static const double M_OLDZOOMOUT = (1 / 1.02);
+static const double LINEGRIDSIZE = 128.;	// cell size of the automap's line grid
 
 static FTextureID marknums[AM_NUMMARKPOINTS]; // numbers used for marking by the automap
 bool automapactive = false;
@@ -970,6 +971,34 @@ class DAutomap :public DAutomapBase
 
 	TArray<FVector2> points;
 
+	// per line results of classifyLine, see updateLineCache
+	struct AMLineInfo
+	{
+		AMColor color;
+		int portalgroup;
+		bool visible;
+	};
+
+	TArray<AMLineInfo> lineCache;
+	TArray<int> polyLines;
+	TArray<int> gridStart;		// first entry in gridLines for each cell, plus one past the end
+	TArray<int> gridLines;
+	DVector2 gridOrigin;
+	int gridWidth = 0, gridHeight = 0;
+	TArray<int> lineStamps;
+	int lineStamp = 0;
+	TArray<F2DDrawer::TwoDLine> lineBatch;
+
+	int lineCacheTic = -1;
+	int lineCacheCheat = 0;
+	int lineCachePortalGroup = 0;
+	int lineCacheTriggerLines = 0;
+	bool lineCacheAllmap = false;
+	bool lineCacheShowAll = false;
+	bool lineCacheCheatmode = false;
+	bool lineCachePortalOverlay = false;
+	AMColorset lineCacheColors;
+
 	// translates between frame-buffer and map distances
 	double FTOM(double x)
 	{
@@ -1019,6 +1048,12 @@ class DAutomap :public DAutomapBase
 	void drawSeg(seg_t *seg, const AMColor &color);
 	void drawPolySeg(FPolySeg *seg, const AMColor &color);
 	void showSS();
+	bool classifyLine(line_t &line, bool allmap, bool portalmode, AMColor &color);
+	void updateLineCache(bool allmap);
+	void buildLineGrid();
+	int getLineGridX(double x) const { return clamp(int((x - gridOrigin.X) / LINEGRIDSIZE), 0, gridWidth - 1); }
+	int getLineGridY(double y) const { return clamp(int((y - gridOrigin.Y) / LINEGRIDSIZE), 0, gridHeight - 1); }
+	void addWallLine(line_t &line, const DVector2 &offset, bool rotate);
 	void drawWalls(bool allmap);
 	void drawLineCharacter(const mline_t *lineguy, size_t lineguylines, double scale, DAngle angle, const AMColor &color, double x, double y);
 	void drawPlayers();
@@ -1363,6 +1398,7 @@ void DAutomap::LevelInit ()
 	}
 
 	clearMarks();
+	lineCache.Clear();
 
 	findMinMaxBoundaries();
 	scale_mtof = min_scale_mtof / 0.7;
@@ -2476,164 +2512,384 @@ bool AM_isLockBoundary (line_t &line, int *lockptr = nullptr)
 
 //=============================================================================
 //
-// Determines visible lines, draws them.
-// This is LineDef based, not LineSeg based.
+// Determines whether and in which color a line is shown on the map.
 //
 //=============================================================================
 
-void DAutomap::drawWalls (bool allmap)
+bool DAutomap::classifyLine(line_t &line, bool allmap, bool portalmode, AMColor &color)
 {
-	static mline_t l;
-	int lock, color;
-
-	int numportalgroups = am_portaloverlay ? Level->Displacements.size : 0;
+	int lock;
 
-	for (int p = numportalgroups - 1; p >= -1; p--)
+	if (am_cheat != 0 || (line.flags & ML_MAPPED))
 	{
-		if (p == MapPortalGroup) continue;
-
-
-		for (auto &line : Level->lines)
+		if ((line.flags & ML_DONTDRAW) && (am_cheat == 0 || am_cheat >= 4))
 		{
-			int pg;
-			
-			if (line.sidedef[0]->Flags & WALLF_POLYOBJ)
+			if (!am_showallenabled || CheckCheatmode(false))
 			{
-				// For polyobjects we must test the surrounding sector to get the proper group.
-				pg = Level->PointInSector(line.v1->fX() + line.Delta().X / 2, line.v1->fY() + line.Delta().Y / 2)->PortalGroup;
+				return false;
 			}
+		}
+
+		if (line.automapstyle > AMLS_Default && line.automapstyle < AMLS_COUNT
+			&& (am_cheat == 0 || am_cheat >= 4))
+		{
+			color = AMColors[AUTOMAP_LINE_COLORS[line.automapstyle]];
+			return true;
+		}
+
+		if (portalmode)
+		{
+			color = AMColors[AMColors.PortalColor];
+		}
+		else if (AM_CheckSecret(&line) == 1)
+		{
+			// map secret sectors like Boom
+			color = AMColors[AMColors.SecretSectorColor];
+		}
+		else if (AM_CheckSecret(&line) == 2)
+		{
+			color = AMColors[AMColors.UnexploredSecretColor];
+		}
+		else if (line.flags & ML_SECRET)
+		{ // secret door
+			if (am_cheat != 0 && line.backsector != nullptr)
+				color = AMColors[AMColors.SecretWallColor];
 			else
+				color = AMColors[AMColors.WallColor];
+		}
+		else if (AM_isTeleportBoundary(line) && AMColors.isValid(AMColors.IntraTeleportColor))
+		{ // intra-level teleporters
+			color = AMColors[AMColors.IntraTeleportColor];
+		}
+		else if (AM_isExitBoundary(line) && AMColors.isValid(AMColors.InterTeleportColor))
+		{ // inter-level/game-ending teleporters
+			color = AMColors[AMColors.InterTeleportColor];
+		}
+		else if (AM_isLockBoundary(line, &lock))
+		{
+			if (AMColors.displayLocks)
 			{
-				pg = line.frontsector->PortalGroup;
+				int lockcolor = P_GetMapColorForLock(lock);
+
+				if (lockcolor >= 0) color.FromRGB(RPART(lockcolor), GPART(lockcolor), BPART(lockcolor));
+				else color = AMColors[AMColors.LockedColor];
 			}
-			DVector2 offset;
-			bool portalmode = numportalgroups > 0 &&  pg != MapPortalGroup;
-			if (pg == p)
+			else
 			{
-				offset = Level->Displacements.getOffset(pg, MapPortalGroup);
+				color = AMColors[AMColors.LockedColor];  // locked special
 			}
-			else if (p == -1 && (pg == MapPortalGroup || !am_portaloverlay))
+		}
+		else if (am_showtriggerlines
+			&& AMColors.isValid(AMColors.SpecialWallColor)
+			&& AM_isTriggerBoundary(line))
+		{
+			color = AMColors[AMColors.SpecialWallColor];	// wall with special non-door action the player can do
+		}
+		else if (line.backsector == nullptr)
+		{
+			color = AMColors[AMColors.WallColor];	// one-sided wall
+		}
+		else if (line.backsector->floorplane
+			!= line.frontsector->floorplane)
+		{
+			color = AMColors[AMColors.FDWallColor]; // floor level change
+		}
+		else if (line.backsector->ceilingplane
+			!= line.frontsector->ceilingplane)
+		{
+			color = AMColors[AMColors.CDWallColor]; // ceiling level change
+		}
+		else if (AM_Check3DFloors(&line))
+		{
+			color = AMColors[AMColors.EFWallColor]; // Extra floor border
+		}
+		else if (am_cheat > 0 && am_cheat < 4)
+		{
+			color = AMColors[AMColors.TSWallColor];
+		}
+		else return false;
+		return true;
+	}
+	else if (allmap || (line.flags & ML_REVEALED))
+	{
+		if ((line.flags & ML_DONTDRAW) && (am_cheat == 0 || am_cheat >= 4))
+		{
+			if (!am_showallenabled || CheckCheatmode(false))
 			{
-				offset = { 0, 0 };
+				return false;
 			}
-			else continue;
+		}
+		color = AMColors[AMColors.NotSeenColor];
+		return true;
+	}
+	return false;
+}
 
-			l.a.x = (line.v1->fX() + offset.X);
-			l.a.y = (line.v1->fY() + offset.Y);
-			l.b.x = (line.v2->fX() + offset.X);
-			l.b.y = (line.v2->fY() + offset.Y);
+//=============================================================================
+//
+// Sorts all lines except the polyobjects' into a grid so that drawWalls
+// only has to look at the part of the map that is in view. This cannot use
+// the gameplay blockmap because maps may leave lines out of it on purpose.
+//
+//=============================================================================
 
-			if (am_rotate == 1 || (am_rotate == 2 && viewactive))
-			{
-				rotatePoint(&l.a.x, &l.a.y);
-				rotatePoint(&l.b.x, &l.b.y);
-			}
+void DAutomap::buildLineGrid()
+{
+	gridStart.Clear();
+	gridLines.Clear();
+	gridWidth = gridHeight = 0;
 
-			if (am_cheat != 0 || (line.flags & ML_MAPPED))
-			{
-				if ((line.flags & ML_DONTDRAW) && (am_cheat == 0 || am_cheat >= 4))
-				{
-					if (!am_showallenabled || CheckCheatmode(false))
-					{
-						continue;
-					}
-				}
+	double minx = FLT_MAX, miny = FLT_MAX, maxx = -FLT_MAX, maxy = -FLT_MAX;
+	for (auto &line : Level->lines)
+	{
+		if (line.sidedef[0]->Flags & WALLF_POLYOBJ) continue;
+		minx = min(minx, line.bbox[BOXLEFT]);
+		maxx = max(maxx, line.bbox[BOXRIGHT]);
+		miny = min(miny, line.bbox[BOXBOTTOM]);
+		maxy = max(maxy, line.bbox[BOXTOP]);
+	}
+	if (minx > maxx) return;
 
-				if (line.automapstyle > AMLS_Default && line.automapstyle < AMLS_COUNT
-					&& (am_cheat == 0 || am_cheat >= 4))
-				{
-					drawMline(&l, AUTOMAP_LINE_COLORS[line.automapstyle]);
-					continue;
-				}
+	gridOrigin = { minx, miny };
+	gridWidth = int((maxx - minx) / LINEGRIDSIZE) + 1;
+	gridHeight = int((maxy - miny) / LINEGRIDSIZE) + 1;
 
-				if (portalmode)
-				{
-					drawMline(&l, AMColors.PortalColor);
-				}
-				else if (AM_CheckSecret(&line) == 1)
-				{
-					// map secret sectors like Boom
-					drawMline(&l, AMColors.SecretSectorColor);
-				}
-				else if (AM_CheckSecret(&line) == 2)
-				{
-					drawMline(&l, AMColors.UnexploredSecretColor);
-				}
-				else if (line.flags & ML_SECRET)
-				{ // secret door
-					if (am_cheat != 0 && line.backsector != nullptr)
-						drawMline(&l, AMColors.SecretWallColor);
-					else
-						drawMline(&l, AMColors.WallColor);
-				}
-				else if (AM_isTeleportBoundary(line) && AMColors.isValid(AMColors.IntraTeleportColor))
-				{ // intra-level teleporters
-					drawMline(&l, AMColors.IntraTeleportColor);
-				}
-				else if (AM_isExitBoundary(line) && AMColors.isValid(AMColors.InterTeleportColor))
-				{ // inter-level/game-ending teleporters
-					drawMline(&l, AMColors.InterTeleportColor);
-				}
-				else if (AM_isLockBoundary(line, &lock))
-				{
-					if (AMColors.displayLocks)
-					{
-						color = P_GetMapColorForLock(lock);
+	auto cellrange = [&](const line_t &line, int &x1, int &x2, int &y1, int &y2)
+	{
+		x1 = getLineGridX(line.bbox[BOXLEFT]);
+		x2 = getLineGridX(line.bbox[BOXRIGHT]);
+		y1 = getLineGridY(line.bbox[BOXBOTTOM]);
+		y2 = getLineGridY(line.bbox[BOXTOP]);
+	};
 
-						AMColor c;
+	// Count the lines per cell first so that the lists can be packed into one array.
+	gridStart.Resize(gridWidth * gridHeight + 1);
+	memset(gridStart.Data(), 0, gridStart.Size() * sizeof(int));
+	for (auto &line : Level->lines)
+	{
+		if (line.sidedef[0]->Flags & WALLF_POLYOBJ) continue;
+		int x1, x2, y1, y2;
+		cellrange(line, x1, x2, y1, y2);
+		for (int y = y1; y <= y2; y++)
+			for (int x = x1; x <= x2; x++)
+				gridStart[y * gridWidth + x + 1]++;
+	}
+	for (unsigned i = 1; i < gridStart.Size(); i++)
+	{
+		gridStart[i] += gridStart[i - 1];
+	}
 
-						if (color >= 0)	c.FromRGB(RPART(color), GPART(color), BPART(color));
-						else c = AMColors[AMColors.LockedColor];
+	TArray<int> fill(gridStart.Size() - 1, true);
+	memcpy(fill.Data(), gridStart.Data(), fill.Size() * sizeof(int));
+	gridLines.Resize(gridStart.Last());
+	for (auto &line : Level->lines)
+	{
+		if (line.sidedef[0]->Flags & WALLF_POLYOBJ) continue;
+		int x1, x2, y1, y2;
+		cellrange(line, x1, x2, y1, y2);
+		for (int y = y1; y <= y2; y++)
+			for (int x = x1; x <= x2; x++)
+				gridLines[fill[y * gridWidth + x]++] = line.Index();
+	}
+}
 
-						drawMline(&l, c);
-					}
-					else
-					{
-						drawMline(&l, AMColors.LockedColor);  // locked special
-					}
-				}
-				else if (am_showtriggerlines
-					&& AMColors.isValid(AMColors.SpecialWallColor)
-					&& AM_isTriggerBoundary(line))
-				{
-					drawMline(&l, AMColors.SpecialWallColor);	// wall with special non-door action the player can do
-				}
-				else if (line.backsector == nullptr)
-				{
-					drawMline(&l, AMColors.WallColor);	// one-sided wall
-				}
-				else if (line.backsector->floorplane
-					!= line.frontsector->floorplane)
-				{
-					drawMline(&l, AMColors.FDWallColor); // floor level change
-				}
-				else if (line.backsector->ceilingplane
-					!= line.frontsector->ceilingplane)
-				{
-					drawMline(&l, AMColors.CDWallColor); // ceiling level change
-				}
-				else if (AM_Check3DFloors(&line))
-				{
-					drawMline(&l, AMColors.EFWallColor); // Extra floor border
-				}
-				else if (am_cheat > 0 && am_cheat < 4)
-				{
-					drawMline(&l, AMColors.TSWallColor);
-				}
+//=============================================================================
+//
+// Classifies all lines of the level.
+//
+// Everything this depends on is either play state, which cannot change
+// more than once per tic, or part of the cache key, so for all frames
+// rendered within the same tic the result of the last call is reused.
+//
+//=============================================================================
+
+void DAutomap::updateLineCache(bool allmap)
+{
+	bool portaloverlay = am_portaloverlay && Level->Displacements.size > 0;
+	bool cheatmode = CheckCheatmode(false);
+
+	if (lineCache.Size() == Level->lines.Size() && lineCacheTic == gametic && lineCacheCheat == am_cheat &&
+		lineCacheAllmap == allmap && lineCacheShowAll == am_showallenabled && lineCacheCheatmode == cheatmode &&
+		lineCachePortalOverlay == portaloverlay && lineCachePortalGroup == MapPortalGroup &&
+		lineCacheTriggerLines == am_showtriggerlines && lineCacheColors.displayLocks == AMColors.displayLocks &&
+		!memcmp(lineCacheColors.c, AMColors.c, sizeof(AMColors.c)))
+	{
+		return;
+	}
+
+	lineCacheTic = gametic;
+	lineCacheCheat = am_cheat;
+	lineCacheAllmap = allmap;
+	lineCacheShowAll = am_showallenabled;
+	lineCacheCheatmode = cheatmode;
+	lineCachePortalOverlay = portaloverlay;
+	lineCachePortalGroup = MapPortalGroup;
+	lineCacheTriggerLines = am_showtriggerlines;
+	lineCacheColors = AMColors;
+
+	if (lineCache.Size() != Level->lines.Size())
+	{
+		lineCache.Resize(Level->lines.Size());
+		lineStamps.Resize(Level->lines.Size());
+		memset(lineStamps.Data(), 0, lineStamps.Size() * sizeof(int));
+		lineStamp = 0;
+		polyLines.Clear();
+		for (auto &line : Level->lines)
+		{
+			if (line.sidedef[0]->Flags & WALLF_POLYOBJ) polyLines.Push(line.Index());
+		}
+		buildLineGrid();
+	}
+
+	for (auto &line : Level->lines)
+	{
+		auto &info = lineCache[line.Index()];
+		int pg;
+
+		if (line.sidedef[0]->Flags & WALLF_POLYOBJ)
+		{
+			// For polyobjects we must test the surrounding sector to get the proper group.
+			pg = Level->PointInSector(line.v1->fX() + line.Delta().X / 2, line.v1->fY() + line.Delta().Y / 2)->PortalGroup;
+		}
+		else
+		{
+			pg = line.frontsector->PortalGroup;
+		}
+		info.portalgroup = pg;
+		info.visible = classifyLine(line, allmap, portaloverlay && pg != MapPortalGroup, info.color);
+	}
+}
+
+//=============================================================================
+//
+// Adds a line to the batch if it is visible in the map window.
+//
+//=============================================================================
+
+void DAutomap::addWallLine(line_t &line, const DVector2 &offset, bool rotate)
+{
+	mline_t l;
+	fline_t fl;
+
+	l.a.x = (line.v1->fX() + offset.X);
+	l.a.y = (line.v1->fY() + offset.Y);
+	l.b.x = (line.v2->fX() + offset.X);
+	l.b.y = (line.v2->fY() + offset.Y);
+
+	if (rotate)
+	{
+		rotatePoint(&l.a.x, &l.a.y);
+		rotatePoint(&l.b.x, &l.b.y);
+	}
+
+	if (clipMline(&l, &fl))
+	{
+		auto &out = lineBatch[lineBatch.Reserve(1)];
+		out.x1 = float(f_x + fl.a.x);
+		out.y1 = float(f_y + fl.a.y);
+		out.x2 = float(f_x + fl.b.x);
+		out.y2 = float(f_y + fl.b.y);
+		out.color = lineCache[line.Index()].color.RGB;
+	}
+}
+
+//=============================================================================
+//
+// Determines visible lines, draws them.
+// This is LineDef based, not LineSeg based.
+//
+// Only the blocks that can be inside the map window get checked. If the
+// map is rotated this is the circle around the window's center that
+// contains its corners. Polyobject lines are not part of the grid and
+// always get checked. All lines are sent to the 2D drawer in one batch.
+//
+//=============================================================================
+
+void DAutomap::drawWalls (bool allmap)
+{
+	updateLineCache(allmap);
+	lineBatch.Clear();
+
+	int numportalgroups = am_portaloverlay ? Level->Displacements.size : 0;
+	bool rotate = am_rotate == 1 || (am_rotate == 2 && viewactive);
+
+	double left = m_x, bottom = m_y, right = m_x2, top = m_y2;
+	if (rotate)
+	{
+		double radius = sqrt(m_w * m_w + m_h * m_h) / 2;
+		double pivotx = m_x + m_w / 2;
+		double pivoty = m_y + m_h / 2;
+		left = pivotx - radius;
+		right = pivotx + radius;
+		bottom = pivoty - radius;
+		top = pivoty + radius;
+	}
+
+	for (int p = numportalgroups - 1; p >= -1; p--)
+	{
+		if (p == MapPortalGroup) continue;
+
+		DVector2 offset = p == -1 ? DVector2(0, 0) : Level->Displacements.getOffset(p, MapPortalGroup);
+
+		// The lines this pass draws.
+		auto inpass = [&](const AMLineInfo &info)
+		{
+			return info.visible && (info.portalgroup == p || (p == -1 && (info.portalgroup == MapPortalGroup || !am_portaloverlay)));
+		};
+
+		if (++lineStamp == 0)
+		{
+			memset(lineStamps.Data(), 0, lineStamps.Size() * sizeof(int));
+			lineStamp = 1;
+		}
+
+		for (auto index : polyLines)
+		{
+			lineStamps[index] = lineStamp;
+			if (inpass(lineCache[index])) addWallLine(Level->lines[index], offset, rotate);
+		}
+
+		int x1 = getLineGridX(left - offset.X);
+		int x2 = getLineGridX(right - offset.X);
+		int y1 = getLineGridY(bottom - offset.Y);
+		int y2 = getLineGridY(top - offset.Y);
+
+		if ((int64_t)(x2 - x1 + 1) * (y2 - y1 + 1) * 2 >= (int64_t)gridWidth * gridHeight)
+		{
+			// Most of the map is in view so just go through all lines.
+			for (auto &line : Level->lines)
+			{
+				int index = line.Index();
+				if (lineStamps[index] != lineStamp && inpass(lineCache[index])) addWallLine(line, offset, rotate);
 			}
-			else if (allmap || (line.flags & ML_REVEALED))
+			continue;
+		}
+
+		for (int by = y1; by <= y2; by++)
+		{
+			for (int bx = x1; bx <= x2; bx++)
 			{
-				if ((line.flags & ML_DONTDRAW) && (am_cheat == 0 || am_cheat >= 4))
+				int cell = by * gridWidth + bx;
+				for (int i = gridStart[cell]; i < gridStart[cell + 1]; i++)
 				{
-					if (!am_showallenabled || CheckCheatmode(false))
-					{
-						continue;
-					}
+					int index = gridLines[i];
+					if (lineStamps[index] == lineStamp) continue;
+					lineStamps[index] = lineStamp;
+					if (inpass(lineCache[index])) addWallLine(Level->lines[index], offset, rotate);
 				}
-				drawMline(&l, AMColors.NotSeenColor);
 			}
 		}
 	}
+
+	if (am_linethickness >= 2)
+	{
+		twod->AddThickLines(lineBatch.Data(), lineBatch.Size(), am_linethickness, uint8_t(am_linealpha * 255));
+	}
+	else
+	{
+		// Use more efficient thin line drawing routine.
+		twod->AddLines(lineBatch.Data(), lineBatch.Size(), uint8_t(am_linealpha * 255));
+	}
 }
 
 
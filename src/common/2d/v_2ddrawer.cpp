@@ -41,6 +41,7 @@
 #include "v_draw.h"
 #include "v_video.h"
 #include "fcolormap.h"
+#include "stats.h"
 
 static F2DDrawer drawer;
 F2DDrawer* twod = &drawer;
@@ -192,11 +193,15 @@ DEFINE_ACTION_FUNCTION_NATIVE(DShape2D, PushTriangle, Shape2D_PushTriangle)
 int F2DDrawer::AddCommand(RenderCommand *data) 
 {
 	data->mScreenFade = screenFade;
-	if (mData.Size() > 0 && data->isCompatible(mData.Last()))
+	mStats.commands++;
+	mStats.vertices += data->mVertCount;
+	mStats.indices += data->mIndexCount;
+	if (mData.Size() > mMergeBarrier && data->isCompatible(mData.Last()))
 	{
 		// Merge with the last command.
 		mData.Last().mIndexCount += data->mIndexCount;
 		mData.Last().mVertCount += data->mVertCount;
+		mStats.merged++;
 		return mData.Size();
 	}
 	else
@@ -1044,6 +1049,83 @@ void F2DDrawer::AddThickLine(int x1, int y1, int x2, int y2, double thickness, u
 	AddCommand(&dg);
 }
 
+//==========================================================================
+//
+// Batched versions of AddLine and AddThickLine. All lines end up in a
+// single command, so callers with thousands of lines do not have to go
+// through AddCommand for each one of them.
+//
+//==========================================================================
+
+void F2DDrawer::AddLines(const TwoDLine *lines, unsigned count, uint8_t alpha)
+{
+	if (count == 0) return;
+
+	RenderCommand dg;
+
+	dg.mType = DrawTypeLines;
+	dg.mRenderStyle = LegacyRenderStyles[STYLE_Translucent];
+	dg.mVertCount = count * 2;
+	dg.mVertIndex = (int)mVertices.Reserve(count * 2);
+	auto ptr = &mVertices[dg.mVertIndex];
+	for (unsigned i = 0; i < count; i++)
+	{
+		PalEntry p = lines[i].color;
+		p.a = alpha;
+		Set(ptr, lines[i].x1, lines[i].y1, 0, 0, 0, p); ptr++;
+		Set(ptr, lines[i].x2, lines[i].y2, 0, 0, 0, p); ptr++;
+	}
+	AddCommand(&dg);
+}
+
+void F2DDrawer::AddThickLines(const TwoDLine *lines, unsigned count, double thickness, uint8_t alpha)
+{
+	if (count == 0) return;
+
+	RenderCommand dg;
+
+	dg.mType = DrawTypeTriangles;
+	dg.mRenderStyle = LegacyRenderStyles[STYLE_Translucent];
+	dg.mVertCount = count * 4;
+	dg.mVertIndex = (int)mVertices.Reserve(count * 4);
+	dg.mIndexIndex = mIndices.Size();
+	dg.mIndexCount = count * 6;
+	auto ptr = &mVertices[dg.mVertIndex];
+	auto index = &mIndices[mIndices.Reserve(count * 6)];
+	for (unsigned i = 0; i < count; i++)
+	{
+		PalEntry p = lines[i].color;
+		p.a = alpha;
+
+		DVector2 point0(lines[i].x1, lines[i].y1);
+		DVector2 point1(lines[i].x2, lines[i].y2);
+
+		DVector2 delta = point1 - point0;
+		DVector2 perp(-delta.Y, delta.X);
+		perp.MakeUnit();
+		perp *= thickness / 2;
+
+		DVector2 corner0 = point0 + perp;
+		DVector2 corner1 = point0 - perp;
+		DVector2 corner2 = point1 + perp;
+		DVector2 corner3 = point1 - perp;
+
+		Set(ptr, corner0.X, corner0.Y, 0, 0, 0, p); ptr++;
+		Set(ptr, corner1.X, corner1.Y, 0, 0, 0, p); ptr++;
+		Set(ptr, corner2.X, corner2.Y, 0, 0, 0, p); ptr++;
+		Set(ptr, corner3.X, corner3.Y, 0, 0, 0, p); ptr++;
+
+		int firstvert = dg.mVertIndex + i * 4;
+		*index++ = firstvert;
+		*index++ = firstvert + 1;
+		*index++ = firstvert + 2;
+		*index++ = firstvert + 1;
+		*index++ = firstvert + 3;
+		*index++ = firstvert + 2;
+	}
+	AddCommand(&dg);
+}
+
 //==========================================================================
 //
 //
@@ -1065,6 +1147,88 @@ void F2DDrawer::AddPixel(int x1, int y1, uint32_t color)
 	AddCommand(&dg);
 }
 
+//==========================================================================
+//
+// Retained lists
+//
+// Everything that gets drawn between BeginRetained and EndRetained is
+// also copied to the list so that AddRetained can repeat it in a later
+// frame. The stored data is in screen coordinates and all lookups have
+// already been done, so this only works as long as the screen size and
+// the draw offset stay the same.
+//
+//==========================================================================
+
+void F2DDrawer::BeginRetained()
+{
+	if (IsRecording()) ThrowAbortException(X_OTHER, "Retained 2D lists cannot be nested");
+
+	mRecordCommand = mData.Size();
+	mRecordVertex = mVertices.Size();
+	mRecordIndex = mIndices.Size();
+	mRecordInvalid = false;
+	// The first recorded command must not be merged into one that is not part of the list.
+	mMergeBarrier = mData.Size();
+}
+
+bool F2DDrawer::EndRetained(RetainedList &list)
+{
+	list.Clear();
+	if (!IsRecording()) return false;
+
+	unsigned firstcommand = mRecordCommand;
+	mRecordCommand = -1;
+	mMergeBarrier = 0;
+
+	if (mRecordInvalid) return false;
+	for (unsigned i = firstcommand; i < mData.Size(); i++)
+	{
+		// Shapes keep their own buffers and cannot be repeated from a copy.
+		if (mData[i].shape2DBufInfo != nullptr) return false;
+	}
+
+	list.mVertices.Resize(mVertices.Size() - mRecordVertex);
+	if (list.mVertices.Size() > 0) memcpy(list.mVertices.Data(), &mVertices[mRecordVertex], list.mVertices.Size() * sizeof(TwoDVertex));
+	list.mIndices.Resize(mIndices.Size() - mRecordIndex);
+	for (unsigned i = 0; i < list.mIndices.Size(); i++)
+	{
+		list.mIndices[i] = mIndices[mRecordIndex + i] - mRecordVertex;
+	}
+	for (unsigned i = firstcommand; i < mData.Size(); i++)
+	{
+		auto &dg = list.mData[list.mData.Push(mData[i])];
+		dg.mVertIndex -= mRecordVertex;
+		dg.mIndexIndex -= mRecordIndex;
+	}
+	list.offset = offset;
+	list.Width = Width;
+	list.Height = Height;
+	list.valid = true;
+	return true;
+}
+
+bool F2DDrawer::AddRetained(const RetainedList &list)
+{
+	if (!list.valid || list.Width != Width || list.Height != Height || list.offset != offset) return false;
+
+	unsigned vertbase = mVertices.Reserve(list.mVertices.Size());
+	if (list.mVertices.Size() > 0) memcpy(&mVertices[vertbase], list.mVertices.Data(), list.mVertices.Size() * sizeof(TwoDVertex));
+	unsigned indexbase = mIndices.Reserve(list.mIndices.Size());
+	for (unsigned i = 0; i < list.mIndices.Size(); i++)
+	{
+		mIndices[indexbase + i] = list.mIndices[i] + vertbase;
+	}
+	for (auto &cmd : list.mData)
+	{
+		RenderCommand dg = cmd;
+		dg.mVertIndex += vertbase;
+		dg.mIndexIndex += indexbase;
+		AddCommand(&dg);
+	}
+	mStats.retained += list.mData.Size();
+	return true;
+}
+
 //==========================================================================
 //
 //
@@ -1079,6 +1243,12 @@ void F2DDrawer::Clear()
 		mIndices.Clear();
 		mData.Clear();
 		mIsFirstPass = true;
+		mMergeBarrier = 0;
+		if (IsRecording())
+		{
+			mRecordCommand = mRecordVertex = mRecordIndex = 0;
+			mRecordInvalid = true;
+		}
 	}
 	screenFade = 1.f;
 }
@@ -1092,6 +1262,80 @@ void F2DDrawer::Clear()
 void F2DDrawer::OnFrameDone()
 {
 	buffersToDestroy.Clear();
+	// A recording cannot span multiple frames.
+	mRecordCommand = -1;
+	mMergeBarrier = 0;
+	mLastStats = mStats;
+	mStats = {};
+}
+
+ADD_STAT(2d)
+{
+	auto &stats = twod->GetLastFrameStats();
+	FString out;
+	out.Format("Commands: %u submitted, %u merged, %u drawn  Vertices: %u  Indices: %u  Retained: %u",
+		stats.commands, stats.merged, stats.commands - stats.merged, stats.vertices, stats.indices, stats.retained);
+	return out;
+}
+
+//==========================================================================
+//
+// DrawList2D script interface
+//
+//==========================================================================
+
+IMPLEMENT_CLASS(DDrawList2D, false, false)
+
+void DDrawList2D::OnDestroy()
+{
+	list.Clear();
+	Super::OnDestroy();
+}
+
+static void DrawList2D_Begin(DDrawList2D *self)
+{
+	twod->BeginRetained();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DDrawList2D, Begin, DrawList2D_Begin)
+{
+	PARAM_SELF_PROLOGUE(DDrawList2D);
+	DrawList2D_Begin(self);
+	return 0;
+}
+
+static int DrawList2D_End(DDrawList2D *self)
+{
+	return twod->EndRetained(self->list);
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DDrawList2D, End, DrawList2D_End)
+{
+	PARAM_SELF_PROLOGUE(DDrawList2D);
+	ACTION_RETURN_BOOL(DrawList2D_End(self));
+}
+
+static int DrawList2D_Draw(DDrawList2D *self)
+{
+	return twod->AddRetained(self->list);
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DDrawList2D, Draw, DrawList2D_Draw)
+{
+	PARAM_SELF_PROLOGUE(DDrawList2D);
+	ACTION_RETURN_BOOL(DrawList2D_Draw(self));
+}
+
+static void DrawList2D_Clear(DDrawList2D *self)
+{
+	self->list.Clear();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DDrawList2D, Clear, DrawList2D_Clear)
+{
+	PARAM_SELF_PROLOGUE(DDrawList2D);
+	DrawList2D_Clear(self);
+	return 0;
 }
 
 F2DVertexBuffer::F2DVertexBuffer()
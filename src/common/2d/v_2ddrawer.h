@@ -102,6 +102,13 @@ public:
 
 	};
 
+	// Input for the batched line functions. Coordinates are in screen space.
+	struct TwoDLine
+	{
+		float x1, y1, x2, y2;
+		PalEntry color;
+	};
+
 	struct RenderCommand
 	{
 		EDrawType mType;
@@ -164,6 +171,35 @@ public:
 		}
 	};
 
+	// The output of a sequence of draw calls, stored so that it can be added again
+	// in later frames without redoing style setup and vertex generation.
+	struct RetainedList
+	{
+		TArray<TwoDVertex> mVertices;
+		TArray<int> mIndices;
+		TArray<RenderCommand> mData;
+		DVector2 offset;
+		int Width = 0, Height = 0;
+		bool valid = false;
+
+		void Clear()
+		{
+			mVertices.Reset();
+			mIndices.Reset();
+			mData.Reset();
+			valid = false;
+		}
+	};
+
+	struct DrawStats
+	{
+		unsigned commands;		// commands passed to AddCommand
+		unsigned merged;		// of those, how many got merged into the previous one
+		unsigned vertices;
+		unsigned indices;
+		unsigned retained;		// commands that came from retained lists
+	};
+
 	TArray<int> mIndices;
 	TArray<TwoDVertex> mVertices;
 	TArray<RenderCommand> mData;
@@ -172,6 +208,16 @@ public:
 	bool locked;	// prevents clearing of the data so it can be reused multiple times (useful for screen fades)
 	float screenFade = 1.f;
 	DVector2 offset;
+
+	// recording state for retained lists
+	int mRecordCommand = -1;
+	unsigned mRecordVertex = 0;
+	unsigned mRecordIndex = 0;
+	unsigned mMergeBarrier = 0;
+	bool mRecordInvalid = false;
+
+	DrawStats mStats = {};
+	DrawStats mLastStats = {};
 public:
 	int fullscreenautoaspect = 3;
 	int cliptop = -1, clipleft = -1, clipwidth = -1, clipheight = -1;
@@ -204,8 +250,16 @@ public:
 
 	void AddLine(double x1, double y1, double x2, double y2, int cx, int cy, int cx2, int cy2, uint32_t color, uint8_t alpha = 255);
 	void AddThickLine(int x1, int y1, int x2, int y2, double thickness, uint32_t color, uint8_t alpha = 255);
+	void AddLines(const TwoDLine *lines, unsigned count, uint8_t alpha = 255);
+	void AddThickLines(const TwoDLine *lines, unsigned count, double thickness, uint8_t alpha = 255);
 	void AddPixel(int x1, int y1, uint32_t color);
 
+	void BeginRetained();
+	bool EndRetained(RetainedList &list);
+	bool AddRetained(const RetainedList &list);
+	bool IsRecording() const { return mRecordCommand >= 0; }
+	const DrawStats &GetLastFrameStats() const { return mLastStats; }
+
 	void Clear();
 	void Lock() { locked = true; }
 	void SetScreenFade(float factor) { screenFade = factor; }
@@ -281,6 +335,21 @@ public:
 	void OnDestroy() override;
 };
 
+//===========================================================================
+// 
+// Script side handle for a retained list
+//
+//===========================================================================
+
+class DDrawList2D : public DObject
+{
+	DECLARE_CLASS(DDrawList2D, DObject)
+public:
+	F2DDrawer::RetainedList list;
+
+	void OnDestroy() override;
+};
+
 
 //===========================================================================
 // 
@@ -34,6 +34,7 @@
 */
 
 #include "v_video.h"
+#include "v_capture.h"
 #include "m_random.h"
 #include "wipe.h"
 
@@ -433,6 +434,7 @@ void PerformWipe(FTexture* startimg, FTexture* endimg, int wipe_type, bool stops
 		if (overlaydrawer) overlaydrawer();
 		twod->End();
 		screen->Update();
+		V_CaptureFrame();
 		twod->OnFrameDone();
 
 	} while (!done);
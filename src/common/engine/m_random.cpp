@@ -255,6 +255,29 @@ void FRandom::Init(uint32_t seed)
 	SFMTObj::Init(NameCRC, seed);
 }
 
+//==========================================================================
+//
+// FRandom :: StaticChecksum
+//
+// Combines the position of every named RNG into a single value for
+// determinism checks. Nameless RNGs do not affect gameplay.
+//
+//==========================================================================
+
+uint32_t FRandom::StaticChecksum ()
+{
+	uint32_t sum = 2166136261u;
+
+	for (FRandom *rng = FRandom::RNGList; rng != NULL; rng = rng->Next)
+	{
+		if (rng->NameCRC != 0)
+		{
+			sum = (sum ^ (rng->NameCRC + uint32_t(rng->Seed()))) * 16777619u;
+		}
+	}
+	return sum;
+}
+
 //==========================================================================
 //
 // FRandom :: StaticWriteRNGState
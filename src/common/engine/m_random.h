@@ -171,6 +171,7 @@ public:
 	static void StaticReadRNGState (FSerializer &arc);
 	static void StaticWriteRNGState (FSerializer &file);
 	static FRandom *StaticFindRNG(const char *name);
+	static uint32_t StaticChecksum();
 
 #ifndef NDEBUG
 	static void StaticPrintSeeds ();
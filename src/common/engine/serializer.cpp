@@ -58,6 +58,7 @@
 
 extern DObject *WP_NOCHANGE;
 bool save_full = false;	// for testing. Should be removed afterward.
+bool FSerializer::IndexedKeyLookup = true;
 
 #include "serializer_internal.h"
 
@@ -329,7 +330,7 @@ void FSerializer::EndObject()
 	}
 	else
 	{
-		r->mObjects.Pop();
+		r->PopObject();
 	}
 }
 
@@ -395,7 +396,7 @@ void FSerializer::EndArray()
 	}
 	else
 	{
-		r->mObjects.Pop();
+		r->PopObject();
 	}
 }
 
@@ -63,6 +63,7 @@ public:
 	FWriter *w = nullptr;
 	FReader *r = nullptr;
 	bool soundNamesAreUnique = false; // While in GZDoom, sound names are unique, that isn't universally true - let the serializer handle both cases with a flag.
+	static bool IndexedKeyLookup;	// only meant to be turned off for comparing load times
 
 	unsigned ArraySize();
 	void WriteKey(const char *key);
@@ -13,6 +13,12 @@ struct FJSONObject
 	rapidjson::Value::MemberIterator mIterator;
 	int mIndex;
 
+	// for keyed reads from larger objects, see FReader::FindKey.
+	unsigned mCursor = 0;		// member expected to be read next
+	unsigned mKeyIndex = 0;		// start of this object's hash table in FReader::mKeyIndex
+	unsigned mKeyMask = 0;		// 0 if no table has been made yet
+	bool mDuplicateKeys = false;
+
 	FJSONObject(rapidjson::Value* v)
 	{
 		mObject = v;
@@ -184,12 +190,105 @@ struct FReader
 	rapidjson::Value *mKeyValue = nullptr;
 	bool mObjectsRead = false;
 
+	// Hash tables of all open objects that needed one. Since objects are
+	// always closed in reverse order these get stacked just like mObjects.
+	TArray<uint32_t> mKeyIndex;
+
+	enum
+	{
+		MIN_INDEXED_MEMBERS = 8		// smaller objects just get scanned
+	};
+
 	FReader(const char *buffer, size_t length)
 	{
 		mDoc.Parse(buffer, length);
 		mObjects.Push(FJSONObject(&mDoc));
 	}
 
+	void PopObject()
+	{
+		if (mObjects.Last().mKeyMask != 0) mKeyIndex.Clamp(mObjects.Last().mKeyIndex);
+		mObjects.Pop();
+	}
+
+	static uint32_t HashKey(const char *key, size_t len)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < len; i++) hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+		return hash;
+	}
+
+	static bool KeyMatches(const rapidjson::Value &name, const char *key, size_t len)
+	{
+		return name.GetStringLength() == len && memcmp(name.GetString(), key, len) == 0;
+	}
+
+	// Builds an open addressing table of member indices. Only the first
+	// occurence of a duplicated key gets in, just like FindMember would return.
+	void BuildKeyIndex(FJSONObject &obj)
+	{
+		unsigned count = obj.mObject->MemberCount();
+		unsigned size = 16;
+		while (size < count * 2) size <<= 1;
+
+		obj.mKeyIndex = mKeyIndex.Reserve(size);
+		obj.mKeyMask = size - 1;
+		memset(&mKeyIndex[obj.mKeyIndex], 0, size * sizeof(uint32_t));
+
+		auto members = obj.mObject->MemberBegin();
+		for (unsigned i = 0; i < count; i++)
+		{
+			auto &name = members[i].name;
+			unsigned slot = HashKey(name.GetString(), name.GetStringLength()) & obj.mKeyMask;
+			while (mKeyIndex[obj.mKeyIndex + slot] != 0)
+			{
+				if (members[mKeyIndex[obj.mKeyIndex + slot] - 1].name == name)
+				{
+					obj.mDuplicateKeys = true;
+					break;
+				}
+				slot = (slot + 1) & obj.mKeyMask;
+			}
+			if (mKeyIndex[obj.mKeyIndex + slot] == 0) mKeyIndex[obj.mKeyIndex + slot] = i + 1;
+		}
+	}
+
+	// Keys mostly get read in the order they were written, so first check
+	// the member after the last one that was found. If that's not it, a hash
+	// table gets used instead of scanning all members, because defaulted
+	// values do not get written and a search for them would always fail.
+	rapidjson::Value *FindMember(FJSONObject &obj, const char *key)
+	{
+		unsigned count = obj.mObject->MemberCount();
+		if (count < MIN_INDEXED_MEMBERS || !FSerializer::IndexedKeyLookup)
+		{
+			auto it = obj.mObject->FindMember(key);
+			if (it == obj.mObject->MemberEnd()) return nullptr;
+			return &it->value;
+		}
+
+		if (obj.mKeyMask == 0) BuildKeyIndex(obj);
+
+		auto members = obj.mObject->MemberBegin();
+		size_t len = strlen(key);
+		if (!obj.mDuplicateKeys && obj.mCursor < count && KeyMatches(members[obj.mCursor].name, key, len))
+		{
+			return &members[obj.mCursor++].value;
+		}
+
+		unsigned slot = HashKey(key, len) & obj.mKeyMask;
+		while (uint32_t entry = mKeyIndex[obj.mKeyIndex + slot])
+		{
+			if (KeyMatches(members[entry - 1].name, key, len))
+			{
+				obj.mCursor = entry;
+				return &members[entry - 1].value;
+			}
+			slot = (slot + 1) & obj.mKeyMask;
+		}
+		return nullptr;
+	}
+
 	rapidjson::Value *FindKey(const char *key)
 	{
 		FJSONObject &obj = mObjects.Last();
@@ -206,9 +305,7 @@ struct FReader
 			else
 			{
 				// Find the given key by name;
-				auto it = obj.mObject->FindMember(key);
-				if (it == obj.mObject->MemberEnd()) return nullptr;
-				return &it->value;
+				return FindMember(obj, key);
 			}
 		}
 		else if (obj.mObject->IsArray() && (unsigned)obj.mIndex < obj.mObject->Size())
@@ -0,0 +1,244 @@
+/*
+** tracezones.cpp
+** Timeline recording of engine phases in the Chrome trace event format
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include "tracezones.h"
+#include "tarray.h"
+#include "zstring.h"
+#include "files.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "version.h"
+
+std::atomic<bool> TraceCapturing;
+
+//==========================================================================
+//
+// Each buffer is only ever written by the thread owning it. The head
+// index is published after the event has been stored, so the capture can
+// be read from the main thread without stopping anyone.
+//
+//==========================================================================
+
+struct FTraceEvent
+{
+	const char *Name;
+	uint64_t Start;
+	uint64_t End;
+};
+
+struct FTraceBuffer
+{
+	enum
+	{
+		SIZE = 1 << 16	// must be a power of 2
+	};
+
+	std::atomic<uint32_t> Head{};
+	uint32_t CaptureStart = 0;
+	int ThreadID = 0;
+	std::atomic<const char *> ThreadName{};
+	FTraceEvent Events[SIZE];
+};
+
+static std::mutex TraceMutex;
+static TArray<FTraceBuffer *> TraceBuffers;
+static TArray<FTraceBuffer *> FreeTraceBuffers;
+static int TraceThreadCount;
+
+static uint64_t TraceStartTime;
+static int TraceFramesLeft;
+static FString TraceFileName;
+
+//==========================================================================
+//
+// Buffers get handed back when their thread exits so that restarting the
+// worker pools does not keep allocating new ones.
+//
+//==========================================================================
+
+struct FTraceThread
+{
+	FTraceBuffer *Buffer = nullptr;
+	const char *Name = nullptr;
+
+	~FTraceThread()
+	{
+		if (Buffer != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(TraceMutex);
+			FreeTraceBuffers.Push(Buffer);
+		}
+	}
+};
+
+static thread_local FTraceThread TraceThread;
+
+static FTraceBuffer *GetTraceBuffer()
+{
+	if (TraceThread.Buffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(TraceMutex);
+		FTraceBuffer *buffer;
+		// A buffer from a thread that ended during a capture still holds part of it.
+		if (FreeTraceBuffers.Size() > 0 && !TraceCapturing.load(std::memory_order_relaxed))
+		{
+			FreeTraceBuffers.Pop(buffer);
+		}
+		else
+		{
+			buffer = new FTraceBuffer;
+			TraceBuffers.Push(buffer);
+		}
+		// Anything left over from a previous owner is not part of this capture.
+		buffer->CaptureStart = buffer->Head.load(std::memory_order_relaxed);
+		buffer->ThreadID = ++TraceThreadCount;
+		buffer->ThreadName = TraceThread.Name;
+		TraceThread.Buffer = buffer;
+	}
+	return TraceThread.Buffer;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+uint64_t Trace_Now()
+{
+	using namespace std::chrono;
+	return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace_Record(const char *name, uint64_t start)
+{
+	auto buffer = GetTraceBuffer();
+	uint32_t head = buffer->Head.load(std::memory_order_relaxed);
+	buffer->Events[head & (FTraceBuffer::SIZE - 1)] = { name, start, Trace_Now() };
+	buffer->Head.store(head + 1, std::memory_order_release);
+}
+
+void Trace_SetThreadName(const char *name)
+{
+	TraceThread.Name = name;
+	if (TraceThread.Buffer != nullptr) TraceThread.Buffer->ThreadName = name;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool WriteTrace(const char *filename)
+{
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(filename));
+	if (fw == nullptr) return false;
+
+	std::lock_guard<std::mutex> lock(TraceMutex);
+	fw->Printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fw->Printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"" GAMENAME "\"}}");
+	for (auto buffer : TraceBuffers)
+	{
+		uint32_t head = buffer->Head.load(std::memory_order_acquire);
+		uint32_t start = buffer->CaptureStart;
+		if (head == start) continue;
+		// If the ring buffer wrapped around, only the newest events are left.
+		if (head - start > FTraceBuffer::SIZE) start = head - FTraceBuffer::SIZE;
+
+		const char *name = buffer->ThreadName;
+		if (name != nullptr)
+			fw->Printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", buffer->ThreadID, name);
+		else
+			fw->Printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}", buffer->ThreadID, buffer->ThreadID);
+
+		for (uint32_t i = start; i != head; i++)
+		{
+			auto &ev = buffer->Events[i & (FTraceBuffer::SIZE - 1)];
+			if (ev.Start < TraceStartTime) continue;
+			fw->Printf(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				ev.Name, buffer->ThreadID, (ev.Start - TraceStartTime) / 1000., (ev.End - ev.Start) / 1000.);
+		}
+	}
+	fw->Printf("\n]}\n");
+	return true;
+}
+
+static void StartTrace(int frames, const char *filename)
+{
+	std::lock_guard<std::mutex> lock(TraceMutex);
+	for (auto buffer : TraceBuffers)
+	{
+		buffer->CaptureStart = buffer->Head.load(std::memory_order_acquire);
+	}
+	TraceFramesLeft = frames;
+	TraceFileName = filename;
+	TraceStartTime = Trace_Now();
+	TraceCapturing = true;
+}
+
+//==========================================================================
+//
+// Must be called once per frame from the main loop.
+//
+//==========================================================================
+
+void Trace_EndFrame()
+{
+	if (!TraceCapturing.load(std::memory_order_relaxed) || --TraceFramesLeft > 0) return;
+
+	TraceCapturing = false;
+	if (WriteTrace(TraceFileName.GetChars())) Printf("Trace written to %s\n", TraceFileName.GetChars());
+	else Printf("Could not write %s\n", TraceFileName.GetChars());
+}
+
+CCMD(tracecapture)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: tracecapture <frames> [file]\n"
+			"Records the engine's main phases on all threads and writes them in the Chrome trace event format.\n");
+		return;
+	}
+	if (TraceCapturing)
+	{
+		Printf("A capture is already running\n");
+		return;
+	}
+	Trace_SetThreadName("Main thread");
+	StartTrace(max(1, atoi(argv[1])), argv.argc() > 2 ? argv[2] : "trace.json");
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+//============================================================================
+//
+// Timeline recording of the engine's main phases.
+//
+// Zones are only recorded while a capture started by the 'tracecapture'
+// console command is running. Every thread writes into its own ring
+// buffer without taking any locks, and at the end of the capture all
+// buffers are written to a file in the Chrome trace event format, which
+// chrome://tracing and Perfetto can open.
+//
+// Zone names must be string literals, only the pointer is stored.
+//
+//============================================================================
+
+extern std::atomic<bool> TraceCapturing;
+
+uint64_t Trace_Now();
+void Trace_Record(const char *name, uint64_t start);
+void Trace_SetThreadName(const char *name);
+void Trace_EndFrame();
+
+class FTraceZone
+{
+	const char *Name;
+	uint64_t Start;
+
+public:
+	FTraceZone(const char *name) : Name(name), Start(TraceCapturing.load(std::memory_order_relaxed) ? Trace_Now() : 0) {}
+	~FTraceZone()
+	{
+		if (Start != 0) Trace_Record(Name, Start);
+	}
+};
+
+#define TRACE_ZONE_CONCAT2(a, b) a##b
+#define TRACE_ZONE_CONCAT(a, b) TRACE_ZONE_CONCAT2(a, b)
+#define TRACE_ZONE(name) FTraceZone TRACE_ZONE_CONCAT(tracezone_, __LINE__)(name)
@@ -0,0 +1,340 @@
+/*
+** file_indexcache.cpp
+** On-disk cache for parsed archive directories
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <time.h>
+#include <algorithm>
+#include "file_indexcache.h"
+#include "files.h"
+#include "cmdlib.h"
+
+FArchiveIndexCache ArchiveIndexCache;
+
+static const char IndexCacheMagic[4] = { 'Z', 'I', 'D', 'X' };
+static const uint32_t IndexCacheVersion = 1;
+static const int64_t LastUseInterval = 24 * 60 * 60;	// in seconds
+
+static thread_local bool CacheEnabled;
+
+//==========================================================================
+//
+// Only archives opened by FileSystem::AddFile use the cache. Savegames and
+// other files that are opened on their own should not end up in it.
+//
+//==========================================================================
+
+FArchiveIndexCache::Enabler::Enabler()
+{
+	Previous = CacheEnabled;
+	CacheEnabled = true;
+}
+
+FArchiveIndexCache::Enabler::~Enabler()
+{
+	CacheEnabled = Previous;
+}
+
+//==========================================================================
+//
+// Sets the file the cache gets loaded from and written to.
+// An empty name disables the cache.
+//
+//==========================================================================
+
+void FArchiveIndexCache::SetFile(const char *filename)
+{
+	if (FileName.Compare(filename) == 0) return;
+	Flush();
+	Archives.Clear();
+	FileName = filename;
+	Loaded = false;
+	Dirty = false;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FArchiveIndexCache::GetFileKey(const char *archive, FArchiveIndexKey &key)
+{
+	if (FileName.IsEmpty() || !CacheEnabled) return false;
+
+	size_t size;
+	time_t time;
+	if (!GetFileInfo(archive, &size, &time)) return false;	// not a real file, e.g. an archive inside another one.
+	key.FileSize = (int64_t)size;
+	key.FileTime = (int64_t)time;
+	return true;
+}
+
+//==========================================================================
+//
+// The returned array is only valid until the next call to Store.
+//
+//==========================================================================
+
+const TArray<FArchiveIndexEntry> *FArchiveIndexCache::Find(const char *archive, const FArchiveIndexKey &key)
+{
+	if (FileName.IsEmpty()) return nullptr;
+	if (!Loaded) Load();
+
+	auto entry = Archives.CheckKey(archive);
+	if (entry == nullptr || !(entry->Key == key))
+	{
+		Misses++;
+		return nullptr;
+	}
+	// LastUse only decides which archives get dropped when the cache is full,
+	// so it is not worth rewriting the file for every launch.
+	int64_t now = (int64_t)time(nullptr);
+	if (now - entry->LastUse >= LastUseInterval)
+	{
+		entry->LastUse = now;
+		Dirty = true;
+	}
+	Hits++;
+	return &entry->Entries;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FArchiveIndexCache::Store(const char *archive, const FArchiveIndexKey &key, TArray<FArchiveIndexEntry> &&entries)
+{
+	if (FileName.IsEmpty()) return;
+	if (!Loaded) Load();
+
+	auto &entry = Archives[archive];
+	entry.Key = key;
+	entry.LastUse = (int64_t)time(nullptr);
+	entry.Entries = std::move(entries);
+	Dirty = true;
+}
+
+//==========================================================================
+//
+// Any problem with the file just discards the entire cache.
+//
+//==========================================================================
+
+namespace
+{
+	struct IndexReader
+	{
+		const uint8_t *p, *end;
+		bool ok = true;
+
+		bool Get(void *dest, size_t len)
+		{
+			if (!ok || size_t(end - p) < len) return ok = false;
+			memcpy(dest, p, len);
+			p += len;
+			return true;
+		}
+		template<class T> T Get()
+		{
+			T v = 0;
+			Get(&v, sizeof(v));
+			return v;
+		}
+		FString GetString()
+		{
+			uint32_t len = Get<uint32_t>();
+			if (!ok || size_t(end - p) < len) { ok = false; return FString(); }
+			FString str((const char *)p, len);
+			p += len;
+			return str;
+		}
+	};
+
+	struct IndexWriter
+	{
+		TArray<uint8_t> buffer;
+
+		void Put(const void *src, size_t len)
+		{
+			if (len == 0) return;
+			unsigned pos = buffer.Reserve((unsigned)len);
+			memcpy(&buffer[pos], src, len);
+		}
+		template<class T> void Put(T v)
+		{
+			Put(&v, sizeof(v));
+		}
+		void PutString(const FString &str)
+		{
+			Put<uint32_t>((uint32_t)str.Len());
+			Put(str.GetChars(), str.Len());
+		}
+	};
+}
+
+void FArchiveIndexCache::Load()
+{
+	Loaded = true;
+
+	FileReader fr;
+	if (!fr.OpenFile(FileName)) return;
+	auto data = fr.Read();
+	if (data.Size() < 12 || memcmp(data.Data(), IndexCacheMagic, 4) != 0) return;
+
+	IndexReader rd = { data.Data() + 4, data.Data() + data.Size() };
+	if (rd.Get<uint32_t>() != IndexCacheVersion) return;
+	uint32_t count = rd.Get<uint32_t>();
+
+	for (uint32_t i = 0; i < count && rd.ok; i++)
+	{
+		FString name = rd.GetString();
+		Archive archive;
+		archive.Key.FileSize = rd.Get<int64_t>();
+		archive.Key.FileTime = rd.Get<int64_t>();
+		archive.Key.DirectoryOffset = rd.Get<uint64_t>();
+		archive.Key.DirectorySize = rd.Get<uint64_t>();
+		archive.Key.NumEntries = rd.Get<uint32_t>();
+		archive.LastUse = rd.Get<int64_t>();
+		uint32_t numentries = rd.Get<uint32_t>();
+		if (!rd.ok || numentries > size_t(rd.end - rd.p)) break;
+		archive.Entries.Resize(numentries);
+		for (auto &e : archive.Entries)
+		{
+			e.Name = rd.GetString();
+			e.Position = rd.Get<uint64_t>();
+			e.CompressedSize = rd.Get<uint32_t>();
+			e.UncompressedSize = rd.Get<uint32_t>();
+			e.CRC32 = rd.Get<uint32_t>();
+			e.Method = rd.Get<uint16_t>();
+			e.Flags = rd.Get<uint16_t>();
+			e.TooLarge = !!rd.Get<uint8_t>();
+		}
+		// The archive code takes NumEntries entries from a matching record without checking.
+		if (rd.ok && numentries == archive.Key.NumEntries) Archives[name] = std::move(archive);
+	}
+	if (!rd.ok || rd.p != rd.end)
+	{
+		Archives.Clear();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void RemoveIndexFile(const char *name)
+{
+#ifndef _WIN32
+	remove(name);
+#else
+	_wremove(WideString(name).c_str());
+#endif
+}
+
+static bool ReplaceIndexFile(const char *from, const char *to)
+{
+#ifndef _WIN32
+	return rename(from, to) == 0;
+#else
+	// rename does not replace an existing file on Windows.
+	RemoveIndexFile(to);
+	return _wrename(WideString(from).c_str(), WideString(to).c_str()) == 0;
+#endif
+}
+
+//==========================================================================
+//
+// Writes the cache back if anything changed. Only the most recently used
+// archives are kept. The data goes to a temporary file first so that an
+// interrupted write cannot leave a truncated cache behind.
+//
+//==========================================================================
+
+void FArchiveIndexCache::Flush()
+{
+	if (!Dirty || FileName.IsEmpty()) return;
+	Dirty = false;
+
+	TArray<TMap<FString, Archive>::Pair *> list;
+	TMap<FString, Archive>::Iterator it(Archives);
+	TMap<FString, Archive>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		list.Push(pair);
+	}
+	std::sort(list.begin(), list.end(), [](const auto *a, const auto *b) { return a->Value.LastUse > b->Value.LastUse; });
+	if (list.Size() > MAX_ARCHIVES) list.Clamp(MAX_ARCHIVES);
+
+	IndexWriter wr;
+	wr.Put(IndexCacheMagic, 4);
+	wr.Put<uint32_t>(IndexCacheVersion);
+	wr.Put<uint32_t>(list.Size());
+	for (auto p : list)
+	{
+		wr.PutString(p->Key);
+		wr.Put<int64_t>(p->Value.Key.FileSize);
+		wr.Put<int64_t>(p->Value.Key.FileTime);
+		wr.Put<uint64_t>(p->Value.Key.DirectoryOffset);
+		wr.Put<uint64_t>(p->Value.Key.DirectorySize);
+		wr.Put<uint32_t>(p->Value.Key.NumEntries);
+		wr.Put<int64_t>(p->Value.LastUse);
+		wr.Put<uint32_t>(p->Value.Entries.Size());
+		for (auto &e : p->Value.Entries)
+		{
+			wr.PutString(e.Name);
+			wr.Put<uint64_t>(e.Position);
+			wr.Put<uint32_t>(e.CompressedSize);
+			wr.Put<uint32_t>(e.UncompressedSize);
+			wr.Put<uint32_t>(e.CRC32);
+			wr.Put<uint16_t>(e.Method);
+			wr.Put<uint16_t>(e.Flags);
+			wr.Put<uint8_t>(e.TooLarge);
+		}
+	}
+
+	FString tempname = FileName + ".tmp";
+	auto fw = FileWriter::Open(tempname);
+	if (fw != nullptr)
+	{
+		bool ok = fw->Write(wr.buffer.Data(), wr.buffer.Size()) == wr.buffer.Size();
+		delete fw;
+		if (!ok || !ReplaceIndexFile(tempname, FileName))
+		{
+			RemoveIndexFile(tempname);
+		}
+	}
+}
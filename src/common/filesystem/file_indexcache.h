@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include "tarray.h"
+#include "zstring.h"
+
+//==========================================================================
+//
+// On-disk cache of parsed archive directories.
+//
+// Entries are keyed by the archive's path, size and modification time and
+// the location of its directory inside the file. If all of these match, the
+// stored entries are used instead of reading and parsing the directory.
+// The entries are stored as read from the file, before any name remapping
+// or filtering, so they do not depend on the game being played.
+//
+//==========================================================================
+
+struct FArchiveIndexEntry
+{
+	FString Name;
+	uint64_t Position;
+	uint32_t CompressedSize;
+	uint32_t UncompressedSize;
+	uint32_t CRC32;
+	uint16_t Method;
+	uint16_t Flags;
+	bool TooLarge;
+};
+
+struct FArchiveIndexKey
+{
+	int64_t FileSize;
+	int64_t FileTime;
+	uint64_t DirectoryOffset;
+	uint64_t DirectorySize;
+	uint32_t NumEntries;
+
+	bool operator==(const FArchiveIndexKey &other) const
+	{
+		return FileSize == other.FileSize && FileTime == other.FileTime && DirectoryOffset == other.DirectoryOffset &&
+			DirectorySize == other.DirectorySize && NumEntries == other.NumEntries;
+	}
+};
+
+class FArchiveIndexCache
+{
+public:
+	void SetFile(const char *filename);
+	void Flush();
+
+	const TArray<FArchiveIndexEntry> *Find(const char *archive, const FArchiveIndexKey &key);
+	void Store(const char *archive, const FArchiveIndexKey &key, TArray<FArchiveIndexEntry> &&entries);
+	bool GetFileKey(const char *archive, FArchiveIndexKey &key);
+
+	// Archives only use the cache while one of these exists on the opening thread.
+	struct Enabler
+	{
+		Enabler();
+		~Enabler();
+		bool Previous;
+	};
+
+	unsigned Hits = 0;
+	unsigned Misses = 0;
+
+private:
+	struct Archive
+	{
+		FArchiveIndexKey Key;
+		int64_t LastUse;
+		TArray<FArchiveIndexEntry> Entries;
+	};
+
+	enum
+	{
+		MAX_ARCHIVES = 1024
+	};
+
+	FString FileName;
+	TMap<FString, Archive> Archives;
+	bool Loaded = false;
+	bool Dirty = false;
+
+	void Load();
+};
+
+extern FArchiveIndexCache ArchiveIndexCache;
@@ -35,6 +35,7 @@
 
 #include <time.h>
 #include "file_zip.h"
+#include "file_indexcache.h"
 #include "cmdlib.h"
 
 #include "printf.h"
@@ -67,7 +68,7 @@ static bool UncompressZipLump(char *Cache, FileReader &Reader, int Method, int L
 		case METHOD_LZMA:
 		{
 			FileReader frz;
-			if (frz.OpenDecompressor(Reader, LumpSize, Method, false, [](const char* err) { I_Error("%s", err); }))
+			if (frz.OpenDecompressor(Reader, LumpSize, Method, false, [](const char* err) { I_Error("%s", err); }, CompressedSize))
 			{
 				frz.Read(Cache, LumpSize);
 			}
@@ -226,14 +227,19 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 		dirsize = info.DirectorySize;
 		DirectoryOffset = info.DirectoryOffset;
 	}
-	Lumps = new FZipLump[NumLumps];
+	FArchiveIndexKey key = { 0, 0, DirectoryOffset, dirsize, NumLumps };
+	bool cacheable = ArchiveIndexCache.GetFileKey(FileName, key);
+	const TArray<FArchiveIndexEntry> *entries = cacheable ? ArchiveIndexCache.Find(FileName, key) : nullptr;
+	TArray<FArchiveIndexEntry> parsed;
 
-	// Load the entire central directory. Too bad that this contains variable length entries...
-	void *directory = malloc(dirsize);
-	Reader.Seek(DirectoryOffset, FileReader::SeekSet);
-	Reader.Read(directory, dirsize);
+	if (entries == nullptr)
+	{
+		if (!ReadCentralDirectory(parsed, DirectoryOffset, dirsize, quiet)) return false;
+		entries = &parsed;
+	}
+	assert(entries->Size() == NumLumps);
 
-	char *dirptr = (char*)directory;
+	Lumps = new FZipLump[NumLumps];
 	FZipLump *lump_p = Lumps;
 
 	FString name0, name1;
@@ -244,22 +250,7 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 	// This will only be done if there is either a MAPINFO, ZMAPINFO or GAMEINFO lump in the subdirectory, denoting a ZDoom mod.
 	if (NumLumps > 1) for (uint32_t i = 0; i < NumLumps; i++)
 	{
-		FZipCentralDirectoryInfo *zip_fh = (FZipCentralDirectoryInfo *)dirptr;
-
-		int len = LittleShort(zip_fh->NameLength);
-		FString name(dirptr + sizeof(FZipCentralDirectoryInfo), len);
-
-		dirptr += sizeof(FZipCentralDirectoryInfo) +
-			LittleShort(zip_fh->NameLength) +
-			LittleShort(zip_fh->ExtraLength) +
-			LittleShort(zip_fh->CommentLength);
-
-		if (dirptr > ((char*)directory) + dirsize)	// This directory entry goes beyond the end of the file.
-		{
-			free(directory);
-			if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
-			return false;
-		}
+		FString name = (*entries)[i].Name;
 
 		name.ToLower();
 		if (name.IndexOf("filter/") == 0)
@@ -305,25 +296,10 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 	// If it ran through the list without finding anything it should not attempt any path remapping.
 	if (!foundspeciallump) name0 = "";
 
-	dirptr = (char*)directory;
-	lump_p = Lumps;
 	for (uint32_t i = 0; i < NumLumps; i++)
 	{
-		FZipCentralDirectoryInfo *zip_fh = (FZipCentralDirectoryInfo *)dirptr;
-
-		int len = LittleShort(zip_fh->NameLength);
-		FString name(dirptr + sizeof(FZipCentralDirectoryInfo), len);
-		dirptr += sizeof(FZipCentralDirectoryInfo) + 
-				  LittleShort(zip_fh->NameLength) + 
-				  LittleShort(zip_fh->ExtraLength) + 
-				  LittleShort(zip_fh->CommentLength);
-
-		if (dirptr > ((char*)directory) + dirsize)	// This directory entry goes beyond the end of the file.
-		{
-			free(directory);
-			if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
-			return false;
-		}
+		auto &entry = (*entries)[i];
+		FString name = entry.Name;
 
 		if (name.IndexOf("__macosx") == 0 || name.IndexOf("__MACOSX") == 0)
 		{
@@ -333,40 +309,114 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 		if (name0.IsNotEmpty()) name = name.Mid(name0.Len());
 
 		// skip Directories
-		if (name.IsEmpty() || (name.Back() == '/' && LittleLong(zip_fh->UncompressedSize32) == 0))
+		if (name.IsEmpty() || (name.Back() == '/' && entry.UncompressedSize == 0))
 		{
 			skipped++;
 			continue;
 		}
 
 		// Ignore unknown compression formats
-		zip_fh->Method = LittleShort(zip_fh->Method);
-		if (zip_fh->Method != METHOD_STORED &&
-			zip_fh->Method != METHOD_DEFLATE &&
-			zip_fh->Method != METHOD_LZMA &&
-			zip_fh->Method != METHOD_BZIP2 &&
-			zip_fh->Method != METHOD_IMPLODE &&
-			zip_fh->Method != METHOD_SHRINK)
+		if (entry.Method != METHOD_STORED &&
+			entry.Method != METHOD_DEFLATE &&
+			entry.Method != METHOD_LZMA &&
+			entry.Method != METHOD_BZIP2 &&
+			entry.Method != METHOD_IMPLODE &&
+			entry.Method != METHOD_SHRINK)
 		{
-			if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' uses an unsupported compression algorithm (#%d).\n", FileName.GetChars(), name.GetChars(), zip_fh->Method);
+			if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' uses an unsupported compression algorithm (#%d).\n", FileName.GetChars(), name.GetChars(), entry.Method);
 			skipped++;
 			continue;
 		}
 		// Also ignore encrypted entries
-		zip_fh->Flags = LittleShort(zip_fh->Flags);
-		if (zip_fh->Flags & ZF_ENCRYPTED)
+		if (entry.Flags & ZF_ENCRYPTED)
 		{
 			if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' is encrypted. Encryption is not supported.\n", FileName.GetChars(), name.GetChars());
 			skipped++;
 			continue;
 		}
+		if (entry.TooLarge)
+		{
+			// The file system is limited to 32 bit file sizes;
+			if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' is too large.\n", FileName.GetChars(), name.GetChars());
+			skipped++;
+			continue;
+		}
 
 		FixPathSeperator(name);
 		name.ToLower();
-		
-		uint32_t UncompressedSize =LittleLong(zip_fh->UncompressedSize32);
-		uint32_t CompressedSize = LittleLong(zip_fh->CompressedSize32);
-		uint64_t LocalHeaderOffset = LittleLong(zip_fh->LocalHeaderOffset32);
+
+		lump_p->LumpNameSetup(name);
+		lump_p->LumpSize = entry.UncompressedSize;
+		lump_p->Owner = this;
+		// The start of the Reader will be determined the first time it is accessed.
+		lump_p->Flags = LUMPF_FULLPATH;
+		lump_p->NeedFileStart = true;
+		lump_p->Method = uint8_t(entry.Method);
+		if (lump_p->Method != METHOD_STORED) lump_p->Flags |= LUMPF_COMPRESSED;
+		lump_p->GPFlags = entry.Flags;
+		lump_p->CRC32 = entry.CRC32;
+		lump_p->CompressedSize = entry.CompressedSize;
+		lump_p->Position = entry.Position;
+		lump_p->CheckEmbedded(filter);
+
+		lump_p++;
+	}
+	// Resize the lump record array to its actual size
+	NumLumps -= skipped;
+
+	if (entries == &parsed && cacheable)
+	{
+		ArchiveIndexCache.Store(FileName, key, std::move(parsed));
+	}
+
+	GenerateHash();
+	PostProcessArchive(&Lumps[0], sizeof(FZipLump), filter);
+	return true;
+}
+
+//==========================================================================
+//
+// Reads the central directory into a list of entries. No filtering or
+// name processing is done here so that the result can be cached.
+//
+//==========================================================================
+
+bool FZipFile::ReadCentralDirectory(TArray<FArchiveIndexEntry> &entries, uint64_t DirectoryOffset, uint64_t dirsize, bool quiet)
+{
+	// Load the entire central directory. Too bad that this contains variable length entries...
+	void *directory = malloc(dirsize);
+	Reader.Seek(DirectoryOffset, FileReader::SeekSet);
+	Reader.Read(directory, dirsize);
+
+	char *dirptr = (char*)directory;
+	entries.Resize(NumLumps);
+
+	for (uint32_t i = 0; i < NumLumps; i++)
+	{
+		FZipCentralDirectoryInfo *zip_fh = (FZipCentralDirectoryInfo *)dirptr;
+		auto &entry = entries[i];
+
+		int len = LittleShort(zip_fh->NameLength);
+		entry.Name = FString(dirptr + sizeof(FZipCentralDirectoryInfo), len);
+		dirptr += sizeof(FZipCentralDirectoryInfo) + 
+				  LittleShort(zip_fh->NameLength) + 
+				  LittleShort(zip_fh->ExtraLength) + 
+				  LittleShort(zip_fh->CommentLength);
+
+		if (dirptr > ((char*)directory) + dirsize)	// This directory entry goes beyond the end of the file.
+		{
+			free(directory);
+			if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Central directory corrupted.", FileName.GetChars());
+			return false;
+		}
+
+		entry.Method = LittleShort(zip_fh->Method);
+		entry.Flags = LittleShort(zip_fh->Flags);
+		entry.CRC32 = zip_fh->CRC32;
+		entry.UncompressedSize = LittleLong(zip_fh->UncompressedSize32);
+		entry.CompressedSize = LittleLong(zip_fh->CompressedSize32);
+		entry.Position = LittleLong(zip_fh->LocalHeaderOffset32);
+		entry.TooLarge = false;
 		if (zip_fh->ExtraLength > 0)
 		{
 			uint8_t* rawext = (uint8_t*)zip_fh + sizeof(*zip_fh) + zip_fh->NameLength;
@@ -382,40 +432,17 @@ bool FZipFile::Open(bool quiet, LumpFilterInfo* filter)
 				{
 					if (zip_64->CompressedSize > 0x7fffffff || zip_64->UncompressedSize > 0x7fffffff)
 					{
-						// The file system is limited to 32 bit file sizes;
-						if (!quiet) Printf(TEXTCOLOR_YELLOW "\n%s: '%s' is too large.\n", FileName.GetChars(), name.GetChars());
-						skipped++;
+						entry.TooLarge = true;
 						continue;
 					}
-					UncompressedSize = (uint32_t)zip_64->UncompressedSize;
-					CompressedSize = (uint32_t)zip_64->CompressedSize;
-					LocalHeaderOffset = zip_64->LocalHeaderOffset;
+					entry.UncompressedSize = (uint32_t)zip_64->UncompressedSize;
+					entry.CompressedSize = (uint32_t)zip_64->CompressedSize;
+					entry.Position = zip_64->LocalHeaderOffset;
 				}
 			}
 		}
-
-		lump_p->LumpNameSetup(name);
-		lump_p->LumpSize = UncompressedSize;
-		lump_p->Owner = this;
-		// The start of the Reader will be determined the first time it is accessed.
-		lump_p->Flags = LUMPF_FULLPATH;
-		lump_p->NeedFileStart = true;
-		lump_p->Method = uint8_t(zip_fh->Method);
-		if (lump_p->Method != METHOD_STORED) lump_p->Flags |= LUMPF_COMPRESSED;
-		lump_p->GPFlags = zip_fh->Flags;
-		lump_p->CRC32 = zip_fh->CRC32;
-		lump_p->CompressedSize = CompressedSize;
-		lump_p->Position = LocalHeaderOffset;
-		lump_p->CheckEmbedded(filter);
-
-		lump_p++;
 	}
-	// Resize the lump record array to its actual size
-	NumLumps -= skipped;
 	free(directory);
-
-	GenerateHash();
-	PostProcessArchive(&Lumps[0], sizeof(FZipLump), filter);
 	return true;
 }
 
@@ -3,6 +3,8 @@
 
 #include "resourcefile.h"
 
+struct FArchiveIndexEntry;
+
 //==========================================================================
 //
 // Zip Lump
@@ -38,6 +40,8 @@ class FZipFile : public FResourceFile
 {
 	FZipLump *Lumps;
 
+	bool ReadCentralDirectory(TArray<FArchiveIndexEntry> &entries, uint64_t DirectoryOffset, uint64_t dirsize, bool quiet);
+
 public:
 	FZipFile(const char * filename, FileReader &file);
 	virtual ~FZipFile();
@@ -43,6 +43,7 @@
 #include "m_argv.h"
 #include "cmdlib.h"
 #include "filesystem.h"
+#include "file_indexcache.h"
 #include "m_crc32.h"
 #include "printf.h"
 #include "md5.h"
@@ -173,6 +174,9 @@ FileSystem::~FileSystem ()
 void FileSystem::DeleteAll ()
 {
 	Hashes.Clear();
+	ShortNameIndex.Clear();
+	FullNameIndex.Clear();
+	NoExtIndex.Clear();
 	NumEntries = 0;
 
 	// explicitly delete all manually added lumps.
@@ -249,6 +253,9 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 
 	// [RH] Set up hash table
 	InitHashChains ();
+
+	// Store the directories of all newly parsed archives.
+	ArchiveIndexCache.Flush();
 }
 
 //==========================================================================
@@ -329,7 +336,7 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 
 		if (!isdir)
 		{
-			if (!filereader.OpenFile(filename))
+			if (MapFiles ? !filereader.OpenMappedFile(filename) : !filereader.OpenFile(filename))
 			{ // Didn't find file
 				if (!quiet)
 				{
@@ -348,7 +355,10 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 	FResourceFile *resfile;
 
 	if (!isdir)
+	{
+		FArchiveIndexCache::Enabler useindexcache;
 		resfile = FResourceFile::OpenResourceFile(filename, filereader, quiet, false, filter);
+	}
 	else
 		resfile = FResourceFile::OpenDirectory(filename, quiet, filter);
 
@@ -467,6 +477,74 @@ int FileSystem::CheckIfResourceFileLoaded (const char *name) noexcept
 	return -1;
 }
 
+//==========================================================================
+//
+// Lump name index
+//
+// Flat open addressing tables with one slot per distinct name. A slot
+// points to the last lump with its name and the other lumps with the
+// same name are linked from there in descending order. This searches the
+// lumps in the same order the old hash chains did but never has to step
+// over lumps with different names.
+//
+//==========================================================================
+
+static inline uint32_t ShortNameHash(uint64_t name)
+{
+	return uint32_t((name * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static uint32_t IndexTableSize(uint32_t count)
+{
+	uint32_t size = 16;
+	while (size < count * 2) size <<= 1;
+	return size;
+}
+
+// Returns the length of the name without its extension.
+static size_t NoExtLength(const FString &name)
+{
+	auto dot = name.LastIndexOf('.');
+	auto slash = name.LastIndexOf('/');
+	return dot > slash ? dot : name.Len();
+}
+
+uint32_t FileSystem::FindShortName(uint64_t name) const
+{
+	if (ShortNameIndex.Size() == 0) return NULL_INDEX;
+
+	uint32_t mask = ShortNameIndex.Size() - 1;
+	for (uint32_t slot = ShortNameHash(name) & mask; ShortNameIndex[slot].first != NULL_INDEX; slot = (slot + 1) & mask)
+	{
+		if (ShortNameIndex[slot].name == name) return ShortNameIndex[slot].first;
+	}
+	return NULL_INDEX;
+}
+
+uint32_t FileSystem::FindFullName(const char *name, bool noext) const
+{
+	auto &table = noext ? NoExtIndex : FullNameIndex;
+	if (table.Size() == 0) return NULL_INDEX;
+
+	size_t len = strlen(name);
+	uint32_t hash = MakeKey(name, len);
+	uint32_t mask = table.Size() - 1;
+	for (uint32_t slot = hash & mask; table[slot].first != NULL_INDEX; slot = (slot + 1) & mask)
+	{
+		if (table[slot].hash != hash) continue;
+		uint32_t i = table[slot].first;
+		if (noext)
+		{
+			if (NoExtLen[i] == len && !strnicmp(name, FileInfo[i].longName, len)) return i;
+		}
+		else
+		{
+			if (!stricmp(name, FileInfo[i].longName)) return i;
+		}
+	}
+	return NULL_INDEX;
+}
+
 //==========================================================================
 //
 // CheckNumForName
@@ -500,24 +578,19 @@ int FileSystem::CheckNumForName (const char *name, int space)
 	}
 
 	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumEntries];
 
-	while (i != NULL_INDEX)
+	// All lumps in this list have the requested name, only the namespace needs to be checked.
+	for (i = FindShortName(qname); i != NULL_INDEX; i = NextLumpIndex[i])
 	{
-
-		if (FileInfo[i].shortName.qword == qname)
-		{
-			auto &lump = FileInfo[i];
-			if (lump.Namespace == space) break;
-			// If the lump is from one of the special namespaces exclusive to Zips
-			// the check has to be done differently:
-			// If we find a lump with this name in the global namespace that does not come
-			// from a Zip return that. WADs don't know these namespaces and single lumps must
-			// work as well.
-			if (space > ns_specialzipdirectory && lump.Namespace == ns_global && 
-				!((lump.lump->Flags ^lump.flags) & LUMPF_FULLPATH)) break;
-		}
-		i = NextLumpIndex[i];
+		auto &lump = FileInfo[i];
+		if (lump.Namespace == space) break;
+		// If the lump is from one of the special namespaces exclusive to Zips
+		// the check has to be done differently:
+		// If we find a lump with this name in the global namespace that does not come
+		// from a Zip return that. WADs don't know these namespaces and single lumps must
+		// work as well.
+		if (space > ns_specialzipdirectory && lump.Namespace == ns_global && 
+			!((lump.lump->Flags ^lump.flags) & LUMPF_FULLPATH)) break;
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -538,16 +611,13 @@ int FileSystem::CheckNumForName (const char *name, int space, int rfnum, bool ex
 	}
 
 	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumEntries];
 
 	// If exact is true if will only find lumps in the same WAD, otherwise
 	// also those in earlier WADs.
 
-	while (i != NULL_INDEX &&
-		(FileInfo[i].shortName.qword != qname || FileInfo[i].Namespace != space ||
-		 (exact? (FileInfo[i].rfnum != rfnum) : (FileInfo[i].rfnum > rfnum)) ))
+	for (i = FindShortName(qname); i != NULL_INDEX; i = NextLumpIndex[i])
 	{
-		i = NextLumpIndex[i];
+		if (FileInfo[i].Namespace == space && (exact ? (FileInfo[i].rfnum == rfnum) : (FileInfo[i].rfnum <= rfnum))) break;
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -593,21 +663,9 @@ int FileSystem::CheckNumForFullName (const char *name, bool trynormal, int names
 		return -1;
 	}
 	if (*name == '/') name++;	// ignore leading slashes in file names.
-	uint32_t *fli = ignoreext ? FirstLumpIndex_NoExt : FirstLumpIndex_FullName;
-	uint32_t *nli = ignoreext ? NextLumpIndex_NoExt : NextLumpIndex_FullName;
-	auto len = strlen(name);
-
-	for (i = fli[MakeKey(name) % NumEntries]; i != NULL_INDEX; i = nli[i])
-	{
-		if (strnicmp(name, FileInfo[i].longName, len)) continue;
-		if (FileInfo[i].longName[len] == 0) break;	// this is a full match
-		if (ignoreext && FileInfo[i].longName[len] == '.') 
-		{
-			// is this the last '.' in the last path element, indicating that the remaining part of the name is only an extension?
-			if (strpbrk(FileInfo[i].longName.GetChars() + len + 1, "./") == nullptr) break;	
-		}
-	}
 
+	// With ignoreext, every lump whose name without extension matches is a hit.
+	i = FindFullName(name, ignoreext);
 	if (i != NULL_INDEX) return i;
 
 	if (trynormal && strlen(name) <= 8 && !strpbrk(name, "./"))
@@ -626,10 +684,9 @@ int FileSystem::CheckNumForFullName (const char *name, int rfnum)
 		return CheckNumForFullName (name);
 	}
 
-	i = FirstLumpIndex_FullName[MakeKey (name) % NumEntries];
+	i = FindFullName(name, false);
 
-	while (i != NULL_INDEX && 
-		(stricmp(name, FileInfo[i].longName) || FileInfo[i].rfnum != rfnum))
+	while (i != NULL_INDEX && FileInfo[i].rfnum != rfnum)
 	{
 		i = NextLumpIndex_FullName[i];
 	}
@@ -674,19 +731,13 @@ int FileSystem::FindFileWithExtensions(const char* name, const char *const *exts
 		return -1;
 	}
 	if (*name == '/') name++;	// ignore leading slashes in file names.
-	uint32_t* fli = FirstLumpIndex_NoExt;
-	uint32_t* nli = NextLumpIndex_NoExt;
 	auto len = strlen(name);
 
-	for (i = fli[MakeKey(name) % NumEntries]; i != NULL_INDEX; i = nli[i])
+	for (i = FindFullName(name, true); i != NULL_INDEX; i = NextLumpIndex_NoExt[i])
 	{
-		if (strnicmp(name, FileInfo[i].longName, len)) continue;
 		if (FileInfo[i].longName[len] != '.') continue;	// we are looking for extensions but this file doesn't have one.
 
 		auto cp = FileInfo[i].longName.GetChars() + len + 1;
-		// is this the last '.' in the last path element, indicating that the remaining part of the name is only an extension?
-		if (strpbrk(cp, "./") != nullptr) continue;	// No, so it cannot be a valid entry.
-
 		for (int j = 0; j < count; j++)
 		{
 			if (!stricmp(cp, exts[j])) return i;	// found a match
@@ -866,41 +917,58 @@ void FileSystem::InitHashChains (void)
 	unsigned int i, j;
 
 	NumEntries = FileInfo.Size();
-	Hashes.Resize(8 * NumEntries);
+	Hashes.Resize(6 * NumEntries);
 	// Mark all buckets as empty
 	memset(Hashes.Data(), -1, Hashes.Size() * sizeof(Hashes[0]));
-	FirstLumpIndex = &Hashes[0];
-	NextLumpIndex = &Hashes[NumEntries];
-	FirstLumpIndex_FullName = &Hashes[NumEntries * 2];
-	NextLumpIndex_FullName = &Hashes[NumEntries * 3];
-	FirstLumpIndex_NoExt = &Hashes[NumEntries * 4];
-	NextLumpIndex_NoExt = &Hashes[NumEntries * 5];
-	FirstLumpIndex_ResId = &Hashes[NumEntries * 6];
-	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
-
+	NextLumpIndex = &Hashes[0];
+	NextLumpIndex_FullName = &Hashes[NumEntries];
+	NextLumpIndex_NoExt = &Hashes[NumEntries * 2];
+	FirstLumpIndex_ResId = &Hashes[NumEntries * 3];
+	NextLumpIndex_ResId = &Hashes[NumEntries * 4];
+	NoExtLen = &Hashes[NumEntries * 5];
+
+	const uint32_t tablesize = IndexTableSize(NumEntries);
+	const uint32_t mask = tablesize - 1;
+	ShortNameIndex.Resize(tablesize);
+	FullNameIndex.Resize(tablesize);
+	NoExtIndex.Resize(tablesize);
+	for (auto &slot : ShortNameIndex) slot.first = NULL_INDEX;
+	for (auto &slot : FullNameIndex) slot.first = NULL_INDEX;
+	for (auto &slot : NoExtIndex) slot.first = NULL_INDEX;
 
 	// Now set up the chains
 	for (i = 0; i < (unsigned)NumEntries; i++)
 	{
-		j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
-		NextLumpIndex[i] = FirstLumpIndex[j];
-		FirstLumpIndex[j] = i;
+		uint64_t name = FileInfo[i].shortName.qword;
+		for (j = ShortNameHash(name) & mask; ShortNameIndex[j].first != NULL_INDEX && ShortNameIndex[j].name != name; j = (j + 1) & mask);
+		NextLumpIndex[i] = ShortNameIndex[j].first;
+		ShortNameIndex[j].name = name;
+		ShortNameIndex[j].first = i;
 
 		// Do the same for the full paths
 		if (FileInfo[i].longName.IsNotEmpty())
 		{
-			j = MakeKey(FileInfo[i].longName) % NumEntries;
-			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
-			FirstLumpIndex_FullName[j] = i;
-
-			FString nameNoExt = FileInfo[i].longName;
-			auto dot = nameNoExt.LastIndexOf('.');
-			auto slash = nameNoExt.LastIndexOf('/');
-			if (dot > slash) nameNoExt.Truncate(dot);
-
-			j = MakeKey(nameNoExt) % NumEntries;
-			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
-			FirstLumpIndex_NoExt[j] = i;
+			auto &longName = FileInfo[i].longName;
+			uint32_t hash = MakeKey(longName);
+			for (j = hash & mask; FullNameIndex[j].first != NULL_INDEX; j = (j + 1) & mask)
+			{
+				if (FullNameIndex[j].hash == hash && !stricmp(longName, FileInfo[FullNameIndex[j].first].longName)) break;
+			}
+			NextLumpIndex_FullName[i] = FullNameIndex[j].first;
+			FullNameIndex[j].hash = hash;
+			FullNameIndex[j].first = i;
+
+			size_t len = NoExtLength(longName);
+			NoExtLen[i] = (uint32_t)len;
+			hash = MakeKey(longName, len);
+			for (j = hash & mask; NoExtIndex[j].first != NULL_INDEX; j = (j + 1) & mask)
+			{
+				auto other = NoExtIndex[j].first;
+				if (NoExtIndex[j].hash == hash && NoExtLen[other] == len && !strnicmp(longName, FileInfo[other].longName, len)) break;
+			}
+			NextLumpIndex_NoExt[i] = NoExtIndex[j].first;
+			NoExtIndex[j].hash = hash;
+			NoExtIndex[j].first = i;
 
 			j = FileInfo[i].resourceId % NumEntries;
 			NextLumpIndex_ResId[i] = FirstLumpIndex_ResId[j];
@@ -1423,7 +1491,8 @@ FileReader FileSystem::ReopenFileReader(int lump, bool alwayscache)
 	auto rl = FileInfo[lump].lump;
 	auto rd = rl->GetReader();
 
-	if (rl->RefCount == 0 && rd != nullptr && !rd->GetBuffer() && !alwayscache && !(rl->Flags & LUMPF_COMPRESSED))
+	// Mapped archives are real files, so they can also get a reader of their own.
+	if (rl->RefCount == 0 && rd != nullptr && (!rd->GetBuffer() || rd->IsMapped()) && !alwayscache && !(rl->Flags & LUMPF_COMPRESSED))
 	{
 		int fileno = fileSystem.GetFileContainer(lump);
 		const char *filename = fileSystem.GetResourceFileFullName(fileno);
@@ -1699,3 +1768,102 @@ CCMD(fs_dir)
 		Printf(PRINT_NONOTIFY, "%s%-64s %-15s (%5d) %10d %s %s\n", hidden ? TEXTCOLOR_RED : TEXTCOLOR_UNTRANSLATED, fn1, fns, fnid, length, container, hidden ? "(h)" : "");
 	}
 }
+
+//==========================================================================
+//
+// Looks up the name of every lump in the current load order by short
+// name, full name and name without extension, plus the same number of
+// names that do not exist, and reports the time it takes.
+// The short name results are also checked for being the last lump with
+// that name in the requested namespace.
+//
+//==========================================================================
+
+#include "stats.h"
+
+CCMD(fs_benchlookup)
+{
+	int numfiles = fileSystem.GetNumEntries();
+	int repeat = argv.argc() > 1 ? max(1, atoi(argv[1])) : 10;
+	if (numfiles == 0) return;
+
+	TArray<FString> shortnames, fullnames, noextnames, misses;
+	TArray<int> namespaces;
+	for (int i = 0; i < numfiles; i++)
+	{
+		int ns = fileSystem.GetFileNamespace(i);
+		if (ns != ns_hidden)
+		{
+			shortnames.Push(fileSystem.GetFileShortName(i));
+			namespaces.Push(ns);
+		}
+		FString full = fileSystem.GetFileFullName(i, false);
+		if (full.IsNotEmpty())
+		{
+			fullnames.Push(full);
+			auto dot = full.LastIndexOf('.');
+			auto slash = full.LastIndexOf('/');
+			noextnames.Push(dot > slash ? full.Left(dot) : full);
+		}
+		misses.Push(FStringf("~%x", i));
+	}
+
+	cycle_t shorttime, fulltime, noexttime, misstime;
+	shorttime.Reset();
+	fulltime.Reset();
+	noexttime.Reset();
+	misstime.Reset();
+	int found = 0, bad = 0;
+
+	shorttime.Clock();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (unsigned i = 0; i < shortnames.Size(); i++) found += fileSystem.CheckNumForName(shortnames[i], namespaces[i]) >= 0;
+	}
+	shorttime.Unclock();
+
+	fulltime.Clock();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (auto &name : fullnames) found += fileSystem.CheckNumForFullName(name) >= 0;
+	}
+	fulltime.Unclock();
+
+	noexttime.Clock();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (auto &name : noextnames) found += fileSystem.CheckNumForFullName(name, false, ns_global, true) >= 0;
+	}
+	noexttime.Unclock();
+
+	misstime.Clock();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (auto &name : misses) found += fileSystem.CheckNumForName(name, ns_global) >= 0;
+	}
+	misstime.Unclock();
+
+	// The last lump with a name in a namespace must be found. Zip namespaces may also return a later lump from the global namespace.
+	TMap<FString, int> last;
+	for (int i = 0; i < numfiles; i++)
+	{
+		int ns = fileSystem.GetFileNamespace(i);
+		if (ns != ns_hidden) last[FStringf("%s:%d", fileSystem.GetFileShortName(i), ns)] = i;
+	}
+	for (unsigned i = 0; i < shortnames.Size(); i++)
+	{
+		int lump = fileSystem.CheckNumForName(shortnames[i], namespaces[i]);
+		int *expected = last.CheckKey(FStringf("%s:%d", shortnames[i].GetChars(), namespaces[i]));
+		if (lump < 0 || expected == nullptr || lump < *expected || stricmp(fileSystem.GetFileShortName(lump), shortnames[i]))
+		{
+			bad++;
+		}
+	}
+
+	Printf("%d lumps, %d repetitions, %d hits\n", numfiles, repeat, found);
+	Printf("short names:   %u lookups, %.3f ms\n", shortnames.Size() * repeat, shorttime.TimeMS());
+	Printf("full names:    %u lookups, %.3f ms\n", fullnames.Size() * repeat, fulltime.TimeMS());
+	Printf("no extension:  %u lookups, %.3f ms\n", noextnames.Size() * repeat, noexttime.TimeMS());
+	Printf("missing names: %u lookups, %.3f ms\n", misses.Size() * repeat, misstime.TimeMS());
+	Printf("%d short name lookups did not return the last matching lump\n", bad);
+}
@@ -67,6 +67,9 @@ public:
 	int GetMaxIwadNum() { return MaxIwadIndex; }
 	void SetMaxIwadNum(int x) { MaxIwadIndex = x; }
 
+	// Memory maps the archives instead of reading them through stdio.
+	void SetMapFiles(bool on) { MapFiles = on; }
+
 	void InitSingleFile(const char *filename, bool quiet = false);
 	void InitMultipleFiles (TArray<FString> &filenames, bool quiet = false, LumpFilterInfo* filter = nullptr, bool allowduplicates = false, FILE* hashfile = nullptr);
 	void AddFile (const char *filename, FileReader *wadinfo, bool quiet, LumpFilterInfo* filter, FILE* hashfile);
@@ -197,15 +200,28 @@ protected:
 	TArray<FResourceFile *> Files;
 	TArray<LumpRecord> FileInfo;
 
-	TArray<uint32_t> Hashes;	// one allocation for all hash lists.
-	uint32_t *FirstLumpIndex;	// [RH] Hashing stuff moved out of lumpinfo structure
-	uint32_t *NextLumpIndex;
+	struct ShortNameSlot
+	{
+		uint64_t name;		// the 8 character name as one integer
+		uint32_t first;		// last lump with this name or NULL_INDEX for an empty slot
+	};
 
-	uint32_t *FirstLumpIndex_FullName;	// The same information for fully qualified paths from .zips
-	uint32_t *NextLumpIndex_FullName;
+	struct FullNameSlot
+	{
+		uint32_t hash;		// precomputed hash of the name
+		uint32_t first;
+	};
+
+	TArray<ShortNameSlot> ShortNameIndex;	// open addressing tables, one slot per distinct name.
+	TArray<FullNameSlot> FullNameIndex;
+	TArray<FullNameSlot> NoExtIndex;
+
+	TArray<uint32_t> Hashes;	// one allocation for all hash lists.
+	uint32_t *NextLumpIndex;	// previous lump with the same short name
 
-	uint32_t *FirstLumpIndex_NoExt;	// The same information for fully qualified paths from .zips
-	uint32_t *NextLumpIndex_NoExt;
+	uint32_t *NextLumpIndex_FullName;	// The same information for fully qualified paths from .zips
+	uint32_t *NextLumpIndex_NoExt;		// and for those paths without extension
+	uint32_t *NoExtLen;
 
 	uint32_t* FirstLumpIndex_ResId;	// The same information for fully qualified paths from .zips
 	uint32_t* NextLumpIndex_ResId;
@@ -215,8 +231,11 @@ protected:
 
 	int IwadIndex = -1;
 	int MaxIwadIndex = -1;
+	bool MapFiles = false;
 
 private:
+	uint32_t FindShortName(uint64_t name) const;
+	uint32_t FindFullName(const char *name, bool noext) const;
 	void DeleteAll();
 	void MoveLumpsInFolder(const char *);
 
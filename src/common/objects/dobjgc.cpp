@@ -62,6 +62,7 @@
 #include "menu.h"
 #include "stats.h"
 #include "printf.h"
+#include "tracezones.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -410,6 +411,7 @@ static size_t SingleStep()
 
 void Step()
 {
+	TRACE_ZONE("GC::Step");
 	// We recalculate a step size in case the rate of allocation went up
 	// since we started sweeping because we don't want to fall behind.
 	// However, we also don't want to go slower than what was decided upon
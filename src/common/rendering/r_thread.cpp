@@ -29,6 +29,8 @@
 #include "r_memory.h"
 #include "poly_thread.h"
 #include "printf.h"
+#include "c_dispatch.h"
+#include "tracezones.h"
 #include "polyrenderer/drawers/poly_triangle.h"
 #include <chrono>
 
@@ -39,6 +41,14 @@ void PeekThreadedErrorPane();
 CVAR(Int, r_multithreaded, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR(Int, r_debug_draw, 0, 0);
 
+// Number of line bands per worker thread. Idle workers take over bands other
+// workers have not started yet, but every band repeats the vertex setup work.
+CUSTOM_CVAR(Int, r_drawerbands, 2, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 1) self = 1;
+	else if (self > 8) self = 8;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 DrawerThreads *DrawerThreads::Instance()
@@ -110,6 +120,9 @@ void DrawerThreads::WaitForWorkers()
 	}
 	end_lock.unlock();
 
+	if (queue->replay_count > 0 && !queue->active_commands.empty())
+		queue->ReplayCommands();
+
 	// Clean up
 	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
 	for (auto &thread : queue->threads)
@@ -124,19 +137,94 @@ void DrawerThreads::WaitForWorkers()
 	queue->active_commands.clear();
 }
 
-void DrawerThreads::WorkerMain(DrawerThread *thread)
+void DrawerThreads::ReplayNextBatch(int count)
+{
+	auto queue = Instance();
+	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
+	queue->replay_count = count;
+}
+
+void DrawerThreads::ReplayCommands()
 {
+	int count = replay_count;
+	replay_count = 0;
+
+	size_t numcommands = 0;
+	for (auto &list : active_commands)
+		numcommands += list->commands.size();
+
+	replay_band_time.assign(threads.size(), 0);
+	uint64_t best = UINT64_MAX, total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		uint64_t start = Trace_Now();
+
+		std::unique_lock<std::mutex> start_lock(start_mutex);
+		std::unique_lock<std::mutex> end_lock(end_mutex);
+		for (auto &thread : threads)
+			thread.current_queue = 0;
+		replaying = true;
+		tasks_left = threads.size() * active_commands.size();
+		start_lock.unlock();
+		start_condition.notify_all();
+		end_condition.wait(end_lock, [&]() { return tasks_left == 0; });
+		end_lock.unlock();
+
+		uint64_t time = Trace_Now() - start;
+		best = min(best, time);
+		total += time;
+	}
+
+	std::unique_lock<std::mutex> start_lock(start_mutex);
+	replaying = false;
+	start_lock.unlock();
+
+	// How much longer the slowest band took than the average one
+	uint64_t bandmax = 0, bandsum = 0;
+	for (uint64_t time : replay_band_time)
+	{
+		bandmax = max(bandmax, time);
+		bandsum += time;
+	}
+	double imbalance = bandsum > 0 ? bandmax * threads.size() / (double)bandsum : 1.0;
+
+	Printf("Replayed %d queues with %d commands %d times on %d threads with %d bands\n",
+		(int)active_commands.size(), (int)numcommands, count, (int)workers.size(), (int)threads.size());
+	Printf("Best %.3f ms, average %.3f ms, slowest band %.2fx the average\n", best / 1e6, total / 1e6 / count, imbalance);
+}
+
+DrawerThread *DrawerThreads::FindWork(DrawerWorker *worker)
+{
+	// Take our own bands first and only steal one from another worker on the same NUMA node when none are left
+	DrawerThread *stolen = nullptr;
+	for (auto &thread : threads)
+	{
+		if (thread.busy || thread.numa_node != worker->numa_node || thread.current_queue >= active_commands.size())
+			continue;
+		if (thread.owner == worker->index)
+			return &thread;
+		if (!stolen)
+			stolen = &thread;
+	}
+	return stolen;
+}
+
+void DrawerThreads::WorkerMain(DrawerWorker *worker)
+{
+	Trace_SetThreadName("Drawer thread");
 	while (true)
 	{
-		// Wait until we are signalled to run:
+		// Wait until there is a band with commands that nobody else is running:
+		DrawerThread *thread = nullptr;
 		std::unique_lock<std::mutex> start_lock(start_mutex);
-		start_condition.wait(start_lock, [&]() { return thread->current_queue < active_commands.size() || shutdown_flag; });
+		start_condition.wait(start_lock, [&]() { return shutdown_flag || (thread = FindWork(worker)) != nullptr; });
 		if (shutdown_flag)
 			break;
 
 		// Grab the commands
 		DrawerCommandQueuePtr list = active_commands[thread->current_queue];
 		thread->current_queue++;
+		thread->busy = true;
 		thread->numa_start_y = thread->numa_node * screen->GetHeight() / thread->num_numa_nodes;
 		thread->numa_end_y = (thread->numa_node + 1) * screen->GetHeight() / thread->num_numa_nodes;
 		if (thread->poly)
@@ -144,9 +232,11 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 			thread->poly->numa_start_y = thread->numa_start_y;
 			thread->poly->numa_end_y = thread->numa_end_y;
 		}
+		bool timed = replaying;
 		start_lock.unlock();
 
 		// Do the work:
+		uint64_t tracestart = TraceCapturing || timed ? Trace_Now() : 0;
 		if (r_debug_draw)
 		{
 			for (auto& command : list->commands)
@@ -163,6 +253,16 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 				command->Execute(thread);
 			}
 		}
+		if (TraceCapturing && tracestart != 0) Trace_Record("DrawerThreads::Execute", tracestart);
+		if (timed) replay_band_time[thread - threads.data()] += Trace_Now() - tracestart;
+
+		// Hand the band back and wake up any idle worker that can run its next queue:
+		start_lock.lock();
+		thread->busy = false;
+		bool moreQueues = thread->current_queue < active_commands.size();
+		start_lock.unlock();
+		if (moreQueues)
+			start_condition.notify_all();
 
 		// Notify main thread that we finished:
 		std::unique_lock<std::mutex> end_lock(end_mutex);
@@ -201,42 +301,61 @@ void DrawerThreads::StartThreads()
 	else if (r_multithreaded != 1)
 		num_threads = r_multithreaded;
 
-	if (num_threads != (int)threads.size())
+	int bands = r_drawerbands;
+	if (num_threads != (int)workers.size() || bands != bands_per_thread)
 	{
 		StopThreads();
 
-		threads.resize(num_threads);
+		workers.resize(num_threads);
+		threads.resize(num_threads * bands);
+		bands_per_thread = bands;
 
 		if (num_threads == num_numathreads)
 		{
 			int curThread = 0;
+			int curBand = 0;
 			for (int numaNode = 0; numaNode < I_GetNumaNodeCount(); numaNode++)
 			{
-				for (int i = 0; i < I_GetNumaNodeThreadCount(numaNode); i++)
+				int nodeThreads = I_GetNumaNodeThreadCount(numaNode);
+				for (int i = 0; i < nodeThreads * bands; i++)
 				{
-					DrawerThreads *queue = this;
-					DrawerThread *thread = &threads[curThread++];
+					DrawerThread *thread = &threads[curBand++];
 					thread->core = i;
-					thread->num_cores = I_GetNumaNodeThreadCount(numaNode);
+					thread->num_cores = nodeThreads * bands;
 					thread->numa_node = numaNode;
 					thread->num_numa_nodes = I_GetNumaNodeCount();
-					thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-					I_SetThreadNumaNode(thread->thread, numaNode);
+					thread->owner = curThread + i % nodeThreads;
+				}
+				for (int i = 0; i < nodeThreads; i++)
+				{
+					DrawerThreads *queue = this;
+					DrawerWorker *worker = &workers[curThread];
+					worker->index = curThread++;
+					worker->numa_node = numaNode;
+					worker->thread = std::thread([=]() { queue->WorkerMain(worker); });
+					I_SetThreadNumaNode(worker->thread, numaNode);
 				}
 			}
 		}
 		else
 		{
-			for (int i = 0; i < num_threads; i++)
+			for (int i = 0; i < num_threads * bands; i++)
 			{
-				DrawerThreads *queue = this;
 				DrawerThread *thread = &threads[i];
 				thread->core = i;
-				thread->num_cores = num_threads;
+				thread->num_cores = num_threads * bands;
 				thread->numa_node = 0;
 				thread->num_numa_nodes = 1;
-				thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-				I_SetThreadNumaNode(thread->thread, 0);
+				thread->owner = i % num_threads;
+			}
+			for (int i = 0; i < num_threads; i++)
+			{
+				DrawerThreads *queue = this;
+				DrawerWorker *worker = &workers[i];
+				worker->index = i;
+				worker->numa_node = 0;
+				worker->thread = std::thread([=]() { queue->WorkerMain(worker); });
+				I_SetThreadNumaNode(worker->thread, 0);
 			}
 		}
 	}
@@ -248,9 +367,11 @@ void DrawerThreads::StopThreads()
 	shutdown_flag = true;
 	lock.unlock();
 	start_condition.notify_all();
-	for (auto &thread : threads)
-		thread.thread.join();
+	for (auto &worker : workers)
+		worker.thread.join();
+	workers.clear();
 	threads.clear();
+	bands_per_thread = 0;
 	lock.lock();
 	shutdown_flag = false;
 }
@@ -268,16 +389,6 @@ void *DrawerCommandQueue::AllocMemory(size_t size)
 
 /////////////////////////////////////////////////////////////////////////////
 
-void GroupMemoryBarrierCommand::Execute(DrawerThread *thread)
-{
-	std::unique_lock<std::mutex> lock(mutex);
-	count++;
-	condition.notify_all();
-	condition.wait(lock, [&]() { return count >= (size_t)thread->num_cores; });
-}
-
-/////////////////////////////////////////////////////////////////////////////
-
 MemcpyCommand::MemcpyCommand(void *dest, int destpitch, const void *src, int width, int height, int srcpitch, int pixelsize)
 	: dest(dest), src(src), destpitch(destpitch), width(width), height(height), srcpitch(srcpitch), pixelsize(pixelsize)
 {
@@ -299,3 +410,25 @@ void MemcpyCommand::Execute(DrawerThread *thread)
 		s += sstep;
 	}
 }
+
+/////////////////////////////////////////////////////////////////////////////
+
+CCMD(drawerbench)
+{
+	if (r_multithreaded == 0)
+	{
+		Printf("The drawer threads are not used while r_multithreaded is 0\n");
+		return;
+	}
+	if (argv.argc() > 1 && !stricmp(argv[1], "help"))
+	{
+		Printf("Usage: drawerbench [count]\n"
+			"Runs the next batch of drawer commands count more times and prints how long it took.\n"
+			"The batch is drawn again on top of the finished frame, so translucent and blended\n"
+			"surfaces in that one frame will look wrong.\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 1000) : 20;
+	Printf("Replaying the next drawer command batch %d times. The frame will look wrong while doing so.\n", count);
+	DrawerThreads::ReplayNextBatch(count);
+}
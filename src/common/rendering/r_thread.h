@@ -38,17 +38,24 @@ class PolyTriangleThreadData;
 
 namespace swrenderer { class WallColumnDrawerArgs; }
 
-// Worker data for each thread executing drawer commands
+// Worker data for each band of lines executing drawer commands.
+// A band runs every queued command in order, but any worker thread on its
+// NUMA node may pick it up between two command queues.
 class DrawerThread
 {
 public:
-	std::thread thread;
 	size_t current_queue = 0;
 
-	// Thread line index of this thread
+	// Set while a worker is executing commands for this band
+	bool busy = false;
+
+	// Worker thread that picks this band first
+	int owner = 0;
+
+	// Thread line index of this band
 	int core = 0;
 
-	// Number of active threads
+	// Number of bands in the NUMA node
 	int num_cores = 1;
 
 	// NUMA node this thread belongs to
@@ -114,18 +121,6 @@ public:
 	virtual void Execute(DrawerThread *thread) = 0;
 };
 
-// Wait for all worker threads before executing next command
-class GroupMemoryBarrierCommand : public DrawerCommand
-{
-public:
-	void Execute(DrawerThread *thread);
-
-private:
-	std::mutex mutex;
-	std::condition_variable condition;
-	size_t count = 0;
-};
-
 // Copy finished rows to video memory
 class MemcpyCommand : public DrawerCommand
 {
@@ -157,18 +152,32 @@ public:
 
 	static void ResetDebugDrawPos();
 
+	// Runs the commands of the next batch waited for again and prints how long it took
+	static void ReplayNextBatch(int count);
+
 private:
 	DrawerThreads();
 	~DrawerThreads();
 
+	struct DrawerWorker
+	{
+		std::thread thread;
+		int index = 0;
+		int numa_node = 0;
+	};
+
 	void StartThreads();
 	void StopThreads();
-	void WorkerMain(DrawerThread *thread);
+	void WorkerMain(DrawerWorker *worker);
+	DrawerThread *FindWork(DrawerWorker *worker);
+	void ReplayCommands();
 
 	static DrawerThreads *Instance();
 
 	std::mutex threads_mutex;
+	std::vector<DrawerWorker> workers;
 	std::vector<DrawerThread> threads;
+	int bands_per_thread = 0;
 
 	std::mutex start_mutex;
 	std::condition_variable start_condition;
@@ -181,6 +190,10 @@ private:
 
 	size_t debug_draw_end = 0;
 
+	int replay_count = 0;
+	bool replaying = false;
+	std::vector<uint64_t> replay_band_time;
+
 	DrawerThread single_core_thread;
 
 	friend class DrawerCommandQueue;
@@ -0,0 +1,387 @@
+/*
+** v_capture.cpp
+** Background image writer and frame capture
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Screenshots and captured frames get converted, compressed and written
+** on a separate thread so that the game loop only has to read back the
+** frame buffer.
+**
+*/
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#include "v_capture.h"
+#include "v_video.h"
+#include "m_png.h"
+#include "files.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "cmdlib.h"
+
+CUSTOM_CVAR(Int, capture_maxpending, 8, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 1) self = 1;
+}
+CVAR(Int, capture_fps, 35, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+//==========================================================================
+//
+// The writer thread
+//
+//==========================================================================
+
+class FImageWriteQueue
+{
+public:
+	~FImageWriteQueue()
+	{
+		Stop();
+	}
+
+	void Queue(std::function<void()> &&job)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (!Thread.joinable())
+		{
+			Quit = false;
+			Thread = std::thread([this]() { Run(); });
+		}
+		ProducerWake.wait(lock, [this]() { return Jobs.size() < (size_t)capture_maxpending; });
+		Jobs.push_back(std::move(job));
+		WorkerWake.notify_one();
+	}
+
+	void Finish()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		ProducerWake.wait(lock, [this]() { return Jobs.empty() && !Busy; });
+	}
+
+	void Stop()
+	{
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			Quit = true;
+			WorkerWake.notify_one();
+		}
+		if (Thread.joinable()) Thread.join();
+	}
+
+	void PostMessage(const FString &message)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		Messages.Push(message);
+	}
+
+	void PrintMessages()
+	{
+		TArray<FString> messages;
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			if (Messages.Size() == 0) return;
+			std::swap(messages, Messages);
+		}
+		for (auto &msg : messages)
+		{
+			Printf("%s\n", msg.GetChars());
+		}
+	}
+
+private:
+	std::thread Thread;
+	std::mutex Mutex;
+	std::condition_variable WorkerWake;
+	std::condition_variable ProducerWake;
+	std::deque<std::function<void()>> Jobs;
+	TArray<FString> Messages;
+	bool Busy = false;
+	bool Quit = false;
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		for (;;)
+		{
+			WorkerWake.wait(lock, [this]() { return Quit || !Jobs.empty(); });
+			// Pending jobs are always finished, even when quitting.
+			if (Jobs.empty()) break;
+
+			auto job = std::move(Jobs.front());
+			Jobs.pop_front();
+			Busy = true;
+			lock.unlock();
+			job();
+			lock.lock();
+			Busy = false;
+			ProducerWake.notify_all();
+		}
+	}
+};
+
+static FImageWriteQueue WriteQueue;
+
+void V_QueueImageJob(std::function<void()> job)
+{
+	WriteQueue.Queue(std::move(job));
+}
+
+void V_PostImageMessage(const FString &message)
+{
+	WriteQueue.PostMessage(message);
+}
+
+void V_FinishImageJobs()
+{
+	WriteQueue.Finish();
+	WriteQueue.PrintMessages();
+}
+
+//==========================================================================
+//
+// Frame capture
+//
+// 'png' writes each frame to its own numbered file, 'raw' appends the
+// frames as packed 24 bit RGB to a single file and 'y4m' writes a
+// YUV4MPEG2 stream in 4:4:4 format that most video tools can read.
+//
+//==========================================================================
+
+enum ECaptureFormat
+{
+	CAPTURE_PNG,
+	CAPTURE_RAW,
+	CAPTURE_Y4M,
+};
+
+static struct
+{
+	bool active;
+	ECaptureFormat format;
+	FString name;
+	FileWriter *stream;	// only touched by the writer thread once the capture is running.
+	int width, height;
+	int frame;
+} Capture;
+
+static void ConvertToRGB(const TArray<uint8_t> &buffer, ESSType color_type, int width, int height, int pitch, TArray<uint8_t> &rgb)
+{
+	rgb.Resize(width * height * 3);
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t *in = &buffer[y * pitch];
+		uint8_t *out = &rgb[y * width * 3];
+		if (color_type == SS_RGB)
+		{
+			memcpy(out, in, width * 3);
+		}
+		else
+		{
+			for (int x = 0; x < width; x++)
+			{
+				out[x*3 + 0] = in[x*4 + 2];
+				out[x*3 + 1] = in[x*4 + 1];
+				out[x*3 + 2] = in[x*4];
+			}
+		}
+	}
+}
+
+static void WriteY4MFrame(FileWriter *file, const TArray<uint8_t> &rgb, int width, int height)
+{
+	// BT.601 with the usual limited range.
+	const int size = width * height;
+	TArray<uint8_t> yuv(size * 3, true);
+	for (int i = 0; i < size; i++)
+	{
+		int r = rgb[i*3], g = rgb[i*3 + 1], b = rgb[i*3 + 2];
+		yuv[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		yuv[size + i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		yuv[size * 2 + i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+	file->Write("FRAME\n", 6);
+	file->Write(yuv.Data(), yuv.Size());
+}
+
+void V_StopCapture()
+{
+	if (!Capture.active) return;
+
+	auto stream = Capture.stream;
+	auto name = Capture.name;
+	int frames = Capture.frame;
+	int width = Capture.width, height = Capture.height;
+	Capture.active = false;
+	Capture.stream = nullptr;
+	V_QueueImageJob([=]()
+	{
+		delete stream;
+		V_PostImageMessage(FStringf("Capture to %s stopped after %d frames of %dx%d", name.GetChars(), frames, width, height));
+	});
+}
+
+void V_CaptureFrame()
+{
+	WriteQueue.PrintMessages();
+	if (!Capture.active) return;
+
+	int pitch;
+	ESSType color_type;
+	float gamma;
+	auto buffer = screen->GetScreenshotBuffer(pitch, color_type, gamma);
+	int width = screen->GetWidth();
+	int height = screen->GetHeight();
+
+	if (buffer.Size() == 0 || color_type == SS_PAL)
+	{
+		Printf("Unable to capture frames with the current renderer\n");
+		V_StopCapture();
+		return;
+	}
+	if (Capture.frame == 0)
+	{
+		Capture.width = width;
+		Capture.height = height;
+		if (Capture.format == CAPTURE_Y4M)
+		{
+			FString header;
+			header.Format("YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, *capture_fps);
+			auto stream = Capture.stream;
+			V_QueueImageJob([=]() { stream->Write(header.GetChars(), header.Len()); });
+		}
+	}
+	else if (width != Capture.width || height != Capture.height)
+	{
+		Printf("Screen size changed, capture stopped\n");
+		V_StopCapture();
+		return;
+	}
+
+	int frame = Capture.frame++;
+	switch (Capture.format)
+	{
+	case CAPTURE_PNG:
+	{
+		FString filename;
+		filename.Format("%s_%06d.png", Capture.name.GetChars(), frame);
+		auto file = FileWriter::Open(filename.GetChars());
+		if (file == nullptr)
+		{
+			Printf("Could not open %s\n", filename.GetChars());
+			V_StopCapture();
+			return;
+		}
+		V_QueueImageJob([=, buffer = std::move(buffer)]()
+		{
+			if (!M_CreatePNG(file, buffer.Data(), nullptr, color_type, width, height, pitch, gamma) || !M_FinishPNG(file))
+			{
+				V_PostImageMessage(FStringf("Error writing %s", filename.GetChars()));
+			}
+			delete file;
+		});
+		break;
+	}
+
+	case CAPTURE_RAW:
+	case CAPTURE_Y4M:
+	{
+		auto stream = Capture.stream;
+		auto format = Capture.format;
+		V_QueueImageJob([=, buffer = std::move(buffer)]()
+		{
+			TArray<uint8_t> rgb;
+			ConvertToRGB(buffer, color_type, width, height, pitch, rgb);
+			if (format == CAPTURE_Y4M) WriteY4MFrame(stream, rgb, width, height);
+			else stream->Write(rgb.Data(), rgb.Size());
+		});
+		break;
+	}
+	}
+}
+
+//==========================================================================
+//
+// capture <name> [png|raw|y4m]
+// capture stop
+//
+//==========================================================================
+
+UNSAFE_CCMD(capture)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: capture <name> [png|raw|y4m]\n       capture stop\n");
+		return;
+	}
+	if (!stricmp(argv[1], "stop"))
+	{
+		if (!Capture.active) Printf("No capture running\n");
+		V_StopCapture();
+		return;
+	}
+
+	V_StopCapture();
+
+	ECaptureFormat format = CAPTURE_PNG;
+	if (argv.argc() > 2)
+	{
+		if (!stricmp(argv[2], "raw")) format = CAPTURE_RAW;
+		else if (!stricmp(argv[2], "y4m")) format = CAPTURE_Y4M;
+		else if (stricmp(argv[2], "png"))
+		{
+			Printf("Unknown capture format '%s'\n", argv[2]);
+			return;
+		}
+	}
+
+	FString name = argv[1];
+	FileWriter *stream = nullptr;
+	if (format != CAPTURE_PNG)
+	{
+		DefaultExtension(name, format == CAPTURE_RAW ? ".rgb" : ".y4m");
+		stream = FileWriter::Open(name.GetChars());
+		if (stream == nullptr)
+		{
+			Printf("Could not open %s\n", name.GetChars());
+			return;
+		}
+	}
+
+	Capture.active = true;
+	Capture.format = format;
+	Capture.name = name;
+	Capture.stream = stream;
+	Capture.frame = 0;
+	Printf("Capturing to %s\n", name.GetChars());
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <functional>
+#include "zstring.h"
+
+// Runs a job on the image writer thread. Jobs are run in the order they were queued.
+// If too many jobs are pending, this waits until the writer catches up.
+void V_QueueImageJob(std::function<void()> job);
+
+// Lets a job report something. The message gets printed by the main thread.
+void V_PostImageMessage(const FString &message);
+
+// Waits for all pending jobs to finish.
+void V_FinishImageJobs();
+
+// Called once per frame after the screen was updated. Prints the messages of
+// finished jobs and grabs the frame if a capture is running.
+void V_CaptureFrame();
+
+void V_StopCapture();
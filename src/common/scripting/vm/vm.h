@@ -55,6 +55,7 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void VMProfilerRelease();
 
 extern void (*VM_CastSpriteIDToString)(FString* a, unsigned int b);
 
@@ -430,6 +431,7 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		VMProfilerRelease();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
@@ -134,6 +134,8 @@ VMScriptFunction::VMScriptFunction(FName name)
 	NumKonstA = 0;
 	MaxParam = 0;
 	NumArgs = 0;
+	ProfiledCall = nullptr;
+	ProfileIndex = 0;
 	ScriptCall = &VMScriptFunction::FirstScriptCall;
 }
 
@@ -291,20 +293,23 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 	{
 		ThrowAbortException(X_OTHER, "attempt to call abstract function %s.", func->PrintableName.GetChars());
 	}
+	// If the profiler has hooked this function the entry point must go behind its back.
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	auto &entry = sfunc->ProfiledCall != nullptr ? sfunc->ProfiledCall : func->ScriptCall;
 #ifdef HAVE_VM_JIT
-	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
+	if (vm_jit && CanJit(sfunc))
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
-		if (!func->ScriptCall)
-			func->ScriptCall = VMExec;
+		entry = JitCompile(sfunc);
+		if (!entry)
+			entry = VMExec;
 	}
 	else
 #endif // HAVE_VM_JIT
 	{
-		func->ScriptCall = VMExec;
+		entry = VMExec;
 	}
 
-	return func->ScriptCall(func, params, numparams, ret, numret);
+	return entry(func, params, numparams, ret, numret);
 }
 
 int VMNativeFunction::NativeScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *returns, int numret)
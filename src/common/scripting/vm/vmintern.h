@@ -472,6 +472,8 @@ public:
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
+	JitFuncPtr ProfiledCall;	// the real entry point while the profiler has replaced ScriptCall
+	unsigned ProfileIndex;
 
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
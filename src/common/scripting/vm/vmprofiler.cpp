@@ -0,0 +1,431 @@
+/*
+** vmprofiler.cpp
+** Per-function profiler for script code
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Every call to a script function, no matter if it comes from the
+** interpreter, from JIT compiled code or from native code through VMCall,
+** goes through the function's ScriptCall pointer. While profiling, that
+** pointer gets replaced by a hook for every script function, so nothing
+** costs anything when the profiler is off.
+**
+** The data is kept as a calling context tree: every distinct call path
+** gets its own node. Per function and per caller->callee totals are
+** summed up from that when a report is made, and the folded stacks for
+** flame graph tools fall right out of it.
+**
+*/
+
+#include <thread>
+#include <algorithm>
+#include "dobject.h"
+#include "v_text.h"
+#include "stats.h"
+#include "c_dispatch.h"
+#include "files.h"
+#include "vmintern.h"
+#include "types.h"
+
+struct FProfileNode
+{
+	VMScriptFunction *Func;
+	unsigned Parent;
+	unsigned Calls;
+	double Inclusive;	// in seconds
+	double Exclusive;
+};
+
+struct FProfileFrame
+{
+	unsigned Node;
+	double ChildTime;
+	cycle_t Time;
+};
+
+struct FProfileTotals
+{
+	unsigned Caller;	// ~0u for calls from native code
+	unsigned Callee;
+	unsigned Calls;
+	double Inclusive;
+	double Exclusive;
+};
+
+static bool ProfilerActive;
+static unsigned ProfilerSession;
+static std::thread::id ProfilerThread;
+static cycle_t ProfilerTime;
+static TArray<VMScriptFunction *> ProfiledFunctions;
+static TArray<FProfileNode> ProfileNodes;			// node 0 is the root for everything called from native code
+static TMap<uint64_t, unsigned> ProfileChildren;	// (parent node, function index) -> node
+static TArray<FProfileFrame> ProfileStack;
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void ProfileEnter(VMScriptFunction *func)
+{
+	unsigned parent = ProfileStack.Size() > 0 ? ProfileStack.Last().Node : 0;
+	uint64_t key = (uint64_t(parent) << 32) | func->ProfileIndex;
+	unsigned node;
+	auto pnode = ProfileChildren.CheckKey(key);
+	if (pnode != nullptr)
+	{
+		node = *pnode;
+	}
+	else
+	{
+		node = ProfileNodes.Push({ func, parent, 0, 0, 0 });
+		ProfileChildren.Insert(key, node);
+	}
+
+	auto &frame = ProfileStack[ProfileStack.Reserve(1)];
+	frame.Node = node;
+	frame.ChildTime = 0;
+	frame.Time.Reset();
+	frame.Time.Clock();
+}
+
+static void ProfileLeave()
+{
+	auto &frame = ProfileStack.Last();
+	frame.Time.Unclock();
+	double time = frame.Time.Time();
+
+	auto &node = ProfileNodes[frame.Node];
+	node.Calls++;
+	node.Inclusive += time;
+	node.Exclusive += time - frame.ChildTime;
+
+	ProfileStack.Pop();
+	if (ProfileStack.Size() > 0) ProfileStack.Last().ChildTime += time;
+}
+
+//==========================================================================
+//
+// Leaving is done in a destructor so that the stack stays in order when
+// a VM abort unwinds through the hooked calls.
+//
+//==========================================================================
+
+class FProfileScope
+{
+	unsigned Session;
+	unsigned Depth = 0;
+
+public:
+	FProfileScope(VMScriptFunction *func) : Session(ProfilerSession)
+	{
+		if (ProfilerActive && std::this_thread::get_id() == ProfilerThread)
+		{
+			ProfileEnter(func);
+			Depth = ProfileStack.Size();
+		}
+	}
+
+	~FProfileScope()
+	{
+		// The profiler may have been stopped or restarted by a console command during the call.
+		if (Depth > 0 && Session == ProfilerSession && ProfileStack.Size() == Depth) ProfileLeave();
+	}
+};
+
+static int ProfiledScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction *>(func);
+	auto call = sfunc->ProfiledCall;
+	if (call == nullptr) call = sfunc->ScriptCall;
+
+	FProfileScope scope(sfunc);
+	return call(func, params, numparams, ret, numret);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void ClearProfile()
+{
+	ProfileNodes.Clear();
+	ProfileNodes.Push({ nullptr, 0, 0, 0, 0 });
+	ProfileChildren.Clear();
+	ProfileStack.Clear();
+	ProfilerTime.Reset();
+}
+
+static void StartProfiling()
+{
+	if (ProfilerActive) return;
+
+	ClearProfile();
+	ProfiledFunctions.Clear();
+	for (auto f : VMFunction::AllFunctions)
+	{
+		if (f->VarFlags & VARF_Native) continue;
+
+		auto sfunc = static_cast<VMScriptFunction *>(f);
+		sfunc->ProfileIndex = ProfiledFunctions.Push(sfunc);
+		sfunc->ProfiledCall = sfunc->ScriptCall;
+		sfunc->ScriptCall = ProfiledScriptCall;
+	}
+
+	ProfilerSession++;
+	ProfilerThread = std::this_thread::get_id();
+	ProfilerActive = true;
+	ProfilerTime.Clock();
+}
+
+static void StopProfiling()
+{
+	if (!ProfilerActive) return;
+
+	ProfilerTime.Unclock();
+	ProfilerActive = false;
+	ProfilerSession++;
+	ProfileStack.Clear();
+	for (auto sfunc : ProfiledFunctions)
+	{
+		sfunc->ScriptCall = sfunc->ProfiledCall;
+		sfunc->ProfiledCall = nullptr;
+	}
+}
+
+void VMProfilerRelease()
+{
+	StopProfiling();
+	ClearProfile();
+	ProfiledFunctions.Reset();
+}
+
+//==========================================================================
+//
+// Checks if a function is already further up the call path, so that the
+// inclusive time of recursive calls does not get counted twice.
+//
+//==========================================================================
+
+static bool IsRecursion(unsigned node)
+{
+	auto func = ProfileNodes[node].Func;
+	for (unsigned n = ProfileNodes[node].Parent; n != 0; n = ProfileNodes[n].Parent)
+	{
+		if (ProfileNodes[n].Func == func) return true;
+	}
+	return false;
+}
+
+static void SumFunctions(TArray<FProfileTotals> &totals)
+{
+	totals.Clear();
+	for (unsigned i = 0; i < ProfiledFunctions.Size(); i++)
+	{
+		totals.Push({ ~0u, i, 0, 0, 0 });
+	}
+	for (unsigned i = 1; i < ProfileNodes.Size(); i++)
+	{
+		auto &node = ProfileNodes[i];
+		auto &sum = totals[node.Func->ProfileIndex];
+		sum.Calls += node.Calls;
+		sum.Exclusive += node.Exclusive;
+		if (!IsRecursion(i)) sum.Inclusive += node.Inclusive;
+	}
+	unsigned used = 0;
+	for (auto &t : totals)
+	{
+		if (t.Calls > 0) totals[used++] = t;
+	}
+	totals.Resize(used);
+}
+
+static void SumEdges(TArray<FProfileTotals> &totals)
+{
+	TMap<uint64_t, unsigned> edges;
+	totals.Clear();
+	for (unsigned i = 1; i < ProfileNodes.Size(); i++)
+	{
+		auto &node = ProfileNodes[i];
+		unsigned caller = node.Parent == 0 ? ~0u : ProfileNodes[node.Parent].Func->ProfileIndex;
+		unsigned callee = node.Func->ProfileIndex;
+		uint64_t key = (uint64_t(caller) << 32) | callee;
+
+		auto pindex = edges.CheckKey(key);
+		unsigned index = pindex != nullptr ? *pindex : (edges[key] = totals.Push({ caller, callee, 0, 0, 0 }));
+		auto &sum = totals[index];
+		sum.Calls += node.Calls;
+		sum.Exclusive += node.Exclusive;
+		if (!IsRecursion(i)) sum.Inclusive += node.Inclusive;
+	}
+}
+
+static const char *FunctionName(unsigned index)
+{
+	return index == ~0u ? "<native>" : ProfiledFunctions[index]->PrintableName.GetChars();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void PrintFunctions(unsigned limit, bool inclusive)
+{
+	TArray<FProfileTotals> totals;
+	SumFunctions(totals);
+	std::sort(totals.begin(), totals.end(), [=](const FProfileTotals &left, const FProfileTotals &right)
+	{
+		return inclusive ? left.Inclusive > right.Inclusive : left.Exclusive > right.Exclusive;
+	});
+
+	Printf(TEXTCOLOR_YELLOW "Incl, ms    Excl, ms    Averg, ms   Calls     Function\n");
+	Printf(TEXTCOLOR_YELLOW "----------  ----------  ----------  --------  --------------------\n");
+	for (unsigned i = 0; i < min(limit, totals.Size()); i++)
+	{
+		auto &t = totals[i];
+		Printf("%s%10.3f  %s%10.3f  " TEXTCOLOR_WHITE "%10.6f  %8u  %s\n",
+			inclusive ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, t.Inclusive * 1000,
+			inclusive ? TEXTCOLOR_WHITE : TEXTCOLOR_YELLOW, t.Exclusive * 1000,
+			t.Inclusive * 1000 / t.Calls, t.Calls, FunctionName(t.Callee));
+	}
+}
+
+static void PrintEdges(unsigned limit, const char *filter)
+{
+	TArray<FProfileTotals> totals;
+	SumEdges(totals);
+	std::sort(totals.begin(), totals.end(), [](const FProfileTotals &left, const FProfileTotals &right)
+	{
+		return left.Inclusive > right.Inclusive;
+	});
+
+	Printf(TEXTCOLOR_YELLOW "Incl, ms    Excl, ms    Calls     Caller -> Callee\n");
+	Printf(TEXTCOLOR_YELLOW "----------  ----------  --------  --------------------\n");
+	unsigned count = 0;
+	for (unsigned i = 0; i < totals.Size() && count < limit; i++)
+	{
+		auto &t = totals[i];
+		if (filter != nullptr && stricmp(FunctionName(t.Caller), filter) != 0 && stricmp(FunctionName(t.Callee), filter) != 0) continue;
+
+		Printf("%10.3f  %10.3f  %8u  %s -> %s\n", t.Inclusive * 1000, t.Exclusive * 1000, t.Calls, FunctionName(t.Caller), FunctionName(t.Callee));
+		count++;
+	}
+}
+
+//==========================================================================
+//
+// Writes the tree in the folded stack format flamegraph.pl, speedscope
+// and most other flame graph tools take: one line per call path with the
+// frames separated by semicolons, followed by the exclusive time in
+// microseconds.
+//
+//==========================================================================
+
+static bool SaveFoldedStacks(const char *filename)
+{
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(filename));
+	if (fw == nullptr) return false;
+
+	TArray<unsigned> path;
+	FString line;
+	for (unsigned i = 1; i < ProfileNodes.Size(); i++)
+	{
+		uint64_t usec = uint64_t(ProfileNodes[i].Exclusive * 1e6 + 0.5);
+		if (usec == 0) continue;
+
+		path.Clear();
+		for (unsigned n = i; n != 0; n = ProfileNodes[n].Parent) path.Push(n);
+
+		line = "";
+		for (unsigned j = path.Size(); j-- > 0; )
+		{
+			if (j != path.Size() - 1) line += ';';
+			for (const char *c = ProfileNodes[path[j]].Func->PrintableName.GetChars(); *c; c++)
+			{
+				line += (*c == ';' || *c == ' ') ? '_' : *c;
+			}
+		}
+		fw->Printf("%s %llu\n", line.GetChars(), (unsigned long long)usec);
+	}
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(vmprofile)
+{
+	const char *cmd = argv.argc() > 1 ? argv[1] : "";
+	unsigned limit = argv.argc() > 2 ? max(1, atoi(argv[2])) : 30;
+
+	if (!stricmp(cmd, "start"))
+	{
+		StartProfiling();
+		Printf("Profiling %u script functions\n", ProfiledFunctions.Size());
+	}
+	else if (!stricmp(cmd, "stop"))
+	{
+		StopProfiling();
+		Printf("Profiled %.3f ms, %u call paths\n", ProfilerTime.TimeMS(), ProfileNodes.Size() - 1);
+	}
+	else if (!stricmp(cmd, "excl") || !stricmp(cmd, "incl"))
+	{
+		PrintFunctions(limit, !stricmp(cmd, "incl"));
+	}
+	else if (!stricmp(cmd, "edges"))
+	{
+		PrintEdges(argv.argc() > 3 ? max(1, atoi(argv[3])) : 30, argv.argc() > 2 ? argv[2] : nullptr);
+	}
+	else if (!stricmp(cmd, "save") && argv.argc() > 2)
+	{
+		if (SaveFoldedStacks(argv[2])) Printf("Wrote %s\n", argv[2]);
+		else Printf(TEXTCOLOR_RED "Could not write %s\n", argv[2]);
+	}
+	else
+	{
+		Printf(
+			"Usage: vmprofile start\n"
+			"       vmprofile stop\n"
+			"       vmprofile excl|incl [limit]\n"
+			"       vmprofile edges [function [limit]]\n"
+			"       vmprofile save <file>\n\n"
+			TEXTCOLOR_YELLOW "excl  " TEXTCOLOR_NORMAL "functions by exclusive time\n"
+			TEXTCOLOR_YELLOW "incl  " TEXTCOLOR_NORMAL "functions by inclusive time\n"
+			TEXTCOLOR_YELLOW "edges " TEXTCOLOR_NORMAL "caller -> callee pairs by inclusive time, optionally only those involving one function\n"
+			TEXTCOLOR_YELLOW "save  " TEXTCOLOR_NORMAL "write folded stacks for flame graph tools, in microseconds\n");
+	}
+}
@@ -296,13 +296,9 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		HQnX_asm::InitLUTs();
-		initdone = true;
-	}
+	// The precacher may call this from several threads at once, so let the compiler guard the initialization.
+	static const bool initdone = (HQnX_asm::InitLUTs(), true);
+	(void)initdone;
 
 	HQnX_asm::CImage cImageIn;
 	cImageIn.SetImage(inputBuffer, inWidth, inHeight, 32);
@@ -323,13 +319,9 @@ static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*,
 							  int &outWidth,
 							  int &outHeight )
 {
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		hqxInit();
-		initdone = true;
-	}
+	// The precacher may call this from several threads at once, so let the compiler guard the initialization.
+	static const bool initdone = (hqxInit(), true);
+	(void)initdone;
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
@@ -47,6 +47,7 @@
 #include "m_swap.h"
 #include "c_cvars.h"
 #include "m_png.h"
+#include "parallel_for.h"
 
 
 // MACROS ------------------------------------------------------------------
@@ -61,6 +62,10 @@
 // determine, so that's why this is 0 here.
 #define USE_FILTER_HEURISTIC 0
 
+// Images whose filtered data is larger than this get compressed in
+// independent pieces of this size on multiple threads.
+#define PNG_PARALLEL_CHUNK	(128*1024)
+
 // TYPES -------------------------------------------------------------------
 
 struct IHDR
@@ -885,6 +890,147 @@ static int SelectFilter(Byte **row, Byte *prior, int width)
 #define SelectFilter(x,y,z)		0
 #endif
 
+//==========================================================================
+//
+// SaveBitmapParallel
+//
+// Compresses the image data in independent chunks, the same way pigz does.
+// Every chunk after the first one is primed with the last 32 KB of the
+// preceding input and all but the last one end with a sync flush, so the
+// pieces can simply be concatenated to form a single zlib stream. The
+// output does not depend on how many threads were used.
+//
+//==========================================================================
+
+static bool SaveBitmapParallel(const uint8_t *from, ESSType color_type, int width, int height, int pitch, FileWriter *file)
+{
+	struct Chunk
+	{
+		TArray<Byte> out;
+		uLong adler;
+		bool ok;
+	};
+
+	const size_t rowsize = 1 + size_t(width) * (color_type == SS_PAL ? 1 : 3);
+	const size_t total = rowsize * height;
+	const int numchunks = int((total + PNG_PARALLEL_CHUNK - 1) / PNG_PARALLEL_CHUNK);
+	const int level = png_level;
+	TArray<Byte> filtered(total, true);
+	TArray<Chunk> chunks(numchunks, true);
+
+	// Filter type 0 is used for every row, see SelectFilter.
+	parallel_for(height, [&](int y)
+	{
+		if (y >= height) return;
+		const uint8_t *in = from + ptrdiff_t(y) * pitch;
+		Byte *row = &filtered[rowsize * y];
+		*row++ = 0;
+		switch (color_type)
+		{
+		case SS_PAL:
+			memcpy(row, in, width);
+			break;
+
+		case SS_RGB:
+			memcpy(row, in, width * 3);
+			break;
+
+		case SS_BGRA:
+			for (int x = 0; x < width; ++x)
+			{
+				row[x*3 + 0] = in[x*4 + 2];
+				row[x*3 + 1] = in[x*4 + 1];
+				row[x*3 + 2] = in[x*4];
+			}
+			break;
+		}
+	});
+
+	parallel_for(numchunks, [&](int i)
+	{
+		if (i >= numchunks) return;
+		Chunk &chunk = chunks[i];
+		const size_t start = size_t(i) * PNG_PARALLEL_CHUNK;
+		const size_t len = std::min<size_t>(PNG_PARALLEL_CHUNK, total - start);
+		const bool last = i == numchunks - 1;
+		z_stream stream;
+
+		chunk.ok = false;
+		chunk.adler = adler32(adler32(0, Z_NULL, 0), &filtered[start], uInt(len));
+
+		stream.zalloc = Z_NULL;
+		stream.zfree = Z_NULL;
+		stream.opaque = Z_NULL;
+		if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			return;
+		}
+		if (i > 0)
+		{
+			size_t dictsize = std::min<size_t>(start, 32768);
+			deflateSetDictionary(&stream, &filtered[start - dictsize], uInt(dictsize));
+		}
+
+		chunk.out.Resize(unsigned(deflateBound(&stream, uLong(len)) + 16));
+		stream.next_in = &filtered[start];
+		stream.avail_in = uInt(len);
+		stream.next_out = chunk.out.Data();
+		stream.avail_out = chunk.out.Size();
+
+		for (;;)
+		{
+			int err = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+			if (err == Z_STREAM_END || (!last && err == Z_OK && stream.avail_in == 0 && stream.avail_out != 0))
+			{
+				chunk.ok = true;
+				break;
+			}
+			if (err != Z_OK && err != Z_BUF_ERROR)
+			{
+				break;
+			}
+			// Out of space, which should not happen with deflateBound's estimate.
+			unsigned used = chunk.out.Size() - stream.avail_out;
+			chunk.out.Resize(chunk.out.Size() * 2);
+			stream.next_out = chunk.out.Data() + used;
+			stream.avail_out = chunk.out.Size() - used;
+		}
+		chunk.out.Resize(chunk.out.Size() - stream.avail_out);
+		deflateEnd(&stream);
+	});
+
+	// Put the zlib header, the chunks and the checksum of the whole data together.
+	int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+	unsigned header = (0x78 << 8) | (flevel << 6);
+	header += 31 - header % 31;
+
+	TArray<Byte> stream;
+	stream.Push(Byte(header >> 8));
+	stream.Push(Byte(header));
+	uLong adler = adler32(0, Z_NULL, 0);
+	for (int i = 0; i < numchunks; i++)
+	{
+		if (!chunks[i].ok) return false;
+		unsigned pos = stream.Reserve(chunks[i].out.Size());
+		memcpy(&stream[pos], chunks[i].out.Data(), chunks[i].out.Size());
+		const size_t start = size_t(i) * PNG_PARALLEL_CHUNK;
+		adler = adler32_combine(adler, chunks[i].adler, z_off_t(std::min<size_t>(PNG_PARALLEL_CHUNK, total - start)));
+	}
+	stream.Push(Byte(adler >> 24));
+	stream.Push(Byte(adler >> 16));
+	stream.Push(Byte(adler >> 8));
+	stream.Push(Byte(adler));
+
+	for (unsigned pos = 0; pos < stream.Size(); pos += PNG_WRITE_SIZE)
+	{
+		if (!WriteIDAT(file, &stream[pos], std::min<int>(PNG_WRITE_SIZE, stream.Size() - pos)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // M_SaveBitmap
@@ -896,6 +1042,13 @@ static int SelectFilter(Byte **row, Byte *prior, int width)
 
 bool M_SaveBitmap(const uint8_t *from, ESSType color_type, int width, int height, int pitch, FileWriter *file)
 {
+#if !USE_FILTER_HEURISTIC
+	if ((1 + size_t(width) * (color_type == SS_PAL ? 1 : 3)) * height > PNG_PARALLEL_CHUNK)
+	{
+		return SaveBitmapParallel(from, color_type, width, height, pitch, file);
+	}
+#endif
+
 	TArray<Byte> temprow_storage;
 
 #if USE_FILTER_HEURISTIC
@@ -300,32 +300,24 @@ bool FTexture::SmoothEdges(unsigned char* buffer, int w, int h)
 	return trans || semitrans;
 }
 
-//===========================================================================
-// 
-// Post-process the texture data after the buffer has been created
-//
-//===========================================================================
-
-bool FTexture::ProcessData(unsigned char* buffer, int w, int h, bool ispatch)
-{
-	if (Masked)
-	{
-		Masked = SmoothEdges(buffer, w, h);
-		if (Masked && !ispatch) FindHoles(buffer, w, h);
-	}
-	return true;
-}
-
 //===========================================================================
 // 
 //	Initializes the buffer for the texture data
 //
+//  This is done in three steps so that the precacher can run the middle
+//  one, which is self contained, on worker threads:
+//
+//  LoadTexBuffer reads the image and must be called on the main thread.
+//  ProcessTexBuffer upscales the buffer and smoothes transparent edges.
+//  It only touches the passed buffer and can run anywhere.
+//  FinishTexBuffer stores the results on the texture, main thread only.
+//
 //===========================================================================
 void V_ApplyLuminosityTranslation(int translation, uint8_t *buffer, int size);
 
-FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
+int FTexture::LoadTexBuffer(FTextureBuffer &result, int translation, int flags)
 {
-	FTextureBuffer result;
+	int isTransparent = -1;
 	if (flags & CTF_Indexed)
 	{
 		// Indexed textures will never be translated and never be scaled.
@@ -344,7 +336,6 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 	{
 		unsigned char* buffer = nullptr;
 		int W, H;
-		int isTransparent = -1;
 		bool checkonly = !!(flags & CTF_CheckOnly);
 
 		int exx = !!(flags & CTF_Expand);
@@ -396,17 +387,97 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 		result.mBuffer = buffer;
 		result.mWidth = W;
 		result.mHeight = H;
+	}
+	return isTransparent;
+}
 
-		// Only do postprocessing for image-backed textures. (i.e. not for the burn texture which can also pass through here.)
-		if (GetImage() && flags & CTF_ProcessData)
-		{
-			if (flags & CTF_Upscale) CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
+bool FTexture::ProcessTexBuffer(FTextureBuffer &result, int flags, int isTransparent)
+{
+	// Only do postprocessing for image-backed textures. (i.e. not for the burn texture which can also pass through here.)
+	if (!(flags & CTF_Indexed) && GetImage() && (flags & CTF_ProcessData))
+	{
+		bool checkonly = !!(flags & CTF_CheckOnly);
+		if (flags & CTF_Upscale) CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
+		if (!checkonly && Masked) return SmoothEdges(result.mBuffer, result.mWidth, result.mHeight);
+	}
+	return Masked;
+}
 
-			if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
-		}
+void FTexture::FinishTexBuffer(FTextureBuffer &result, int flags, bool masked)
+{
+	if (!(flags & (CTF_Indexed | CTF_CheckOnly)) && GetImage() && (flags & CTF_ProcessData))
+	{
+		Masked = masked;
+		if (Masked) FindHoles(result.mBuffer, result.mWidth, result.mHeight);
 	}
+}
+
+FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
+{
+	FTextureBuffer result;
+	bool masked;
+
+	if (translation == 0 && TakePrecachedBuffer(result, flags, masked))
+	{
+		FinishTexBuffer(result, flags, masked);
+		return result;
+	}
+	int isTransparent = LoadTexBuffer(result, translation, flags);
+	masked = ProcessTexBuffer(result, flags, isTransparent);
+	FinishTexBuffer(result, flags, masked);
 	return result;
+}
+
+//===========================================================================
+// 
+// Buffers that were already created by the precacher and are waiting
+// to be picked up by the backend.
+//
+//===========================================================================
 
+struct FPrecachedTexBuffer
+{
+	uint8_t *Buffer;
+	int Width, Height;
+	uint64_t ContentId;
+	int Flags;
+	bool Masked;
+};
+
+static TMap<FTexture *, FPrecachedTexBuffer> PrecachedBuffers;
+
+void FTexture::AddPrecachedBuffer(FTextureBuffer &&buffer, int flags, bool masked)
+{
+	auto check = PrecachedBuffers.CheckKey(this);
+	if (check != nullptr) delete[] check->Buffer;
+	PrecachedBuffers[this] = { buffer.mBuffer, buffer.mWidth, buffer.mHeight, buffer.mContentId, flags, masked };
+	buffer.mBuffer = nullptr;
+}
+
+bool FTexture::TakePrecachedBuffer(FTextureBuffer &result, int flags, bool &masked)
+{
+	if (PrecachedBuffers.CountUsed() == 0) return false;
+	auto check = PrecachedBuffers.CheckKey(this);
+	if (check == nullptr || check->Flags != flags) return false;
+
+	result.mBuffer = check->Buffer;
+	result.mWidth = check->Width;
+	result.mHeight = check->Height;
+	result.mContentId = check->ContentId;
+	masked = check->Masked;
+	PrecachedBuffers.Remove(this);
+	return true;
+}
+
+void FTexture::FlushPrecachedBuffers()
+{
+	decltype(PrecachedBuffers)::Iterator it(PrecachedBuffers);
+	decltype(PrecachedBuffers)::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		delete[] pair->Value.Buffer;
+	}
+	PrecachedBuffers.Clear();
 }
 
 //===========================================================================
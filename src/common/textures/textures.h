@@ -287,6 +287,15 @@ public:
 
 public:
 	FTextureBuffer CreateTexBuffer(int translation, int flags = 0);
+	int LoadTexBuffer(FTextureBuffer &result, int translation, int flags);
+	bool ProcessTexBuffer(FTextureBuffer &result, int flags, int isTransparent);
+	void FinishTexBuffer(FTextureBuffer &result, int flags, bool masked);
+
+	// Untranslated buffers the precacher already created. CreateTexBuffer picks them up.
+	void AddPrecachedBuffer(FTextureBuffer &&buffer, int flags, bool masked);
+	bool TakePrecachedBuffer(FTextureBuffer &result, int flags, bool &masked);
+	static void FlushPrecachedBuffers();
+
 	virtual bool DetermineTranslucency();
 	bool GetTranslucency()
 	{
@@ -296,7 +305,6 @@ public:
 public:
 
 	void CheckTrans(unsigned char * buffer, int size, int trans);
-	bool ProcessData(unsigned char * buffer, int w, int h, bool ispatch);
 	int CheckRealHeight();
 
 	friend class FTextureManager;
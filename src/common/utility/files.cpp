@@ -33,6 +33,17 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <limits.h>
+
 #include "files.h"
 	// just for 'clamp'
 #include "zstring.h"
@@ -349,6 +360,87 @@ public:
 
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// reads data from a memory mapped file.
+//
+// The mapping is private and copy-on-write so that lump caches pointing
+// into it behave like the ones pointing into a memory array. Only pages
+// that actually get accessed are read from disk and the OS can drop
+// them again under memory pressure.
+//
+// Caution: On POSIX systems, accessing a page that is no longer backed
+// by the file, because another process truncated it while it was
+// mapped, raises SIGBUS instead of returning a read error. Windows
+// refuses to truncate files with mapped views, which breaks editors that
+// save in place. This is why the file system only maps archives when
+// asked to with -mmapfiles.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+public:
+	~MappedFileReader()
+	{
+		if (bufptr != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(bufptr);
+#else
+			munmap(const_cast<char *>(bufptr), Length);
+#endif
+		}
+		bufptr = nullptr;
+	}
+
+	bool IsMapped() const override
+	{
+		return true;
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileW(WideString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		void *view = nullptr;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.QuadPart <= LONG_MAX)
+		{
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping != nullptr)
+			{
+				view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				CloseHandle(mapping);	// the view keeps the mapping alive.
+			}
+		}
+		CloseHandle(file);
+		if (view == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		void *view = MAP_FAILED;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && info.st_size <= LONG_MAX && uint64_t(info.st_size) <= SIZE_MAX)
+		{
+			view = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);	// the mapping stays valid after closing the descriptor.
+		if (view == MAP_FAILED) return false;
+		Length = (long)info.st_size;
+#endif
+		bufptr = (const char *)view;
+		FilePos = 0;
+		return true;
+	}
+};
+
 //==========================================================================
 //
 // FileReader
@@ -370,6 +462,32 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+//==========================================================================
+//
+// Maps the entire file into memory if possible and falls back to regular
+// file access if not, e.g. for empty files or when running out of address
+// space on 32 bit systems.
+//
+// Only meant for IWADs and the add-on archives loaded into the file
+// system, and only used for those when -mmapfiles is given. See the
+// caveats above; anything the engine writes itself, like savegames,
+// must use OpenFile.
+//
+//==========================================================================
+
+bool FileReader::OpenMappedFile(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return OpenFile(filename);
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -71,6 +71,7 @@ public:
 	virtual long Read (void *buffer, long len) = 0;
 	virtual char *Gets(char *strbuf, int len) = 0;
 	virtual const char *GetBuffer() const { return nullptr; }
+	virtual bool IsMapped() const { return false; }
 	long GetLength () const { return Length; }
 };
 
@@ -168,11 +169,12 @@ public:
 	}
 
 	bool OpenFile(const char *filename, Size start = 0, Size length = -1);
+	bool OpenMappedFile(const char *filename);	// maps the file into memory, falls back to OpenFile if that is not possible. Only for game data the engine never writes to.
 	bool OpenFilePart(FileReader &parent, Size start, Size length);
 	bool OpenMemory(const void *mem, Size length);	// read directly from the buffer
 	bool OpenMemoryArray(const void *mem, Size length);	// read from a copy of the buffer.
 	bool OpenMemoryArray(std::function<bool(TArray<uint8_t>&)> getter);	// read contents to a buffer and return a reader to it
-	bool OpenDecompressor(FileReader &parent, Size length, int method, bool seekable, const std::function<void(const char*)>& cb);	// creates a decompressor stream. 'seekable' uses a buffered version so that the Seek and Tell methods can be used.
+	bool OpenDecompressor(FileReader &parent, Size length, int method, bool seekable, const std::function<void(const char*)>& cb, Size compressedlength = -1);	// creates a decompressor stream. 'seekable' uses a buffered version so that the Seek and Tell methods can be used.
 
 	Size Tell() const
 	{
@@ -224,6 +226,11 @@ public:
 		return mReader->GetBuffer();
 	}
 
+	bool IsMapped() const
+	{
+		return mReader->IsMapped();
+	}
+
 	Size GetLength() const
 	{
 		return mReader->GetLength();
@@ -105,12 +105,13 @@ class DecompressorZ : public DecompressorBase
 	enum { BUFF_SIZE = 4096 };
 
 	bool SawEOF;
+	FileReader::Size CompressedLeft;	// -1 if the size of the compressed data is not known
 	z_stream Stream;
 	uint8_t InBuff[BUFF_SIZE];
 
 public:
-	DecompressorZ (FileReader *file, bool zip, const std::function<void(const char*)>& cb)
-	: SawEOF(false)
+	DecompressorZ (FileReader *file, bool zip, FileReader::Size compressedlength, const std::function<void(const char*)>& cb)
+	: SawEOF(false), CompressedLeft(compressedlength)
 	{
 		int err;
 
@@ -156,6 +157,13 @@ public:
 			DecompressionError ("Corrupt zlib stream");
 		}
 
+		if (err == Z_STREAM_END && Stream.avail_in > 0 && File->GetBuffer() != nullptr)
+		{
+			// Give back what zlib did not consume so that the source is positioned right after the stream.
+			File->Seek(-(long)Stream.avail_in, FileReader::SeekCur);
+			Stream.avail_in = 0;
+		}
+
 		if (Stream.avail_out != 0)
 		{
 			DecompressionError ("Ran out of data in zlib stream");
@@ -166,6 +174,22 @@ public:
 
 	void FillBuffer ()
 	{
+		const char *buffer = File->GetBuffer();
+		if (buffer != nullptr)
+		{
+			// The source is in memory, so let zlib read the compressed data directly.
+			auto pos = File->Tell();
+			auto avail = File->GetLength() - pos;
+			if (CompressedLeft >= 0 && CompressedLeft < avail) avail = CompressedLeft;
+			avail = min<FileReader::Size>(avail, UINT_MAX);
+			File->Seek((long)avail, FileReader::SeekCur);
+			if (CompressedLeft >= 0) CompressedLeft -= avail;
+			SawEOF = true;
+			Stream.next_in = (Bytef *)(buffer + pos);
+			Stream.avail_in = (uInt)avail;
+			return;
+		}
+
 		auto numread = File->Read (InBuff, BUFF_SIZE);
 
 		if (numread < BUFF_SIZE)
@@ -605,7 +629,7 @@ public:
 };
 
 
-bool FileReader::OpenDecompressor(FileReader &parent, Size length, int method, bool seekable, const std::function<void(const char*)>& cb)
+bool FileReader::OpenDecompressor(FileReader &parent, Size length, int method, bool seekable, const std::function<void(const char*)>& cb, Size compressedlength)
 {
 	DecompressorBase *dec = nullptr;
 	FileReader *p = &parent;
@@ -613,7 +637,7 @@ bool FileReader::OpenDecompressor(FileReader &parent, Size length, int method, b
 	{
 		case METHOD_DEFLATE:
 		case METHOD_ZLIB:
-			dec = new DecompressorZ(p, method == METHOD_DEFLATE, cb);
+			dec = new DecompressorZ(p, method == METHOD_DEFLATE, compressedlength, cb);
 			break;
 
 		case METHOD_BZIP2:
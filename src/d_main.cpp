@@ -53,6 +53,7 @@
 #include "filesystem.h"
 #include "s_sound.h"
 #include "v_video.h"
+#include "v_capture.h"
 #include "intermission/intermission.h"
 #include "wipe.h"
 #include "m_argv.h"
@@ -119,6 +120,9 @@
 #include "hwrenderer/scene/hw_drawinfo.h"
 #include "doomfont.h"
 #include "screenjob.h"
+#include "file_indexcache.h"
+#include "i_specialpaths.h"
+#include "tracezones.h"
 
 #ifdef __unix__
 #include "i_system.h"  // for SHARE_DIR
@@ -294,6 +298,7 @@ CVAR (Bool, disableautoload, false, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBAL
 CVAR (Bool, autoloadbrightmaps, false, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
 CVAR (Bool, autoloadlights, false, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
 CVAR (Bool, autoloadwidescreen, true, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
+CVAR (Bool, fs_archiveindexcache, true, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
 CVAR (Bool, r_debug_disable_vis_filter, false, 0)
 CVAR(Bool, vid_fps, false, 0)
 CVAR(Int, vid_showpalette, 0, 0)
@@ -835,6 +840,7 @@ static void End2DAndUpdate()
 	twod->End();
 	CheckBench();
 	screen->Update();
+	V_CaptureFrame();
 	twod->OnFrameDone();
 }
 
@@ -848,6 +854,7 @@ static void End2DAndUpdate()
 
 void D_Display ()
 {
+	TRACE_ZONE("D_Display");
 	FTexture *wipestart = nullptr;
 	int wipe_type;
 	sector_t *viewsec;
@@ -1173,6 +1180,10 @@ void D_DoomLoop ()
 			}
 			I_SetFrameTime();
 
+			if (G_SoakTestPending())
+			{
+				G_RunSoakTest();
+			}
 			// process one or more tics
 			if (singletics)
 			{
@@ -1198,6 +1209,7 @@ void D_DoomLoop ()
 			// Update display, next frame, with current state.
 			I_StartTic ();
 			D_Display ();
+			Trace_EndFrame();
 			S_UpdateMusic();
 			if (wantToRestart)
 			{
@@ -3057,6 +3069,7 @@ static int D_InitGame(const FIWADInfo* iwad_info, TArray<FString>& allwads, TArr
 
 	bool allowduplicates = Args->CheckParm("-allowduplicates");
 	auto hashfile = D_GetHashFile();
+	fileSystem.SetMapFiles(!!Args->CheckParm("-mmapfiles"));
 	fileSystem.InitMultipleFiles (allwads, false, &lfi, allowduplicates, hashfile);
 	allwads.Clear();
 	allwads.ShrinkToFit();
@@ -3519,6 +3532,13 @@ static int D_DoomMain_Internal (void)
 
 	D_DoomInit();
 
+	if (fs_archiveindexcache)
+	{
+		FString path = M_GetCachePath(true);
+		CreatePath(path);
+		ArchiveIndexCache.SetFile(path + "/archiveindex.cache");
+	}
+
 	extern void D_ConfirmSendStats();
 	D_ConfirmSendStats();
 
@@ -3664,6 +3684,9 @@ void D_Cleanup()
 		G_CheckDemoStatus();
 	}
 
+	V_StopCapture();
+	V_FinishImageJobs();
+
 	// Music and sound should be stopped first
 	S_StopMusic(true);
 	S_ClearSoundData();
@@ -69,6 +69,7 @@
 #include "gstrings.h"
 #include "s_music.h"
 #include "screenjob.h"
+#include "tracezones.h"
 
 EXTERN_CVAR (Int, disableautosave)
 EXTERN_CVAR (Int, autosavecount)
@@ -1845,6 +1846,7 @@ static void TicStabilityEnd()
 //
 void TryRunTics (void)
 {
+	TRACE_ZONE("TryRunTics");
 	int 		i;
 	int 		lowtic;
 	int 		realtics;
@@ -2043,6 +2045,29 @@ void Net_NewMakeTic (void)
 	specials.NewMakeTic ();
 }
 
+//==========================================================================
+//
+// Net_PassLocalSpecials
+//
+// Hands the special ticcmds collected for the current tic straight to the
+// console player and marks the tic as received, like the loopback in
+// NetUpdate does. This is only for running tics synchronously without any
+// network updates, so that the regular loop can pick up afterwards.
+//
+//==========================================================================
+
+void Net_PassLocalSpecials ()
+{
+	if (specials.streamptr != NULL)
+	{
+		uint8_t *stream = specials.streamptr - specials.streamoffs;
+		NetSpecs[consoleplayer][(maketic/ticdup)%BACKUPTICS].SetData (stream, (int)specials.streamoffs);
+		specials.streamptr = stream;
+		specials.streamoffs = 0;
+	}
+	resendto[0] = nettics[0] = (maketic / ticdup) + 1;
+}
+
 void Net_WriteByte (uint8_t it)
 {
 	specials << it;
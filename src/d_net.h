@@ -64,6 +64,7 @@ void Net_CheckLastReceived(int);
 
 // [RH] Functions for making and using special "ticcmds"
 void Net_NewMakeTic ();
+void Net_PassLocalSpecials ();
 void Net_WriteByte (uint8_t);
 void Net_WriteWord (short);
 void Net_WriteLong (int);
@@ -88,6 +88,7 @@
 #include "hwrenderer/scene/hw_drawinfo.h"
 #include "doommenu.h"
 #include "screenjob.h"
+#include "stats.h"
 
 
 static FRandom pr_dmspawn ("DMSpawn");
@@ -2117,6 +2118,83 @@ void G_DoLoadGame ()
 	GC::StartCollection();
 }
 
+//==========================================================================
+//
+// Loads a savegame repeatedly with and without the indexed key lookup of
+// the serializer and checks that both produce the same level state.
+//
+//==========================================================================
+
+static FString SerializeCurrentLevel()
+{
+	FString out;
+	FDoomSerializer arc(primaryLevel);
+	if (arc.OpenWriter(false))
+	{
+		SaveVersion = SAVEVER;
+		primaryLevel->Serialize(arc, false);
+		unsigned len;
+		const char *text = arc.GetOutput(&len);
+		out = FString(text, len);
+	}
+	return out;
+}
+
+UNSAFE_CCMD(benchloadgame)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("usage: benchloadgame <filename> [repeat]\n");
+		return;
+	}
+	if (netgame || demoplayback)
+	{
+		Printf("cannot benchmark loading during a network game or demo\n");
+		return;
+	}
+	FString fname = argv[1];
+	DefaultExtension(fname, "." SAVEGAME_EXT);
+	int repeat = argv.argc() > 2 ? max(1, atoi(argv[2])) : 3;
+
+	FString state[2];
+	double times[2] = {};
+	try
+	{
+		for (int mode = 0; mode < 2; mode++)
+		{
+			FSerializer::IndexedKeyLookup = mode == 1;
+			for (int i = 0; i < repeat; i++)
+			{
+				cycle_t clock;
+				clock.Reset();
+				clock.Clock();
+				savename = fname;
+				gameaction = ga_loadgame;
+				G_DoLoadGame();
+				clock.Unclock();
+				times[mode] += clock.TimeMS();
+				if (gamestate != GS_LEVEL)
+				{
+					FSerializer::IndexedKeyLookup = true;
+					Printf("Unable to load %s\n", fname.GetChars());
+					return;
+				}
+			}
+			state[mode] = SerializeCurrentLevel();
+		}
+	}
+	catch (...)
+	{
+		// A broken savegame must not leave the slow lookup enabled for the rest of the session.
+		FSerializer::IndexedKeyLookup = true;
+		throw;
+	}
+	FSerializer::IndexedKeyLookup = true;
+
+	Printf("%s, %d loads each: member scan %.2f ms, indexed lookup %.2f ms per load\n", fname.GetChars(), repeat, times[0] / repeat, times[1] / repeat);
+	Printf("Level state after loading is %s\n", state[0].Compare(state[1]) == 0 ? "identical" : "different");
+}
+
 
 //
 // G_SaveGame
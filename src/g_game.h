@@ -75,6 +75,9 @@ void G_PlayDemo (char* name);
 void G_TimeDemo (const char* name);
 bool G_CheckDemoStatus (void);
 
+bool G_SoakTestPending ();
+void G_RunSoakTest ();
+
 void G_Ticker (void);
 bool G_Responder (event_t*	ev);
 
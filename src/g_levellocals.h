@@ -55,6 +55,11 @@
 #include "r_data/r_canvastexture.h"
 #include "r_data/r_interpolate.h"
 #include "doom_aabbtree.h"
+#include "p_soundgraph.h"
+#include "p_trace.h"
+#include "p_sightcache.h"
+#include "p_subsectorgrid.h"
+#include "p_flowfield.h"
 
 //============================================================================
 //
@@ -444,6 +449,8 @@ public:
 	TArray<node_t> nodes;
 	TArray<subsector_t> gamesubsectors;
 	TArray<node_t> gamenodes;
+	FSubsectorGrid GameSubsectorGrid;	// entry points into the tree for PointInSubsector
+	FSubsectorGrid RenderSubsectorGrid;	// and for PointInRenderSubsector
 	node_t *headgamenode;
 	TArray<uint8_t> rejectmatrix;
 	TArray<zone_t>	Zones;
@@ -481,6 +488,11 @@ public:
 	TMap<int, FHealthGroup> healthGroups;
 
 	FBlockmap blockmap;
+	FSoundGraph SoundGraph;
+	FFlowFields FlowFields;	// built on first use by monsters steering through flow fields
+	FTraceBatch HitscanBatch;	// shared by consecutive P_LineAttack calls from the same spot
+	unsigned GeometryChangeCounter = 0;	// incremented whenever planes, 3D floors, polyobjects or line blocking flags change
+	FSightCache RadiusSightCache;	// sight checks between explosions and their victims, valid for one tic
 	TArray<polyblock_t *> PolyBlockMap;
 	FUDMFKeyMap UDMFKeys[4];
 
@@ -0,0 +1,326 @@
+/*
+** g_soaktest.cpp
+** Runs a map with bots as fast as possible for benchmarking and
+** determinism checks
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The soak test starts a deathmatch on the given map with a fixed RNG
+** seed, adds bots and then runs game tics back to back, without drawing
+** anything or waiting for the clock. The console player gets empty
+** ticcmds, so nothing but the seed, the map and the bots decides what
+** happens. After every tic a checksum of the game state is made. Two runs
+** with the same parameters must produce the same checksums, on any build.
+**
+** To run it unattended, start with -soakquit to exit when it is done:
+**   gzdoom -iwad doom2.wad -soakquit +soaktest map01 7 35000 1234 soak.txt
+**
+*/
+
+#include <memory>
+#include "c_dispatch.h"
+#include "c_console.h"
+#include "menu.h"
+#include "g_game.h"
+#include "g_level.h"
+#include "g_levellocals.h"
+#include "d_net.h"
+#include "d_main.h"
+#include "d_event.h"
+#include "doomstat.h"
+#include "m_random.h"
+#include "m_argv.h"
+#include "p_setup.h"
+#include "files.h"
+#include "stats.h"
+#include "i_time.h"
+#include "engineerrors.h"
+#include "actor.h"
+#include "b_bot.h"
+
+static struct
+{
+	bool Pending;
+	FString Map;
+	int Bots;
+	int Tics;
+	uint32_t Seed;
+	FString ChecksumFile;
+	uint32_t SavedStaticSeed;
+	bool SavedUseStatic;
+	int SavedDeathmatch;
+	bool SavedMultiplayerNext;
+} SoakTest;
+
+enum
+{
+	SOAK_JOIN_TIMEOUT = 10 * TICRATE,
+};
+
+//==========================================================================
+//
+// Hashes everything that differs first when a game goes out of sync:
+// the actors' positions, angles and health and the state of the RNGs.
+//
+//==========================================================================
+
+static uint64_t SoakChecksum(FLevelLocals *Level)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&](uint64_t v)
+	{
+		hash = (hash ^ v) * 1099511628211ull;
+		hash ^= hash >> 29;
+	};
+	auto mixd = [&](double d)
+	{
+		uint64_t v;
+		memcpy(&v, &d, sizeof(v));
+		mix(v);
+	};
+
+	auto it = Level->GetThinkerIterator<AActor>();
+	AActor *mo;
+	while ((mo = it.Next()))
+	{
+		mixd(mo->X());
+		mixd(mo->Y());
+		mixd(mo->Z());
+		mix(mo->Angles.Yaw.BAMs());
+		mix(uint32_t(mo->health));
+	}
+	mix(FRandom::StaticChecksum());
+	mix(Level->maptime);
+	return hash;
+}
+
+//==========================================================================
+//
+// One tic the way the singletics path in D_DoomLoop runs it, but without
+// any input or sound update.
+//
+//==========================================================================
+
+static void SoakTic()
+{
+	// FlushBufferedTics made maketic catch up with gametic, so this is the
+	// slot G_Ticker is about to read.
+	memset(&netcmds[consoleplayer][(gametic / ticdup) % BACKUPTICS], 0, sizeof(ticcmd_t));
+	Net_PassLocalSpecials();
+	G_Ticker();
+	gametic++;
+	maketic++;
+	GC::CheckGC();
+	Net_NewMakeTic();
+}
+
+//==========================================================================
+//
+// Throws away the input and specials that were made before the test but
+// have not been run yet, so that none of them can play back during it.
+//
+//==========================================================================
+
+static void FlushBufferedTics()
+{
+	Net_PassLocalSpecials();
+	for (int tic = gametic; tic <= maketic && tic < gametic + BACKUPTICS; tic++)
+	{
+		int buf = (tic / ticdup) % BACKUPTICS;
+		memset(&netcmds[consoleplayer][buf], 0, sizeof(ticcmd_t));
+		NetSpecs[consoleplayer][buf].SetData(nullptr, 0);
+	}
+	maketic = gametic;
+}
+
+static int CountBots()
+{
+	int count = 0;
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		if (playeringame[i] && players[i].Bot != nullptr) count++;
+	}
+	return count;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool G_SoakTestPending()
+{
+	return SoakTest.Pending;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void RunSoakTest()
+{
+	C_HideConsole();
+	M_ClearMenus();
+	paused = 0;
+	FlushBufferedTics();
+	Net_NewMakeTic();
+
+	// The new game gets started by the first tic.
+	int tics = 0;
+	do
+	{
+		SoakTic();
+	} while ((gameaction != ga_nothing || gamestate != GS_LEVEL) && ++tics < SOAK_JOIN_TIMEOUT);
+
+	staticrngseed = SoakTest.SavedStaticSeed;
+	use_staticrng = SoakTest.SavedUseStatic;
+
+	if (gamestate != GS_LEVEL || primaryLevel->MapName.CompareNoCase(SoakTest.Map) != 0)
+	{
+		Printf("Soak test: could not start %s\n", SoakTest.Map.GetChars());
+		return;
+	}
+
+	for (int i = 0; i < SoakTest.Bots; i++)
+	{
+		primaryLevel->BotInfo.SpawnBot(nullptr);
+	}
+	for (tics = 0; CountBots() < SoakTest.Bots && tics < SOAK_JOIN_TIMEOUT; tics++)
+	{
+		SoakTic();
+	}
+	int bots = CountBots();
+
+	std::unique_ptr<FileWriter> fw;
+	if (SoakTest.ChecksumFile.IsNotEmpty())
+	{
+		fw.reset(FileWriter::Open(SoakTest.ChecksumFile.GetChars()));
+		if (fw == nullptr) Printf("Soak test: could not write %s\n", SoakTest.ChecksumFile.GetChars());
+	}
+
+	cycle_t time;
+	time.Reset();
+	uint64_t combined = 0;
+	for (tics = 0; tics < SoakTest.Tics && gamestate == GS_LEVEL; tics++)
+	{
+		time.Clock();
+		SoakTic();
+		time.Unclock();
+
+		uint64_t sum = SoakChecksum(primaryLevel);
+		combined = (combined ^ sum) * 1099511628211ull;
+		if (fw != nullptr) fw->Printf("%d %016llx\n", primaryLevel->maptime, (unsigned long long)sum);
+	}
+
+	double seconds = time.Time();
+	Printf("Soak test: %s, %d bots, seed %u\n", SoakTest.Map.GetChars(), bots, SoakTest.Seed);
+	Printf("%d tics in %.3f s, %.1f tics/s, %.3f ms/tic\n", tics, seconds, seconds > 0 ? tics / seconds : 0., tics > 0 ? seconds * 1000 / tics : 0.);
+	Printf("Checksum %016llx\n", (unsigned long long)combined);
+	if (tics < SoakTest.Tics) Printf("The level was left after %d tics\n", tics);
+}
+
+// Games started after the test should not be deathmatches.
+static void RestoreSettings()
+{
+	deathmatch = SoakTest.SavedDeathmatch;
+	multiplayernext = SoakTest.SavedMultiplayerNext;
+}
+
+void G_RunSoakTest()
+{
+	SoakTest.Pending = false;
+
+	// Keep the regular loop from trying to catch up on the time spent here.
+	I_FreezeTime(true);
+	try
+	{
+		RunSoakTest();
+	}
+	catch (...)
+	{
+		I_FreezeTime(false);
+		RestoreSettings();
+		throw;
+	}
+	I_FreezeTime(false);
+	RestoreSettings();
+
+	if (Args->CheckParm("-soakquit")) throw CExitEvent(0);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(soaktest)
+{
+	if (argv.argc() < 4)
+	{
+		Printf("Usage: soaktest <map> <bots> <tics> [seed] [checksum file]\n");
+		return;
+	}
+	if (netgame)
+	{
+		Printf("The soak test cannot be run in a network game\n");
+		return;
+	}
+	if (SoakTest.Pending)
+	{
+		Printf("A soak test is already about to start\n");
+		return;
+	}
+	if (!P_CheckMapData(argv[1]))
+	{
+		Printf("No map %s\n", argv[1]);
+		return;
+	}
+
+	SoakTest.Map = argv[1];
+	SoakTest.Bots = clamp(atoi(argv[2]), 0, MAXPLAYERS - 1);
+	SoakTest.Tics = max(1, atoi(argv[3]));
+	SoakTest.Seed = argv.argc() > 4 ? (uint32_t)strtoul(argv[4], nullptr, 0) : 0;
+	SoakTest.ChecksumFile = argv.argc() > 5 ? argv[5] : "";
+
+	// G_InitNew picks these up.
+	SoakTest.SavedStaticSeed = staticrngseed;
+	SoakTest.SavedUseStatic = use_staticrng;
+	staticrngseed = SoakTest.Seed;
+	use_staticrng = true;
+	SoakTest.SavedDeathmatch = deathmatch;
+	SoakTest.SavedMultiplayerNext = multiplayernext;
+	deathmatch = 1;
+	multiplayernext = true;
+	G_DeferedInitNew(SoakTest.Map.GetChars());
+	SoakTest.Pending = true;
+}
@@ -40,6 +40,7 @@ struct FBlockmap
 	double				bmaporgx;
 	double				bmaporgy;		// origin of block map
 	FBlockNode**		blocklinks; 	// for thing chains
+	unsigned*			blockchanges = nullptr;	// per block, changes whenever an actor gets linked into or unlinked from it
 
 	// mapblocks are used to check movement
 	// against lines and things
@@ -87,6 +88,11 @@ struct FBlockmap
 			delete[] blocklinks;
 			blocklinks = nullptr;
 		}
+		if (blockchanges != nullptr)
+		{
+			delete[] blockchanges;
+			blockchanges = nullptr;
+		}
 	}
 
 	~FBlockmap()
@@ -66,6 +66,7 @@
 
 #include "gameconfigfile.h"
 #include "gstrings.h"
+#include "v_capture.h"
 
 FGameConfigFile *GameConfig;
 
@@ -505,17 +506,14 @@ void WritePCXfile (FileWriter *file, const uint8_t *buffer, const PalEntry *pale
 //
 // WritePNGfile
 //
-void WritePNGfile (FileWriter *file, const uint8_t *buffer, const PalEntry *palette,
+bool WritePNGfile (FileWriter *file, const uint8_t *buffer, const PalEntry *palette,
 				   ESSType color_type, int width, int height, int pitch, float gamma)
 {
 	char software[100];
 	mysnprintf(software, countof(software), GAMENAME " %s", GetVersionString());
-	if (!M_CreatePNG (file, buffer, palette, color_type, width, height, pitch, gamma) ||
-		!M_AppendPNGText (file, "Software", software) ||
-		!M_FinishPNG (file))
-	{
-		Printf ("%s\n", GStrings("TXT_SCREENSHOTERR"));
-	}
+	return M_CreatePNG (file, buffer, palette, color_type, width, height, pitch, gamma) &&
+		M_AppendPNGText (file, "Software", software) &&
+		M_FinishPNG (file);
 }
 
 
@@ -621,24 +619,33 @@ void M_ScreenShot (const char *filename)
 			Printf ("Could not open %s\n", autoname.GetChars());
 			return;
 		}
-		if (writepcx)
-		{
-			WritePCXfile(file, buffer.Data(), nullptr, color_type,
-				screen->GetWidth(), screen->GetHeight(), pitch);
-		}
-		else
-		{
-			WritePNGfile(file, buffer.Data(), nullptr, color_type,
-				screen->GetWidth(), screen->GetHeight(), pitch, gamma);
-		}
-		delete file;
 
+		// The file gets created right away so that FindFreeName will not pick
+		// the same name again, but everything else happens on the writer thread.
+		FString message, error = GStrings("TXT_SCREENSHOTERR");
 		if (!screenshot_quiet)
 		{
 			ptrdiff_t slash = -1;
 			if (!longsavemessages) slash = autoname.LastIndexOfAny(":/\\");
-			Printf ("Captured %s\n", autoname.GetChars()+slash+1);
+			message.Format("Captured %s", autoname.GetChars()+slash+1);
 		}
+		int width = screen->GetWidth(), height = screen->GetHeight();
+		V_QueueImageJob([=, buffer = std::move(buffer)]()
+		{
+			bool ok = true;
+			if (writepcx)
+			{
+				WritePCXfile(file, buffer.Data(), nullptr, color_type, width, height, pitch);
+			}
+			else
+			{
+				ok = WritePNGfile(file, buffer.Data(), nullptr, color_type, width, height, pitch, gamma);
+			}
+			delete file;
+
+			if (!ok) V_PostImageMessage(error);
+			else if (message.IsNotEmpty()) V_PostImageMessage(message);
+		});
 	}
 	else
 	{
@@ -2646,6 +2646,8 @@ void MapLoader::LoadBlockMap (MapData * map)
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
 	Level->blockmap.blocklinks = new FBlockNode *[count];
 	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.blockchanges = new unsigned[count];
+	memset (Level->blockmap.blockchanges, 0, count*sizeof(*Level->blockmap.blockchanges));
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
@@ -3177,6 +3179,8 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	
 	// set the head node for gameplay purposes. If the separate gamenodes array is not empty, use that, otherwise use the render nodes.
 	Level->headgamenode = Level->gamenodes.Size() > 0 ? &Level->gamenodes[Level->gamenodes.Size() - 1] : Level->nodes.Size() ? &Level->nodes[Level->nodes.Size() - 1] : nullptr;
+	Level->RenderSubsectorGrid.Build(Level, Level->HeadNode());
+	Level->GameSubsectorGrid.Build(Level, Level->headgamenode);
 
 	LoadBlockMap(map);
 
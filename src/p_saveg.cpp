@@ -1058,6 +1058,9 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 		localEventManager->SetOwnerForHandlers();	// This cannot be automated.
 		RecreateAllAttachedLights();
 		InitPortalGroups(this);
+		SoundGraph.Clear();
+		FlowFields.Clear();
+		RadiusSightCache.Clear();
 
 		auto it = GetThinkerIterator<DImpactDecal>(NAME_None, STAT_AUTODECAL);
 		ImpactDecalCount = 0;
@@ -350,6 +350,13 @@ void FLevelLocals::ClearLevelData()
 	rejectmatrix.Clear();
 	Zones.Clear();
 	blockmap.Clear();
+	SoundGraph.Clear();
+	FlowFields.Clear();
+	HitscanBatch.Clear();
+	DLineTracerBatch::ClearLevel(this);
+	RadiusSightCache.Clear();
+	GameSubsectorGrid.Clear();
+	RenderSubsectorGrid.Clear();
 	Polyobjects.Clear();
 
 	for (auto &pb : PolyBlockMap)
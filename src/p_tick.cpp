@@ -38,6 +38,7 @@
 #include "events.h"
 #include "actorinlines.h"
 #include "g_game.h"
+#include "tracezones.h"
 
 extern gamestate_t wipegamestate;
 extern uint8_t globalfreeze, globalchangefreeze;
@@ -76,6 +77,7 @@ bool P_CheckTickerPaused ()
 //
 void P_Ticker (void)
 {
+	TRACE_ZONE("P_Ticker");
 	int i;
 
 	for (auto Level : AllLevels())
@@ -64,6 +64,7 @@
 #include "a_dynlight.h"
 #include "actorinlines.h"
 #include "memarena.h"
+#include "parallel_for.h"
 
 static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
@@ -209,6 +210,7 @@ void FDynamicLight::ReleaseLight()
 	else Level->lights = next;
 	if (next != nullptr) next->prev = prev;
 	next = prev = nullptr;
+	linkpending = false;
 	FreeList.Push(this);
 }
 
@@ -416,32 +418,17 @@ void FDynamicLight::UpdateLocation()
 //
 // These have been copied from the secnode code and modified for the light links
 //
-// P_AddSecnode() searches the current list to see if this sector is
-// already there. If not, it adds a sector node at the head of the list of
-// sectors this object appears in. This is called when creating a list of
-// nodes that will get linked in later. Returns a pointer to the new node.
+// AddLightNode() adds a light node at the head of the list of targets this
+// light touches and at the head of the target's list of lights.
+// Unlike P_AddSecnode() this does not search the list for an existing node.
+// The caller has to know that the target is not in it yet.
+// Returns a pointer to the new node.
 //
 //=============================================================================
 
-FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * light, FLightNode *& nextnode)
+static FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * light, FLightNode *& nextnode)
 {
-	FLightNode * node;
-
-	node = nextnode;
-	while (node)
-    {
-		if (node->targ==linkto)   // Already have a node for this sector?
-		{
-			node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
-			return(nextnode);
-		}
-		node = node->nextTarget;
-    }
-
-	// Couldn't find an existing node for this sector. Add one at the head
-	// of the list.
-	
-	node = new FLightNode;
+	FLightNode * node = new FLightNode;
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -522,23 +509,86 @@ double FDynamicLight::DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *
 
 //==========================================================================
 //
-// Collect all touched sidedefs and subsectors
-// to sidedefs and sector parts.
+// The result of collecting a light's targets. The collection only reads
+// level data, so it can run on worker threads. The result then gets merged
+// into the node lists on the main thread.
 //
 //==========================================================================
+
+struct FLightLinkResult
+{
+	TArray<FSection *> sections;
+	TArray<side_t *> sides;
+	bool flooded;
+	bool hitonesidedback;
+};
+
 struct LightLinkEntry
 {
 	FSection *sect;
 	DVector3 pos;
 };
-static TArray<LightLinkEntry> collected_ss;
 
-void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius)
+//==========================================================================
+//
+// Per thread working data for the collection. Sections and lines get
+// marked in here instead of in their validcount fields so that multiple
+// lights can be collected at the same time.
+//
+// The flood needs two independent section marks, one for sections reached
+// through a line portal and one for all others. Each collection uses two
+// consecutive stamp values for them.
+//
+//==========================================================================
+
+struct FLightLinkScratch
+{
+	TArray<LightLinkEntry> collected;
+	TArray<unsigned> sectionmarks;
+	TArray<unsigned> linemarks;
+	unsigned stamp = 0;
+
+	void Prepare(FLevelLocals *Level)
+	{
+		unsigned numsections = Level->sections.allSections.Size();
+		unsigned numlines = Level->lines.Size();
+
+		if (sectionmarks.Size() != numsections || linemarks.Size() != numlines || stamp >= UINT_MAX - 4)
+		{
+			sectionmarks.Resize(numsections);
+			linemarks.Resize(numlines);
+			if (numsections > 0) memset(sectionmarks.Data(), 0, numsections * sizeof(unsigned));
+			if (numlines > 0) memset(linemarks.Data(), 0, numlines * sizeof(unsigned));
+			stamp = 0;
+		}
+		stamp += 2;
+	}
+};
+
+static thread_local FLightLinkScratch LinkScratch;
+
+//==========================================================================
+//
+// Collect all touched sidedefs and subsectors
+// to sidedefs and sector parts.
+//
+//==========================================================================
+
+void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius, FLightLinkResult &result) const
 {
 	if (!section) return;
+
+	auto &scratch = LinkScratch;
+	scratch.Prepare(Level);
+	const unsigned dlmark = scratch.stamp;		// replaces dl_validcount
+	const unsigned vcmark = scratch.stamp + 1;	// replaces ::validcount
+	auto &sectionmarks = scratch.sectionmarks;
+	auto &linemarks = scratch.linemarks;
+	auto &collected_ss = scratch.collected;
+
 	collected_ss.Clear();
 	collected_ss.Push({ section, opos });
-	section->validcount = dl_validcount;
+	sectionmarks[Level->sections.SectionIndex(section)] = dlmark;
 
 	bool hitonesidedback = false;
 	for (unsigned i = 0; i < collected_ss.Size(); i++)
@@ -546,19 +596,19 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 		auto pos = collected_ss[i].pos;
 		section = collected_ss[i].sect;
 
-		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
+		result.sections.Push(section);
 
 
 		auto processSide = [&](side_t *sidedef, const vertex_t *v1, const vertex_t *v2)
 		{
 			auto linedef = sidedef->linedef;
-			if (linedef && linedef->validcount != ::validcount)
+			if (linedef && linemarks[linedef->Index()] != vcmark)
 			{
 				// light is in front of the seg
 				if ((pos.Y - v1->fY()) * (v2->fX() - v1->fX()) + (v1->fX() - pos.X) * (v2->fY() - v1->fY()) <= 0)
 				{
-					linedef->validcount = ::validcount;
-					touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+					linemarks[linedef->Index()] = vcmark;
+					result.sides.Push(sidedef);
 				}
 				else if (linedef->sidedef[0] == sidedef && linedef->sidedef[1] == nullptr)
 				{
@@ -571,13 +621,14 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				if (port && port->mType == PORTT_LINKED)
 				{
 					line_t *other = port->mDestination;
-					if (other->validcount != ::validcount)
+					if (linemarks[other->Index()] != vcmark)
 					{
 						subsector_t *othersub = Level->PointInRenderSubsector(other->v1->fPos() + other->Delta() / 2);
 						FSection *othersect = othersub->section;
-						if (othersect->validcount != ::validcount)
+						unsigned &mark = sectionmarks[Level->sections.SectionIndex(othersect)];
+						if (mark != vcmark)
 						{
-							othersect->validcount = ::validcount;
+							mark = vcmark;
 							collected_ss.Push({ othersect, PosRelative(other->frontsector->PortalGroup) });
 						}
 					}
@@ -601,10 +652,14 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				if (partner)
 				{
 					FSection *sect = partner->section;
-					if (sect != nullptr && sect->validcount != dl_validcount)
+					if (sect != nullptr)
 					{
-						sect->validcount = dl_validcount;
-						collected_ss.Push({ sect, pos });
+						unsigned &mark = sectionmarks[Level->sections.SectionIndex(sect)];
+						if (mark != dlmark)
+						{
+							mark = dlmark;
+							collected_ss.Push({ sect, pos });
+						}
 					}
 				}
 			}
@@ -626,9 +681,10 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::ceiling);
 				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
 				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				unsigned &mark = sectionmarks[Level->sections.SectionIndex(othersect)];
+				if (mark != dlmark)
 				{
-					othersect->validcount = dl_validcount;
+					mark = dlmark;
 					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
 				}
 			}
@@ -641,56 +697,126 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::floor);
 				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
 				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				unsigned &mark = sectionmarks[Level->sections.SectionIndex(othersect)];
+				if (mark != dlmark)
 				{
-					othersect->validcount = dl_validcount;
+					mark = dlmark;
 					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
 				}
 			}
 		}
 	}
-	shadowmapped = hitonesidedback && !DontShadowmap();
+	result.flooded = true;
+	result.hitonesidedback = hitonesidedback;
 }
 
 //==========================================================================
 //
-// Link the light into the world
+// Finds everything the light touches at its current position.
+// Safe to be called from worker threads.
 //
 //==========================================================================
 
-void FDynamicLight::LinkLight()
+void FDynamicLight::CollectLinks(FLightLinkResult &result) const
 {
-	// mark the old light nodes
-	FLightNode * node;
-	
-	node = touching_sides;
-	while (node)
-    {
-		node->lightsource = nullptr;
-		node = node->nextTarget;
-    }
-	node = touching_sector;
-	while (node)
-	{
-		node->lightsource = nullptr;
-		node = node->nextTarget;
-	}
+	result.sections.Clear();
+	result.sides.Clear();
+	result.flooded = false;
+	result.hitonesidedback = false;
 
 	if (radius>0)
 	{
 		// passing in radius*radius allows us to do a distance check without any calls to sqrt
 		FSection *sect = Level->PointInRenderSubsector(Pos)->section;
+		CollectWithinRadius(Pos, sect, float(radius*radius), result);
+	}
+}
 
-		dl_validcount++;
-		::validcount++;
-		CollectWithinRadius(Pos, sect, float(radius*radius));
+//==========================================================================
+//
+// Updates the light's node lists to a collection result.
+//
+// Nodes for targets that are still being touched are kept, new ones get
+// added and the rest gets deleted. This produces exactly the same lists
+// as rebuilding them from scratch but instead of searching the light's
+// node list for every target the existing nodes are looked up by index.
+//
+//==========================================================================
+
+static TArray<FLightNode *> SideNodes, SectionNodes;
+static TArray<unsigned> SideNodeMarks, SectionNodeMarks;
+static unsigned NodeMark;
+
+void FDynamicLight::MergeLinks(const FLightLinkResult &result)
+{
+	unsigned numsides = Level->sides.Size();
+	unsigned numsections = Level->sections.allSections.Size();
 
+	if (SideNodeMarks.Size() != numsides || SectionNodeMarks.Size() != numsections || NodeMark == UINT_MAX)
+	{
+		SideNodes.Resize(numsides);
+		SideNodeMarks.Resize(numsides);
+		SectionNodes.Resize(numsections);
+		SectionNodeMarks.Resize(numsections);
+		if (numsides > 0) memset(SideNodeMarks.Data(), 0, numsides * sizeof(unsigned));
+		if (numsections > 0) memset(SectionNodeMarks.Data(), 0, numsections * sizeof(unsigned));
+		NodeMark = 0;
 	}
-		
+	NodeMark++;
+
+	// mark the old light nodes
+	for (FLightNode *node = touching_sides; node; node = node->nextTarget)
+	{
+		int index = node->targLine->Index();
+		node->lightsource = nullptr;
+		SideNodes[index] = node;
+		SideNodeMarks[index] = NodeMark;
+	}
+	for (FLightNode *node = touching_sector; node; node = node->nextTarget)
+	{
+		int index = Level->sections.SectionIndex((FSection *)node->targ);
+		node->lightsource = nullptr;
+		SectionNodes[index] = node;
+		SectionNodeMarks[index] = NodeMark;
+	}
+
+	for (auto section : result.sections)
+	{
+		int index = Level->sections.SectionIndex(section);
+		if (SectionNodeMarks[index] == NodeMark)
+		{
+			SectionNodes[index]->lightsource = this;	// Setting lightsource says 'keep it'.
+		}
+		else
+		{
+			touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
+			SectionNodes[index] = touching_sector;
+			SectionNodeMarks[index] = NodeMark;
+		}
+	}
+	for (auto sidedef : result.sides)
+	{
+		int index = sidedef->Index();
+		if (SideNodeMarks[index] == NodeMark)
+		{
+			SideNodes[index]->lightsource = this;
+		}
+		else
+		{
+			touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+			SideNodes[index] = touching_sides;
+			SideNodeMarks[index] = NodeMark;
+		}
+	}
+	if (result.flooded)
+	{
+		shadowmapped = result.hitonesidedback && !DontShadowmap();
+	}
+
 	// Now delete any nodes that won't be used. These are the ones where
-	// m_thing is still nullptr.
+	// lightsource is still nullptr.
 	
-	node = touching_sides;
+	FLightNode *node = touching_sides;
 	while (node)
 	{
 		if (node->lightsource == nullptr)
@@ -713,6 +839,96 @@ void FDynamicLight::LinkLight()
 	}
 }
 
+//==========================================================================
+//
+// Link the light into the world
+//
+// While the dynamic lights get ticked the work is only queued up and
+// done in FinishLinking.
+//
+//==========================================================================
+
+static TArray<FDynamicLight *> LinkQueue;
+static TArray<FLightLinkResult> LinkResults;
+static bool LinkQueueActive;
+
+enum
+{
+	MIN_PARALLEL_LINKS = 32		// below this the thread overhead outweighs the gain
+};
+
+void FDynamicLight::LinkLight()
+{
+	if (LinkQueueActive)
+	{
+		if (!linkpending)
+		{
+			linkpending = true;
+			LinkQueue.Push(this);
+		}
+		return;
+	}
+
+	static FLightLinkResult result;
+	CollectLinks(result);
+	MergeLinks(result);
+}
+
+//==========================================================================
+//
+// Batched linking of all lights that moved during a tic.
+//
+// The targets of all queued lights get collected in parallel if there are
+// enough of them. Merging the results into the node lists has to happen
+// in the order the lights were queued so that the lists come out the same
+// as when linking each light directly.
+//
+//==========================================================================
+
+void FDynamicLight::BeginLinking()
+{
+	LinkQueueActive = true;
+}
+
+void FDynamicLight::FinishLinking()
+{
+	LinkQueueActive = false;
+
+	// Lights that got released or unlinked in the mean time are not pending anymore.
+	// A light may also be in here twice if it was released and reused.
+	unsigned count = 0;
+	for (auto light : LinkQueue)
+	{
+		if (light->linkpending)
+		{
+			light->linkpending = false;
+			LinkQueue[count++] = light;
+		}
+	}
+	LinkQueue.Clamp(count);
+	if (LinkResults.Size() < count) LinkResults.Resize(count);
+
+	auto collect = [=](int i)
+	{
+		if (unsigned(i) < count) LinkQueue[i]->CollectLinks(LinkResults[i]);
+	};
+
+	if (count >= MIN_PARALLEL_LINKS)
+	{
+		parallel_for(int(count), collect);
+	}
+	else
+	{
+		for (unsigned i = 0; i < count; i++) collect(i);
+	}
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		LinkQueue[i]->MergeLinks(LinkResults[i]);
+	}
+	LinkQueue.Clear();
+}
+
 
 //==========================================================================
 //
@@ -724,6 +940,7 @@ void FDynamicLight::UnlinkLight ()
 	while (touching_sides) touching_sides = DeleteLightNode(touching_sides);
 	while (touching_sector) touching_sector = DeleteLightNode(touching_sector);
 	shadowmapped = false;
+	linkpending = false;
 }
 
 //==========================================================================
@@ -9,6 +9,7 @@ struct seg_t;
 
 class FSerializer;
 struct FSectionLine;
+struct FLightLinkResult;
 
 enum ELightType
 {
@@ -239,9 +240,15 @@ struct FDynamicLight
 	void UnlinkLight();
 	void ReleaseLight();
 
+	// Defers linking of all lights until FinishLinking is called.
+	static void BeginLinking();
+	static void FinishLinking();
+
 private:
-	double DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *end);
-	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius);
+	static double DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *end);
+	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius, FLightLinkResult &result) const;
+	void CollectLinks(FLightLinkResult &result) const;
+	void MergeLinks(const FLightLinkResult &result);
 
 public:
 	FCycler m_cycler;
@@ -275,6 +282,7 @@ public:
 	bool owned;
 	bool swapped;
 	bool explicitpitch;
+	bool linkpending;		// queued for FinishLinking
 
 };
 
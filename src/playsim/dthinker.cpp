@@ -45,6 +45,8 @@
 #include "v_video.h"
 #include "g_cvars.h"
 #include "d_main.h"
+#include "tracezones.h"
+#include "p_spec_thinkers.h"
 
 static int ThinkCount;
 static cycle_t ThinkCycles;
@@ -98,6 +100,7 @@ void FThinkerCollection::Link(DThinker *thinker, int statnum)
 
 void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 {
+	TRACE_ZONE("RunThinkers");
 	int i, count;
 
 	ThinkCount = 0;
@@ -160,12 +163,14 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		recreateLights();
 		if (dolights)
 		{
+			FDynamicLight::BeginLinking();
 			for (auto light = Level->lights; light;)
 			{
 				auto next = light->next;
 				light->Tick();
 				light = next;
 			}
+			FDynamicLight::FinishLinking();
 		}
 	}
 	else
@@ -193,6 +198,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			// Also profile the internal dynamic lights, even though they are not implemented as thinkers.
 			auto &prof = Profiles[NAME_InternalDynamicLight];
 			prof.timer.Clock();
+			FDynamicLight::BeginLinking();
 			for (auto light = Level->lights; light;)
 			{
 				prof.numcalls++;
@@ -200,6 +206,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 				light->Tick();
 				light = next;
 			}
+			FDynamicLight::FinishLinking();
 			prof.timer.Unclock();
 		}
 
@@ -582,6 +589,8 @@ void FThinkerList::SaveList(FSerializer &arc)
 //
 //==========================================================================
 
+static TArray<DScroller *> ScrollerBatch;
+
 int FThinkerList::TickThinkers(FThinkerList *dest)
 {
 	int count = 0;
@@ -595,6 +604,23 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 	while (node != Sentinel)
 	{
 		++count;
+		// Runs of plain scrollers get ticked together. Since they cannot run
+		// any code that alters the thinker lists this can look ahead safely.
+		if (node->GetClass() == RUNTIME_CLASS(DScroller) && !(node->ObjectFlags & (OF_JustSpawned | OF_EuthanizeMe)))
+		{
+			ScrollerBatch.Clear();
+			do
+			{
+				ScrollerBatch.Push(static_cast<DScroller *>(node));
+				node = node->NextThinker;
+			} while (node != Sentinel && node->GetClass() == RUNTIME_CLASS(DScroller) && !(node->ObjectFlags & (OF_JustSpawned | OF_EuthanizeMe)));
+
+			DScroller::TickBatch(ScrollerBatch);
+			count += ScrollerBatch.Size() - 1;
+			ThinkCount += ScrollerBatch.Size();
+			continue;
+		}
+
 		NextToThink = node->NextThinker;
 		if (node->ObjectFlags & OF_JustSpawned)
 		{
@@ -887,11 +913,17 @@ void DThinker::CallTick()
 {
 	IFVIRTUAL(DThinker, Tick)
 	{
-		// Without the type cast this picks the 'void *' assignment...
-		VMValue params[1] = { (DObject*)this };
-		VMCall(func, params, 1, nullptr, 0);
+		// Classes that do not override Tick in ZScript get the base class's
+		// stub here, which does nothing but call the native Tick again.
+		if (func != RUNTIME_CLASS(DThinker)->Virtuals[VIndex])
+		{
+			// Without the type cast this picks the 'void *' assignment...
+			VMValue params[1] = { (DObject*)this };
+			VMCall(func, params, 1, nullptr, 0);
+			return;
+		}
 	}
-	else Tick();
+	Tick();
 }
 
 //==========================================================================
@@ -2138,6 +2138,7 @@ void FParser::SF_SetLineBlocking(void)
 			{
 				Level->lines[i].flags = (Level->lines[i].flags & ~(ML_BLOCKING | ML_BLOCKEVERYTHING)) | blocking;
 			}
+			Level->GeometryChangeCounter++;
 		}
 	}
 }
@@ -153,6 +153,115 @@ static void add_char(char *tokn, char c)
 	out[1] = 0;
 }
 
+//==========================================================================
+//
+// Sets the operator index of every token so that the expression evaluator
+// does not need to compare strings.
+//
+//==========================================================================
+
+void FParser::SetTokenOps()
+{
+	for (int i = 0; i < NumTokens; i++)
+	{
+		TokenOp[i] = -1;
+		if (TokenType[i] != operator_) continue;
+		for (int j = 0; j < num_operators; j++)
+		{
+			if (!strcmp(Tokens[i], operators[j].string))
+			{
+				TokenOp[i] = j;
+				break;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// Gets the tokens for the statement at s from the script's statement
+// cache, tokenizing and adding it if it is not there yet.
+// Text that is not part of the script (i.e. includes) is always tokenized.
+//
+//==========================================================================
+
+char *FParser::GetTokens(char *s)
+{
+	char *data = Script->Data.Data();
+	if (s < data || s >= data + Script->len)
+	{
+		char *ret = TokenizeStatement(s);
+		SetTokenOps();
+		return ret;
+	}
+
+	int pos = int(s - data);
+	auto &cache = Script->Statements;
+	auto st = cache.Find(pos);
+	if (st == nullptr)
+	{
+		char *ret = TokenizeStatement(s);
+		SetTokenOps();
+		cache.Add(pos, *this, int(ret - data), int(LineStart - data));
+		return ret;
+	}
+
+	memcpy(Tokens[0], &cache.Text[st->text], st->textlen);
+	NumTokens = st->numtokens;
+	for (int i = 0; i < NumTokens; i++)
+	{
+		Tokens[i] = Tokens[0] + cache.TokenOffsets[st->tokens + i];
+		TokenType[i] = tokentype_t(cache.TokenTypes[st->tokens + i]);
+		TokenOp[i] = cache.TokenOps[st->tokens + i];
+	}
+	Section = st->section;
+	BraceType = st->bracetype;
+	LineStart = data + st->linestart;
+	Rover = data + st->next;
+	return Rover;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FFsStatementCache::Add(int pos, const FParser &parse, int next, int linestart)
+{
+	FFsCompiledStatement st;
+	st.next = next;
+	st.linestart = linestart;
+	st.section = parse.Section;
+	st.bracetype = parse.BraceType;
+	st.numtokens = parse.NumTokens;
+	st.tokens = TokenOffsets.Size();
+	st.text = Text.Size();
+	st.textlen = 1;	// statements without tokens still need the terminated empty first token.
+
+	char *base = parse.Tokens[0];
+	for (int i = 0; i < parse.NumTokens; i++)
+	{
+		unsigned offset = unsigned(parse.Tokens[i] - base);
+		TokenOffsets.Push(offset);
+		TokenTypes.Push(uint8_t(parse.TokenType[i]));
+		TokenOps.Push(parse.TokenOp[i]);
+		st.textlen = max<unsigned>(st.textlen, offset + unsigned(strlen(parse.Tokens[i])) + 1);
+	}
+	memcpy(&Text[Text.Reserve(st.textlen)], base, st.textlen);
+	Index.Insert(pos, Statements.Push(st));
+}
+
+void FFsStatementCache::Clear()
+{
+	Text.Reset();
+	TokenOffsets.Reset();
+	TokenTypes.Reset();
+	TokenOps.Reset();
+	Statements.Reset();
+	Index.Clear();
+}
+
 //==========================================================================
 //
 // get_tokens.
@@ -175,7 +284,7 @@ static void add_char(char *tokn, char c)
 //
 //==========================================================================
 
-char *FParser::GetTokens(char *s)
+char *FParser::TokenizeStatement(char *s)
 {
 	char *tokn = NULL;
 
@@ -524,6 +633,38 @@ int FParser::FindOperatorBackwards(int start, int stop, const char *value)
 	return -1;
 }
 
+//==========================================================================
+//
+// Same as above, but with the operator's index instead of its text.
+//
+//==========================================================================
+
+int FParser::FindOperator(int start, int stop, int op)
+{
+	int bracketlevel = 0;
+
+	for (int i = start; i <= stop; i++)
+	{
+		if (TokenType[i] != operator_) continue;
+		bracketlevel += Tokens[i][0] == '(' ? 1 : Tokens[i][0] == ')' ? -1 : 0;
+		if (!bracketlevel && TokenOp[i] == op) return i;
+	}
+	return -1;
+}
+
+int FParser::FindOperatorBackwards(int start, int stop, int op)
+{
+	int bracketlevel = 0;
+
+	for (int i = stop; i >= start; i--)
+	{
+		if (TokenType[i] != operator_) continue;
+		bracketlevel += Tokens[i][0] == '(' ? -1 : Tokens[i][0] == ')' ? 1 : 0;
+		if (!bracketlevel && TokenOp[i] == op) return i;
+	}
+	return -1;
+}
+
 //==========================================================================
 //
 // simple_evaluate is used once evalute_expression gets to the level
@@ -646,20 +787,29 @@ void FParser::EvaluateExpression(svalue_t &result, int start, int stop)
 		return;
     }
 	
+	// only search for the operators which occur in this range at all.
+	uint32_t present = 0;
+	for (i = start; i <= stop; i++)
+	{
+		if (TokenOp[i] >= 0) present |= 1u << TokenOp[i];
+	}
+
 	// go through each operator in order of precedence
 	for(i=0; i<num_operators; i++)
     {
+		if (!(present & (1u << i))) continue;
+
 		// check backwards for the token. it has to be
 		// done backwards for left-to-right reading: eg so
 		// 5-3-2 is (5-3)-2 not 5-(3-2)
 		
 		if (operators[i].direction==forward)
 		{
-			n = FindOperatorBackwards(start, stop, operators[i].string);
+			n = FindOperatorBackwards(start, stop, i);
 		}
 		else
 		{
-			n = FindOperator(start, stop, operators[i].string);
+			n = FindOperator(start, stop, i);
 		}
 
 		if( n != -1)
@@ -163,6 +163,7 @@ void DFsScript::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
 
+	if (arc.isReading()) Statements.Clear();
 	arc("data", Data)
 		("scriptnum", scriptnum)
 		("len", len)
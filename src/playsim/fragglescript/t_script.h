@@ -289,6 +289,50 @@ class CFsTerminator
 	int fill;
 };
 
+//==========================================================================
+//
+// Tokenized statements
+//
+// Every statement gets tokenized once, when the script is preprocessed or
+// the first time execution starts at a position the preprocessor did not
+// see, e.g. after a goto. Running the statement again only copies the
+// tokens. This is fully determined by the script's text so none of it
+// gets serialized.
+//
+//==========================================================================
+
+struct FFsCompiledStatement
+{
+	int next;			// where parsing continues after this statement
+	int linestart;
+	DFsSection *section;
+	int bracetype;
+	unsigned text, textlen;
+	unsigned tokens;
+	int numtokens;
+};
+
+class FFsStatementCache
+{
+public:
+	const FFsCompiledStatement *Find(int pos)
+	{
+		auto p = Index.CheckKey(pos);
+		return p ? &Statements[*p] : nullptr;
+	}
+	void Add(int pos, const FParser &parse, int next, int linestart);
+	void Clear();
+
+	TArray<char> Text;
+	TArray<unsigned> TokenOffsets;
+	TArray<uint8_t> TokenTypes;
+	TArray<int8_t> TokenOps;
+
+private:
+	TArray<FFsCompiledStatement> Statements;
+	TMap<int, unsigned> Index;
+};
+
 //==========================================================================
 //
 // Scripts
@@ -311,6 +355,8 @@ public:
 
 	TObjPtr<DFsSection*> sections[SECTIONSLOTS];
 
+	FFsStatementCache Statements;
+
 	// variables:
 
 	TObjPtr<DFsVariable*> variables[VARIABLESLOTS];
@@ -398,6 +444,7 @@ struct FParser
 
 	char *Tokens[T_MAXTOKENS];
 	tokentype_t TokenType[T_MAXTOKENS];
+	int8_t TokenOp[T_MAXTOKENS];	// index into operators[] for operator tokens, -1 for everything else.
 	int NumTokens;
 	FLevelLocals *Level;
 	DFsScript *Script;       // the current script
@@ -429,6 +476,8 @@ struct FParser
 
 	void NextToken();
 	char *GetTokens(char *s);
+	char *TokenizeStatement(char *s);
+	void SetTokenOps();
 	void PrintTokens();
 	void ErrorMessage(FString msg);
 
@@ -436,6 +485,8 @@ struct FParser
 	void RunStatement();
 	int FindOperator(int start, int stop, const char *value);
 	int FindOperatorBackwards(int start, int stop, const char *value);
+	int FindOperator(int start, int stop, int op);
+	int FindOperatorBackwards(int start, int stop, int op);
 	void SimpleEvaluate(svalue_t &, int n);
 	void PointlessBrackets(int *start, int *stop);
 	void EvaluateExpression(svalue_t &, int start, int stop);
@@ -156,9 +156,10 @@ static void RotationComp(const sector_t *sec, int which, double dx, double dy, d
 //
 //-----------------------------------------------------------------------------
 
-void DScroller::Tick ()
+void DScroller::NextDelta(double &dx, double &dy)
 {
-	double dx = m_dx, dy = m_dy, tdx, tdy;
+	dx = m_dx;
+	dy = m_dy;
 
 	if (m_Controller != nullptr)
 	{	// compute scroll amounts based on a sector's height changes
@@ -175,9 +176,11 @@ void DScroller::Tick ()
 		m_vdx = dx += m_vdx;
 		m_vdy = dy += m_vdy;
 	}
+}
 
-	if (dx == 0 && dy == 0)
-		return;
+void DScroller::Scroll(double dx, double dy)
+{
+	double tdx, tdy;
 
 	switch (m_Type)
 	{
@@ -227,6 +230,53 @@ void DScroller::Tick ()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+//
+//
+//-----------------------------------------------------------------------------
+
+void DScroller::Tick ()
+{
+	double dx, dy;
+
+	NextDelta(dx, dy);
+	if (dx != 0 || dy != 0)
+	{
+		Scroll(dx, dy);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// Ticks a run of scrollers at once. Nothing a scroller changes affects
+// the amount any other scroller moves by, so all amounts get computed in
+// one tight pass and are applied in a second one, in the same order the
+// thinker list would have used.
+//
+//-----------------------------------------------------------------------------
+
+static TArray<double> ScrollDeltas;
+
+void DScroller::TickBatch(const TArray<DScroller *> &scrollers)
+{
+	unsigned count = scrollers.Size();
+	ScrollDeltas.Resize(count * 2);
+	double *deltas = ScrollDeltas.Data();
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		scrollers[i]->NextDelta(deltas[i * 2], deltas[i * 2 + 1]);
+	}
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (deltas[i * 2] != 0 || deltas[i * 2 + 1] != 0)
+		{
+			scrollers[i]->Scroll(deltas[i * 2], deltas[i * 2 + 1]);
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 //
 // Add_Scroller()
@@ -19,6 +19,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	static void TickBatch(const TArray<DScroller *> &scrollers);
 
 	bool AffectsWall (side_t * wall) const { return m_Side == wall; }
 	side_t *GetWall () const { return m_Side; }
@@ -38,5 +39,9 @@ protected:
 	int m_Accel;			// Whether it's accelerative
 	EScrollPos m_Parts;			// Which parts of a sidedef are being scrolled?
 	TObjPtr<DInterpolation*> m_Interpolations[3];
+
+private:
+	void NextDelta(double &dx, double &dy);
+	void Scroll(double dx, double dy);
 };
 
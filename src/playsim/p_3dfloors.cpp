@@ -186,6 +186,7 @@ void P_Add3DFloor(sector_t* sec, sector_t* sec2, line_t* master, int flags, int
 	}
 
 	sec->e->XFloor.ffloors.Push(ffloor);
+	sec->Level->GeometryChangeCounter++;
 
 	// kg3D - software renderer only hack
 	// this is really required because of ceilingclip and floorclip
@@ -319,6 +320,9 @@ void P_Recalculate3DFloors(sector_t * sector)
 	TArray<F3DFloor*> & ffloors=sector->e->XFloor.ffloors;
 	TArray<lightlist_t> & lightlist = sector->e->XFloor.lightlist;
 
+	// This toggles FF_EXISTS on clipped floors, which sight checks and traces depend on.
+	sector->Level->GeometryChangeCounter++;
+
 	// Sort the floors top to bottom for quicker access here and later
 	// Translucent and swimmable floors are split if they overlap with solid ones.
 	if (ffloors.Size()>1)
@@ -8980,6 +8980,8 @@ scriptwait:
 						break;
 					}
 				}
+				// ML_BLOCKEVERYTHING also blocks sight.
+				Level->GeometryChangeCounter++;
 
 				sp -= 2;
 			}
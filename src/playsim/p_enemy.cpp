@@ -113,31 +113,17 @@ double yspeed[8] = {0,SQRTHALF,1,SQRTHALF,0,-SQRTHALF,-1,-SQRTHALF};
 
 //----------------------------------------------------------------------------
 //
-// PROC P_RecursiveSound
+// PROC NoiseMarkSector
 //
-// Called by P_NoiseAlert.
-// Traverses adjacent sectors,
+// Called by P_NoiseAlert for each sector the sound reaches.
+// The actual traversal of adjacent sectors is done by FSoundGraph,
 // sound blocking lines cut off traversal.
 //----------------------------------------------------------------------------
 
-struct NoiseTarget
+static void NoiseMarkSector(sector_t *sec, AActor *soundtarget, bool splash, AActor *emitter, int soundtraversed, double maxdist)
 {
-	sector_t *sec;
-	int soundblocks;
-};
-static TArray<NoiseTarget> NoiseList(128);
-
-static void NoiseMarkSector(sector_t *sec, AActor *soundtarget, bool splash, AActor *emitter, int soundblocks, double maxdist)
-{
-	// wake up all monsters in this sector
-	if (sec->validcount == validcount
-		&& sec->soundtraversed <= soundblocks + 1)
-	{
-		return; 		// already flooded
-	}
-
 	sec->validcount = validcount;
-	sec->soundtraversed = soundblocks + 1;
+	sec->soundtraversed = soundtraversed;
 	sec->SoundTarget = soundtarget;
 
 	// [RH] Set this in the actors in the sector instead of the sector itself.
@@ -149,83 +135,6 @@ static void NoiseMarkSector(sector_t *sec, AActor *soundtarget, bool splash, AAc
 			actor->LastHeard = soundtarget;
 		}
 	}
-	NoiseList.Push({ sec, soundblocks });
-}
-
-
-static void P_RecursiveSound(sector_t *sec, AActor *soundtarget, bool splash, AActor *emitter, int soundblocks, double maxdist)
-{
-	bool checkabove = !sec->PortalBlocksSound(sector_t::ceiling);
-	bool checkbelow = !sec->PortalBlocksSound(sector_t::floor);
-
-	for (auto check : sec->Lines)
-	{
-		// check sector portals
-		// I wish there was a better method to do this than randomly looking through the portal at a few places...
-		if (checkabove)
-		{
-			sector_t *upper = sec->Level->PointInSector(check->v1->fPos() + check->Delta() / 2 + sec->GetPortalDisplacement(sector_t::ceiling));
-			NoiseMarkSector(upper, soundtarget, splash, emitter, soundblocks, maxdist);
-		}
-		if (checkbelow)
-		{
-			sector_t *lower = sec->Level->PointInSector(check->v1->fPos() + check->Delta() / 2 + sec->GetPortalDisplacement(sector_t::floor));
-			NoiseMarkSector(lower, soundtarget, splash, emitter, soundblocks, maxdist);
-		}
-
-		// ... and line portals;
-		FLinePortal *port = check->getPortal();
-		if (port && (port->mFlags & PORTF_SOUNDTRAVERSE))
-		{
-			if (port->mDestination)
-			{
-				NoiseMarkSector(port->mDestination->frontsector, soundtarget, splash, emitter, soundblocks, maxdist);
-			}
-		}
-
-
-		if (check->sidedef[1] == NULL ||
-			!(check->flags & ML_TWOSIDED))
-		{
-			continue;
-		}
-
-		// Early out for intra-sector lines
-		if (check->sidedef[0]->sector == check->sidedef[1]->sector) continue;
-
-		sector_t *other;
-		if (check->sidedef[0]->sector == sec)
-			other = check->sidedef[1]->sector;
-		else
-			other = check->sidedef[0]->sector;
-
-		// check for closed door
-		if ((sec->floorplane.ZatPoint(check->v1->fPos()) >=
-			other->ceilingplane.ZatPoint(check->v1->fPos()) &&
-			sec->floorplane.ZatPoint(check->v2->fPos()) >=
-			other->ceilingplane.ZatPoint(check->v2->fPos()))
-			|| (other->floorplane.ZatPoint(check->v1->fPos()) >=
-				sec->ceilingplane.ZatPoint(check->v1->fPos()) &&
-				other->floorplane.ZatPoint(check->v2->fPos()) >=
-				sec->ceilingplane.ZatPoint(check->v2->fPos()))
-			|| (other->floorplane.ZatPoint(check->v1->fPos()) >=
-				other->ceilingplane.ZatPoint(check->v1->fPos()) &&
-				other->floorplane.ZatPoint(check->v2->fPos()) >=
-				other->ceilingplane.ZatPoint(check->v2->fPos())))
-		{
-			continue;
-		}
-
-		if (check->flags & ML_SOUNDBLOCK)
-		{
-			if (!soundblocks)
-				NoiseMarkSector(other, soundtarget, splash, emitter, 1, maxdist);
-		}
-		else
-		{
-			NoiseMarkSector(other, soundtarget, splash, emitter, soundblocks, maxdist);
-		}
-	}
 }
 
 
@@ -249,11 +158,9 @@ void P_NoiseAlert (AActor *emitter, AActor *target, bool splash, double maxdist)
 		return;
 
 	validcount++;
-	NoiseList.Clear();
-	NoiseMarkSector(emitter->Sector, target, splash, emitter, 0, maxdist);
-	for (unsigned i = 0; i < NoiseList.Size(); i++)
+	for (auto &node : emitter->Level->SoundGraph.Flood(emitter->Sector))
 	{
-		P_RecursiveSound(NoiseList[i].sec, target, splash, emitter, NoiseList[i].soundblocks, maxdist);
+		NoiseMarkSector(node.sec, target, splash, emitter, node.soundtraversed, maxdist);
 	}
 }
 
@@ -1076,6 +983,54 @@ void P_NewChaseDir(AActor * actor)
 
 }
 
+//=============================================================================
+//
+// P_FlowMoveDir
+//
+// Looks up the direction to move in to get closer to the goal from the
+// level's flow fields. Returns DI_NODIR if the goal is in the same cell
+// or cannot be reached over the walkability grid.
+//
+//=============================================================================
+
+int P_FlowMoveDir(AActor *actor, AActor *goal)
+{
+	if (goal == nullptr) goal = actor->target;
+	if (goal == nullptr) return DI_NODIR;
+
+	DVector2 pos = actor->Pos().XY();
+	return actor->Level->FlowFields.GetMoveDir(actor->Level, pos, pos + actor->Vec2To(goal));
+}
+
+//=============================================================================
+//
+// P_FlowChaseDir
+//
+// Opt-in replacement for P_NewChaseDir that steers by flow field lookup
+// instead of probing directions. Falls back to P_NewChaseDir whenever
+// the field has no answer or the move gets blocked. Returns true if the
+// flow field direction was taken.
+//
+//=============================================================================
+
+int P_FlowChaseDir(AActor *actor, AActor *goal)
+{
+	int dir = P_FlowMoveDir(actor, goal);
+	if (dir != DI_NODIR)
+	{
+		int olddir = actor->movedir;
+		actor->strafecount = 0;
+		actor->movedir = dir;
+		if (P_TryWalk(actor))
+		{
+			return true;
+		}
+		actor->movedir = olddir;
+	}
+	P_NewChaseDir(actor);
+	return false;
+}
+
 //=============================================================================
 //
 // P_RandomChaseDir
@@ -54,6 +54,8 @@ bool P_CheckMeleeRange2 (AActor *actor);
 int P_SmartMove (AActor *actor);
 bool P_TryWalk (AActor *actor);
 void P_NewChaseDir (AActor *actor);
+int P_FlowMoveDir(AActor *actor, AActor *goal);
+int P_FlowChaseDir(AActor *actor, AActor *goal);
 void P_RandomChaseDir(AActor *actor);;
 int P_IsVisible(AActor *lookee, AActor *other, INTBOOL allaround, FLookExParams *params);
 
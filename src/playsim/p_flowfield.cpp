@@ -0,0 +1,520 @@
+/*
+** p_flowfield.cpp
+**
+** Walkability grid and cached flow fields for chasing monsters
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Monsters that steer through these fields only look up a direction
+** instead of probing up to eight moves with full collision checks. The
+** grid is an approximation, so the actual move still goes through
+** P_TryMove and callers should fall back to P_NewChaseDir when it fails.
+**
+*/
+
+#include "g_levellocals.h"
+#include "p_flowfield.h"
+#include "c_dispatch.h"
+#include "stats.h"
+
+static const int DirX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int DirY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FFlowFields::Clear()
+{
+	Level = nullptr;
+	Width = Height = 0;
+	Epoch = 0;
+	UseCounter = 0;
+	NeedsRelink = false;
+	Usable = false;
+	CheckedTime = -1;
+	LineFlags.Reset();
+	CellSector.Reset();
+	Links.Reset();
+	SectorCellStart.Reset();
+	SectorCells.Reset();
+	DirtyMark.Reset();
+	DirtySectors.Reset();
+	LineStamp.Reset();
+	LineStampCounter = 0;
+	Crossed.Reset();
+	Distance.Reset();
+	for (auto &b : Buckets) b.Reset();
+	for (auto &f : Fields)
+	{
+		f.goal = -1;
+		f.epoch = 0;
+		f.lastuse = 0;
+		f.directions.Reset();
+	}
+}
+
+//==========================================================================
+//
+// Needs to be called when a line's monster blocking flags get changed.
+// All links will be redone before the next lookup.
+//
+//==========================================================================
+
+void FFlowFields::Invalidate()
+{
+	if (Usable) NeedsRelink = true;
+}
+
+//==========================================================================
+//
+// Called from P_ChangeSector. All cells whose links depend on this
+// sector's heights will be redone before the next lookup.
+//
+//==========================================================================
+
+void FFlowFields::SectorMoved(sector_t *sec)
+{
+	if (!Usable) return;
+
+	unsigned index = sec->Index();
+	if (index < DirtyMark.Size() && !DirtyMark[index])
+	{
+		DirtyMark[index] = 1;
+		DirtySectors.Push(sec);
+	}
+}
+
+//==========================================================================
+//
+// Gets all lines the straight path between two points crosses.
+// Touching or collinear lines count as crossed.
+//
+//==========================================================================
+
+void FFlowFields::CollectCrossedLines(const DVector2 &a, const DVector2 &b)
+{
+	auto &bmap = Level->blockmap;
+	int bx1 = clamp(bmap.GetBlockX(min(a.X, b.X)), 0, bmap.bmapwidth - 1);
+	int bx2 = clamp(bmap.GetBlockX(max(a.X, b.X)), 0, bmap.bmapwidth - 1);
+	int by1 = clamp(bmap.GetBlockY(min(a.Y, b.Y)), 0, bmap.bmapheight - 1);
+	int by2 = clamp(bmap.GetBlockY(max(a.Y, b.Y)), 0, bmap.bmapheight - 1);
+
+	Crossed.Clear();
+	if (++LineStampCounter == 0)
+	{
+		memset(LineStamp.Data(), 0, LineStamp.Size() * sizeof(unsigned));
+		LineStampCounter = 1;
+	}
+
+	DVector2 delta = b - a;
+	for (int by = by1; by <= by2; by++)
+	{
+		for (int bx = bx1; bx <= bx2; bx++)
+		{
+			for (int *list = bmap.GetLines(bx, by); *list != -1; list++)
+			{
+				if (LineStamp[*list] == LineStampCounter) continue;
+				LineStamp[*list] = LineStampCounter;
+
+				line_t *line = &Level->lines[*list];
+				DVector2 v1 = line->v1->fPos();
+				DVector2 ld = line->Delta();
+
+				double s1 = ld.X * (a.Y - v1.Y) - ld.Y * (a.X - v1.X);
+				double s2 = ld.X * (b.Y - v1.Y) - ld.Y * (b.X - v1.X);
+				if ((s1 > 0 && s2 > 0) || (s1 < 0 && s2 < 0)) continue;
+
+				double t1 = delta.X * (v1.Y - a.Y) - delta.Y * (v1.X - a.X);
+				double t2 = delta.X * (v1.Y + ld.Y - a.Y) - delta.Y * (v1.X + ld.X - a.X);
+				if ((t1 > 0 && t2 > 0) || (t1 < 0 && t2 < 0)) continue;
+
+				Crossed.Push(line);
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// Checks if a monster can walk between the centers of two adjacent cells.
+// This is symmetric so the result is valid for both directions.
+//
+//==========================================================================
+
+bool FFlowFields::CanWalk(unsigned from, unsigned to)
+{
+	DVector2 a = CellCenter(from % Width, from / Width);
+	DVector2 b = CellCenter(to % Width, to / Width);
+	sector_t *sa = CellSector[from];
+	sector_t *sb = CellSector[to];
+
+	double fa = sa->floorplane.ZatPoint(a);
+	double fb = sb->floorplane.ZatPoint(b);
+	double lowest = min(fa, fb);
+	double floor = max(fa, fb);
+	double ceiling = min(sa->ceilingplane.ZatPoint(a), sb->ceilingplane.ZatPoint(b));
+
+	CollectCrossedLines(a, b);
+	for (auto line : Crossed)
+	{
+		if (line->backsector == nullptr || (line->flags & (ML_BLOCKING | ML_BLOCKMONSTERS | ML_BLOCKEVERYTHING)))
+		{
+			return false;
+		}
+
+		// Check the opening where the path crosses the line.
+		DVector2 v1 = line->v1->fPos();
+		DVector2 ld = line->Delta();
+		DVector2 delta = b - a;
+		double den = delta.X * ld.Y - delta.Y * ld.X;
+		double frac = den == 0 ? 0 : ((v1.X - a.X) * ld.Y - (v1.Y - a.Y) * ld.X) / den;
+		DVector2 p = a + delta * clamp(frac, 0., 1.);
+
+		floor = max(floor, max(line->frontsector->floorplane.ZatPoint(p), line->backsector->floorplane.ZatPoint(p)));
+		ceiling = min(ceiling, min(line->frontsector->ceilingplane.ZatPoint(p), line->backsector->ceilingplane.ZatPoint(p)));
+	}
+	return floor - lowest <= MAX_STEP && ceiling - floor >= MIN_OPENING;
+}
+
+//==========================================================================
+//
+// Redoes all links of a cell and the matching ones of its neighbours.
+//
+//==========================================================================
+
+void FFlowFields::Relink(unsigned cell)
+{
+	int x = cell % Width;
+	int y = cell / Width;
+	for (int dir = 0; dir < 8; dir++)
+	{
+		int nx = x + DirX[dir];
+		int ny = y + DirY[dir];
+		if (nx < 0 || ny < 0 || nx >= (int)Width || ny >= (int)Height) continue;
+
+		unsigned other = ny * Width + nx;
+		uint8_t bit = 1 << dir, backbit = 1 << ((dir + 4) & 7);
+		bool walk = CanWalk(cell, other);
+		if (walk != !!(Links[cell] & bit))
+		{
+			Links[cell] ^= bit;
+			Links[other] ^= backbit;
+			Epoch++;
+		}
+	}
+}
+
+//==========================================================================
+//
+// Sets up the grid and all links. Every cell gets registered with its
+// own sector and the sectors of all lines its links cross.
+//
+//==========================================================================
+
+void FFlowFields::Build(FLevelLocals *level)
+{
+	Clear();
+	// A level without a grid is remembered as such so that it does not get retried on every lookup.
+	Level = level;
+	if (level->vertexes.Size() == 0 || level->blockmap.bmapwidth <= 0) return;
+
+	double left = Level->vertexes[0].fX(), right = left;
+	double bottom = Level->vertexes[0].fY(), top = bottom;
+	for (auto &v : Level->vertexes)
+	{
+		left = min(left, v.fX());
+		right = max(right, v.fX());
+		bottom = min(bottom, v.fY());
+		top = max(top, v.fY());
+	}
+
+	CellSize = CELL_SIZE;
+	for (;;)
+	{
+		Width = unsigned((right - left) / CellSize) + 1;
+		Height = unsigned((top - bottom) / CellSize) + 1;
+		if (uint64_t(Width) * Height <= MAX_CELLS) break;
+		CellSize *= 2;
+	}
+	OriginX = left;
+	OriginY = bottom;
+
+	unsigned numcells = Width * Height;
+	CellSector.Resize(numcells);
+	Links.Resize(numcells);
+	memset(Links.Data(), 0, numcells);
+	LineStamp.Resize(Level->lines.Size());
+	memset(LineStamp.Data(), 0, LineStamp.Size() * sizeof(unsigned));
+	LineFlags.Resize(Level->lines.Size());
+	for (unsigned i = 0; i < LineFlags.Size(); i++)
+	{
+		LineFlags[i] = Level->lines[i].flags & (ML_BLOCKING | ML_BLOCKMONSTERS | ML_BLOCKEVERYTHING);
+	}
+	CheckedTime = Level->maptime;
+	DirtyMark.Resize(Level->sectors.Size());
+	memset(DirtyMark.Data(), 0, DirtyMark.Size());
+
+	for (unsigned y = 0; y < Height; y++)
+	{
+		for (unsigned x = 0; x < Width; x++)
+		{
+			CellSector[y * Width + x] = Level->PointInSector(CellCenter(x, y));
+		}
+	}
+
+	// (sector, cell) pairs, sorted into SectorCells below.
+	TArray<std::pair<unsigned, unsigned>> owners;
+	for (unsigned cell = 0; cell < numcells; cell++)
+	{
+		unsigned first = owners.Size();
+		owners.Push({ CellSector[cell]->Index(), cell });
+
+		int x = cell % Width;
+		int y = cell / Width;
+		for (int dir = 0; dir < 4; dir++)	// the other half gets done from the neighbours
+		{
+			int nx = x + DirX[dir];
+			int ny = y + DirY[dir];
+			if (nx < 0 || ny < 0 || nx >= (int)Width || ny >= (int)Height) continue;
+
+			unsigned other = ny * Width + nx;
+			if (CanWalk(cell, other))
+			{
+				Links[cell] |= 1 << dir;
+				Links[other] |= 1 << (dir + 4);
+			}
+
+			// The cell needs to be redone when any of the crossed lines' sectors moves.
+			for (auto line : Crossed)
+			{
+				for (auto sec : { line->frontsector, line->backsector })
+				{
+					if (sec == nullptr) continue;
+					bool found = false;
+					for (unsigned i = first; i < owners.Size() && !found; i++)
+					{
+						found = owners[i].first == sec->Index();
+					}
+					if (!found) owners.Push({ sec->Index(), cell });
+				}
+			}
+		}
+	}
+
+	SectorCellStart.Resize(Level->sectors.Size() + 1);
+	memset(SectorCellStart.Data(), 0, SectorCellStart.Size() * sizeof(unsigned));
+	for (auto &o : owners) SectorCellStart[o.first + 1]++;
+	for (unsigned i = 1; i < SectorCellStart.Size(); i++) SectorCellStart[i] += SectorCellStart[i - 1];
+	SectorCells.Resize(owners.Size());
+	TArray<unsigned> fill(Level->sectors.Size(), true);
+	memcpy(fill.Data(), SectorCellStart.Data(), fill.Size() * sizeof(unsigned));
+	for (auto &o : owners) SectorCells[fill[o.first]++] = o.second;
+
+	Distance.Resize(numcells);
+	Epoch++;
+	Usable = true;
+}
+
+//==========================================================================
+//
+// Finds lines whose blocking flags got changed without calling Invalidate,
+// e.g. by a script assigning Line.flags. The cells crossing such a line
+// are registered with its sectors, so only those get relinked.
+//
+//==========================================================================
+
+void FFlowFields::CheckLineFlags()
+{
+	CheckedTime = Level->maptime;
+	for (unsigned i = 0; i < LineFlags.Size(); i++)
+	{
+		auto &line = Level->lines[i];
+		uint32_t flags = line.flags & (ML_BLOCKING | ML_BLOCKMONSTERS | ML_BLOCKEVERYTHING);
+		if (flags != LineFlags[i])
+		{
+			LineFlags[i] = flags;
+			if (line.frontsector) SectorMoved(line.frontsector);
+			if (line.backsector) SectorMoved(line.backsector);
+		}
+	}
+}
+
+//==========================================================================
+//
+// Brings the links up to date with the current level state.
+//
+//==========================================================================
+
+void FFlowFields::Update()
+{
+	if (NeedsRelink)
+	{
+		for (unsigned cell = 0; cell < CellSector.Size(); cell++)
+		{
+			Relink(cell);
+		}
+		NeedsRelink = false;
+		Relinks++;
+	}
+	else
+	{
+		for (auto sec : DirtySectors)
+		{
+			unsigned index = sec->Index();
+			for (unsigned i = SectorCellStart[index]; i < SectorCellStart[index + 1]; i++)
+			{
+				Relink(SectorCells[i]);
+			}
+			Relinks++;
+		}
+	}
+	for (auto sec : DirtySectors) DirtyMark[sec->Index()] = 0;
+	DirtySectors.Clear();
+}
+
+//==========================================================================
+//
+// Dijkstra from the goal cell with a bucket queue. Orthogonal steps
+// cost 2 and diagonal ones 3. Diagonal moves must not cut corners.
+//
+//==========================================================================
+
+void FFlowFields::BuildField(Field &field, unsigned goal)
+{
+	unsigned numcells = CellSector.Size();
+	field.goal = goal;
+	field.epoch = Epoch;
+	field.directions.Resize(numcells);
+	memset(field.directions.Data(), NO_DIRECTION, numcells);
+	memset(Distance.Data(), 0xff, numcells * sizeof(uint32_t));
+
+	Distance[goal] = 0;
+	Buckets[0].Push(goal);
+	unsigned pending = 1;
+	for (uint32_t dist = 0; pending > 0; dist++)
+	{
+		auto &bucket = Buckets[dist & 3];
+		for (unsigned i = 0; i < bucket.Size(); i++)
+		{
+			unsigned cell = bucket[i];
+			pending--;
+			if (Distance[cell] != dist) continue;
+
+			int x = cell % Width;
+			int y = cell / Width;
+			for (int dir = 0; dir < 8; dir++)
+			{
+				if (!(Links[cell] & (1 << dir))) continue;
+
+				unsigned other = (y + DirY[dir]) * Width + (x + DirX[dir]);
+				int back = (dir + 4) & 7;
+				if (dir & 1)
+				{
+					// the monster moves the opposite way, so check the corners from its side.
+					int need = (1 << ((back + 1) & 7)) | (1 << ((back + 7) & 7));
+					if ((Links[other] & need) != need) continue;
+				}
+
+				uint32_t newdist = dist + ((dir & 1) ? 3 : 2);
+				if (newdist < Distance[other])
+				{
+					Distance[other] = newdist;
+					field.directions[other] = back;
+					Buckets[newdist & 3].Push(other);
+					pending++;
+				}
+			}
+		}
+		bucket.Clear();
+	}
+	FieldBuilds++;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+int FFlowFields::GetMoveDir(FLevelLocals *level, const DVector2 &from, const DVector2 &goal)
+{
+	if (Level != level) Build(level);
+	if (!Usable) return NO_DIRECTION;
+	if (CheckedTime != Level->maptime) CheckLineFlags();
+	if (NeedsRelink || DirtySectors.Size() > 0) Update();
+
+	int start = CellAt(from);
+	int target = CellAt(goal);
+	if (start < 0 || target < 0 || start == target) return NO_DIRECTION;
+
+	Field *use = nullptr;
+	for (auto &f : Fields)
+	{
+		if (f.goal == target && f.epoch == Epoch)
+		{
+			use = &f;
+			FieldHits++;
+			break;
+		}
+	}
+	if (use == nullptr)
+	{
+		use = &Fields[0];
+		for (auto &f : Fields)
+		{
+			if (f.goal == target)
+			{
+				use = &f;
+				break;
+			}
+			if (f.lastuse < use->lastuse) use = &f;
+		}
+		BuildField(*use, target);
+	}
+	use->lastuse = ++UseCounter;
+	return use->directions[start];
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+ADD_STAT(flowfield)
+{
+	FString out;
+	auto &ff = primaryLevel->FlowFields;
+	out.Format("Flow grid %ux%u (%g units), %u fields built, %u lookups reused, %u sector relinks",
+		ff.GetWidth(), ff.GetHeight(), ff.GetCellSize(), ff.FieldBuilds, ff.FieldHits, ff.Relinks);
+	return out;
+}
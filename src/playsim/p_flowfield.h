@@ -0,0 +1,118 @@
+#pragma once
+
+#include "tarray.h"
+#include "vectors.h"
+
+struct sector_t;
+struct line_t;
+struct FLevelLocals;
+
+//============================================================================
+//
+// Flow fields over a coarse walkability grid for mass chase behaviour.
+//
+// The level is covered with square cells. Each cell knows the sector at its
+// center and which of its 8 neighbours can be walked to, i.e. no monster
+// blocking line is crossed on the way, the step is not too high and the
+// openings of all crossed lines are tall enough. For every goal cell that
+// gets asked for, a field pointing each cell one step closer to the goal is
+// made and cached until the goal moves to another cell or a link changes.
+//
+// Links are only recalculated for the cells touched by a moving sector, so
+// doors and lifts do not cause a full rebuild. Scripts can write line flags
+// directly, so the blocking flags get compared against a snapshot once per
+// tic and a changed line relinks the cells of its sectors. The grid gets
+// built on first use, vanilla chasing never touches any of this.
+//
+//============================================================================
+
+class FFlowFields
+{
+public:
+	enum
+	{
+		NO_DIRECTION = 8	// same as DI_NODIR
+	};
+
+	void Clear();
+	void Invalidate();
+	void SectorMoved(sector_t *sec);
+
+	// Returns the dirtype_t to move in to get from 'from' closer to 'goal'.
+	int GetMoveDir(FLevelLocals *Level, const DVector2 &from, const DVector2 &goal);
+
+	unsigned GetWidth() const { return Width; }
+	unsigned GetHeight() const { return Height; }
+	double GetCellSize() const { return CellSize; }
+
+	unsigned FieldBuilds = 0;
+	unsigned FieldHits = 0;
+	unsigned Relinks = 0;
+
+private:
+	enum
+	{
+		CELL_SIZE = 32,
+		MAX_CELLS = 512 * 512,
+		MAX_FIELDS = 16,
+		MAX_STEP = 24,		// default MaxStepHeight
+		MIN_OPENING = 56,	// height of the common monsters
+	};
+
+	struct Field
+	{
+		int goal = -1;
+		unsigned epoch = 0;
+		unsigned lastuse = 0;
+		TArray<uint8_t> directions;
+	};
+
+	FLevelLocals *Level = nullptr;
+	double OriginX = 0, OriginY = 0;
+	double CellSize = CELL_SIZE;
+	unsigned Width = 0, Height = 0;
+	unsigned Epoch = 0;
+	unsigned UseCounter = 0;
+	bool NeedsRelink = false;
+	bool Usable = false;				// false if the level has no grid, e.g. because it has no blockmap
+	int CheckedTime = -1;				// maptime of the last line flag check
+
+	TArray<uint32_t> LineFlags;			// the blocking flags of each line when they were last checked
+
+	TArray<sector_t *> CellSector;
+	TArray<uint8_t> Links;				// one bit per direction, ordered like dirtype_t
+
+	TArray<unsigned> SectorCellStart;	// cells to relink when a sector moves, indexed by sector
+	TArray<unsigned> SectorCells;
+
+	TArray<uint8_t> DirtyMark;
+	TArray<sector_t *> DirtySectors;
+	TArray<unsigned> LineStamp;
+	unsigned LineStampCounter = 0;
+	TArray<line_t *> Crossed;
+
+	TArray<uint32_t> Distance;
+	TArray<unsigned> Buckets[4];
+	Field Fields[MAX_FIELDS];
+
+	void Build(FLevelLocals *Level);
+	void Update();
+	void CheckLineFlags();
+	void Relink(unsigned cell);
+	bool CanWalk(unsigned from, unsigned to);
+	void CollectCrossedLines(const DVector2 &a, const DVector2 &b);
+	void BuildField(Field &field, unsigned goal);
+
+	DVector2 CellCenter(unsigned x, unsigned y) const
+	{
+		return { OriginX + (x + 0.5) * CellSize, OriginY + (y + 0.5) * CellSize };
+	}
+
+	int CellAt(const DVector2 &pos) const
+	{
+		double x = (pos.X - OriginX) / CellSize;
+		double y = (pos.Y - OriginY) / CellSize;
+		if (x < 0 || y < 0 || x >= Width || y >= Height) return -1;
+		return int(y) * Width + int(x);
+	}
+};
@@ -2769,6 +2769,18 @@ FUNC(LS_Line_SetBlocking)
 	{
 		Level->lines[line].flags = (Level->lines[line].flags & ~clearflags) | setflags;
 	}
+	if ((setflags | clearflags) & ML_SOUNDBLOCK)
+	{
+		Level->SoundGraph.Invalidate();
+	}
+	if ((setflags | clearflags) & (ML_BLOCKSIGHT | ML_BLOCKEVERYTHING))
+	{
+		Level->GeometryChangeCounter++;
+	}
+	if ((setflags | clearflags) & (ML_BLOCKING | ML_BLOCKMONSTERS | ML_BLOCKEVERYTHING))
+	{
+		Level->FlowFields.Invalidate();
+	}
 	return true;
 }
 
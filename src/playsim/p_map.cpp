@@ -4570,7 +4570,13 @@ AActor *P_LineAttack(AActor *t1, DAngle angle, double distance,
 	}
 
 	// Perform the trace.
-	if (!Trace(tempos, t1->Sector, direction, distance, MF_SHOOTABLE, 
+	// Consecutive attacks from the same spot, e.g. the pellets of a shotgun, share the trace setup.
+	FTraceBatch &batch = t1->Level->HitscanBatch;
+	if (!batch.Matches(tempos, t1->Sector))
+	{
+		batch.Begin(tempos, t1->Sector);
+	}
+	if (!batch.Trace(direction, distance, MF_SHOOTABLE, 
 		ML_BLOCKEVERYTHING | ML_BLOCKHITSCAN, t1, trace, tflags, CheckForActor, &TData))
 	{ // hit nothing
 		if (!nointeract && puffDefaults && puffDefaults->ActiveSound)
@@ -5879,7 +5885,7 @@ static int GetOldRadiusDamage(bool fromaction, AActor *bombspot, AActor *thing,
 		return ret;  // out of range
 
 	// When called from the action function, ignore the sight check.
-	if (fromaction || P_CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
+	if (fromaction || thing->Level->RadiusSightCache.CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
 	{
 		dist = clamp<double>(dist - fulldamagedistance, 0, dist);
 		int damage = Scale(bombdamage, bombdistance - int(dist), bombdistance);
@@ -6010,7 +6016,7 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 			double points = GetRadiusDamage(false, bombspot, thing, bombdamage, bombdistance, fulldamagedistance, bombsource == thing);
 			double check = int(points) * bombdamage;
 			// points and bombdamage should be the same sign (the double cast of 'points' is needed to prevent overflows and incorrect values slipping through.)
-			if ((check > 0 || (check == 0 && bombspot->flags7 & MF7_FORCEZERORADIUSDMG)) && P_CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
+			if ((check > 0 || (check == 0 && bombspot->flags7 & MF7_FORCEZERORADIUSDMG)) && thing->Level->RadiusSightCache.CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
 			{ // OK to damage; target is in direct path
 				double vz;
 				double thrust;
@@ -6691,6 +6697,57 @@ void PIT_CeilingRaise(AActor *thing, FChangePosition *cpos)
 	}
 }
 
+//=============================================================================
+//
+// P_ChangeSectorThings
+//
+// killough 4/4/98: scan list front-to-back until empty or exhausted,
+// restarting from beginning after each thing is processed. Avoids
+// crashes, and is sure to examine all things in the sector, and only
+// the things which are in the sector, until a steady-state is reached.
+// Things can arbitrarily be inserted and removed and it won't mess up.
+//
+// killough 4/7/98: simplified to avoid using complicated counter
+//
+// Restarting from the list head only is necessary if processing a thing
+// actually linked or unlinked some sector node. If nothing changed, all
+// nodes in front of the one just processed are already marked, so the
+// search can continue right after it and still visit things in exactly
+// the same order. This avoids the quadratic rescans on crowded lifts.
+//
+//=============================================================================
+
+static void P_ChangeSectorThings(sector_t *sector, FChangePosition *cpos, void(*iterator)(AActor *, FChangePosition *), void(*iterator2)(AActor *, FChangePosition *))
+{
+	msecnode_t *n;
+
+	// Mark all things invalid
+
+	for (n = sector->touching_thinglist; n; n = n->m_snext)
+		n->visited = false;
+
+	n = sector->touching_thinglist;
+	while (n != nullptr)
+	{
+		if (n->visited)								// skip things that are already done
+		{
+			n = n->m_snext;
+			continue;
+		}
+		n->visited = true; 							// mark thing as processed
+
+		unsigned changes = secnodechanges;
+		if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+			(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
+		{
+			iterator(n->m_thing, cpos);		 			// process it
+			if (iterator2 != nullptr) iterator2(n->m_thing, cpos);
+		}
+		// If the lists were altered, this node may be gone, so start over.
+		n = changes == secnodechanges ? n->m_snext : sector->touching_thinglist;
+	}
+}
+
 //=============================================================================
 //
 // P_ChangeSector	[RH] Was P_CheckSector in BOOM
@@ -6715,6 +6772,10 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 	cpos.sector = sector;
 	cpos.instant = instant;
 
+	sector->Level->SoundGraph.SectorMoved(sector);
+	sector->Level->FlowFields.SectorMoved(sector);
+	sector->Level->GeometryChangeCounter++;
+
 	// Also process all sectors that have 3D floors transferred from the
 	// changed sector.
 	if (sector->e->XFloor.attached.Size() && floorOrCeil != 2)
@@ -6742,23 +6803,7 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 			// no thing checks for attached sectors because of heightsec
 			if (sec->heightsec == sector) continue;
 
-			for (n = sec->touching_thinglist; n; n = n->m_snext) n->visited = false;
-			do
-			{
-				for (n = sec->touching_thinglist; n; n = n->m_snext)
-				{
-					if (!n->visited)
-					{
-						n->visited = true;
-						if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-							(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-						{
-							iterator(n->m_thing, &cpos);
-						}
-						break;
-					}
-				}
-			} while (n);
+			P_ChangeSectorThings(sec, &cpos, iterator, nullptr);
 			sec->CheckPortalPlane(!floorOrCeil);
 		}
 	}
@@ -6792,36 +6837,7 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 		return false;
 	}
 
-	// killough 4/4/98: scan list front-to-back until empty or exhausted,
-	// restarting from beginning after each thing is processed. Avoids
-	// crashes, and is sure to examine all things in the sector, and only
-	// the things which are in the sector, until a steady-state is reached.
-	// Things can arbitrarily be inserted and removed and it won't mess up.
-	//
-	// killough 4/7/98: simplified to avoid using complicated counter
-
-	// Mark all things invalid
-
-	for (n = sector->touching_thinglist; n; n = n->m_snext)
-		n->visited = false;
-
-	do
-	{
-		for (n = sector->touching_thinglist; n; n = n->m_snext)	// go through list
-		{
-			if (!n->visited)								// unprocessed thing found
-			{
-				n->visited = true; 							// mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-				{
-					iterator(n->m_thing, &cpos);		 			// process it
-					if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
-				}
-				break;										// exit and start over
-			}
-		}
-	} while (n);	// repeat from scratch until all things left are marked valid
+	P_ChangeSectorThings(sector, &cpos, iterator, iterator2);
 
 	if (floorOrCeil != 2) sector->CheckPortalPlane(floorOrCeil);	// check for portal obstructions after everything is done.
 
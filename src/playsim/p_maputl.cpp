@@ -335,6 +335,7 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 
 		while (block != NULL)
 		{
+			Level->blockmap.blockchanges[block->BlockIndex]++;
 			if (block->NextActor != NULL)
 			{
 				block->NextActor->PrevActor = block->PrevActor;
@@ -537,6 +538,7 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 					{
 						FBlockNode **link = &Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
 						FBlockNode *node = FBlockNode::Create(this, x, y, this->Sector->PortalGroup);
+						Level->blockmap.blockchanges[node->BlockIndex]++;
 
 						// Link in to block
 						if ((node->NextActor = *link) != NULL)
@@ -967,6 +969,52 @@ void FBlockThingsIterator::SwitchBlock(int x, int y)
 	StartBlock(x, y);
 }
 
+//===========================================================================
+//
+// FBlockThingsIterator :: MarkChecked
+//
+// Adds an actor spanning multiple blocks to the hash of checked actors.
+// Returns false if it already was in there.
+//
+//===========================================================================
+
+bool FBlockThingsIterator::MarkChecked(AActor *me)
+{
+	HashEntry *entry;
+	int i;
+
+	size_t hash = ((size_t)me >> 3) % countof(Buckets);
+	for (i = Buckets[hash]; i >= 0; )
+	{
+		entry = GetHashEntry(i);
+		if (entry->Actor == me)
+		{ // I've already been checked. Skip to the next actor.
+			return false;
+		}
+		i = entry->Next;
+	}
+	// Add me to the hash table.
+	if (NumFixedHash < (int)countof(FixedHash))
+	{
+		entry = &FixedHash[NumFixedHash];
+		entry->Next = Buckets[hash];
+		Buckets[hash] = NumFixedHash++;
+	}
+	else
+	{
+		if (DynHash.Size() == 0)
+		{
+			DynHash.Grow(50);
+		}
+		i = DynHash.Reserve(1);
+		entry = &DynHash[i];
+		entry->Next = Buckets[hash];
+		Buckets[hash] = i + countof(FixedHash);
+	}
+	entry->Actor = me;
+	return true;
+}
+
 //===========================================================================
 //
 // FBlockThingsIterator :: Next
@@ -981,8 +1029,6 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 		{
 			AActor *me = block->Me;
 			FBlockNode *mynode = block;
-			HashEntry *entry;
-			int i;
 
 			block = block->NextActor;
 			// Don't recheck things that were already checked
@@ -1005,40 +1051,9 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 					return me;
 				}
 			}
-			else
+			else if (MarkChecked(me))
 			{
-				size_t hash = ((size_t)me >> 3) % countof(Buckets);
-				for (i = Buckets[hash]; i >= 0; )
-				{
-					entry = GetHashEntry(i);
-					if (entry->Actor == me)
-					{ // I've already been checked. Skip to the next actor.
-						break;
-					}
-					i = entry->Next;
-				}
-				if (i < 0)
-				{ // Add me to the hash table and return me.
-					if (NumFixedHash < (int)countof(FixedHash))
-					{
-						entry = &FixedHash[NumFixedHash];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = NumFixedHash++;
-					}
-					else
-					{
-						if (DynHash.Size() == 0)
-						{
-							DynHash.Grow(50);
-						}
-						i = DynHash.Reserve(1);
-						entry = &DynHash[i];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = i + countof(FixedHash);
-					}
-					entry->Actor = me;
-					return me;
-				}
+				return me;
 			}
 		}
 
@@ -1224,163 +1239,176 @@ void FPathTraverse::AddThingIntercepts (int bx, int by, FBlockThingsIterator &it
 	it.SwitchBlock(bx, by);
 	while ((thing = it.Next(compatible)))
 	{
-		int numfronts = 0;
-		divline_t line;
-		int i;
+		AddThingIntercept(thing, compatible);
+	}
+}
 
+//===========================================================================
+//
+// FPathTraverse :: AddThingIntercept
+//
+// Checks a single thing against the trace
+//
+//===========================================================================
+
+void FPathTraverse::AddThingIntercept(AActor *thing, bool compatible)
+{
+	int numfronts = 0;
+	divline_t line;
+	int i;
 
-		if (!compatible)
-		{
-			// [RH] Don't check a corner to corner crossection for hit.
-			// Instead, check against the actual bounding box (but not if compatibility optioned.)
 
-			// There's probably a smarter way to determine which two sides
-			// of the thing face the trace than by trying all four sides...
-			for (i = 0; i < 4; ++i)
+	if (!compatible)
+	{
+		// [RH] Don't check a corner to corner crossection for hit.
+		// Instead, check against the actual bounding box (but not if compatibility optioned.)
+
+		// There's probably a smarter way to determine which two sides
+		// of the thing face the trace than by trying all four sides...
+		for (i = 0; i < 4; ++i)
+		{
+			switch (i)
 			{
-				switch (i)
-				{
-				case 0:		// Top edge
-					line.y = thing->Y() + thing->radius;
-					if (trace.y < line.y) continue;
-					line.x = thing->X() + thing->radius;
-					line.dx = -thing->radius * 2;
-					line.dy = 0;
-					break;
-
-				case 1:		// Right edge
-					line.x = thing->X() + thing->radius;
-					if (trace.x < line.x) continue;
-					line.y = thing->Y() - thing->radius;
-					line.dx = 0;
-					line.dy = thing->radius * 2;
-					break;
-
-				case 2:		// Bottom edge
-					line.y = thing->Y() - thing->radius;
-					if (trace.y > line.y) continue;
-					line.x = thing->X() - thing->radius;
-					line.dx = thing->radius * 2;
-					line.dy = 0;
-					break;
-
-				case 3:		// Left edge
-					line.x = thing->X() - thing->radius;
-					if (trace.x > line.x) continue;
-					line.y = thing->Y() + thing->radius;
-					line.dx = 0;
-					line.dy = thing->radius * -2;
-					break;
-				}
-				// Check if this side is facing the trace origin
-				numfronts++;
+			case 0:		// Top edge
+				line.y = thing->Y() + thing->radius;
+				if (trace.y < line.y) continue;
+				line.x = thing->X() + thing->radius;
+				line.dx = -thing->radius * 2;
+				line.dy = 0;
+				break;
+
+			case 1:		// Right edge
+				line.x = thing->X() + thing->radius;
+				if (trace.x < line.x) continue;
+				line.y = thing->Y() - thing->radius;
+				line.dx = 0;
+				line.dy = thing->radius * 2;
+				break;
+
+			case 2:		// Bottom edge
+				line.y = thing->Y() - thing->radius;
+				if (trace.y > line.y) continue;
+				line.x = thing->X() - thing->radius;
+				line.dx = thing->radius * 2;
+				line.dy = 0;
+				break;
+
+			case 3:		// Left edge
+				line.x = thing->X() - thing->radius;
+				if (trace.x > line.x) continue;
+				line.y = thing->Y() + thing->radius;
+				line.dx = 0;
+				line.dy = thing->radius * -2;
+				break;
+			}
+			// Check if this side is facing the trace origin
+			numfronts++;
 
-				// If it is, see if the trace crosses it
-				if (P_PointOnDivlineSide (line.x, line.y, &trace) !=
-					P_PointOnDivlineSide (line.x + line.dx, line.y + line.dy, &trace))
-				{
-					// It's a hit
-					double frac = P_InterceptVector (&trace, &line);
-					if (frac < Startfrac)
-					{ // behind source
-						if (Startfrac > 0)
+			// If it is, see if the trace crosses it
+			if (P_PointOnDivlineSide (line.x, line.y, &trace) !=
+				P_PointOnDivlineSide (line.x + line.dx, line.y + line.dy, &trace))
+			{
+				// It's a hit
+				double frac = P_InterceptVector (&trace, &line);
+				if (frac < Startfrac)
+				{ // behind source
+					if (Startfrac > 0)
+					{
+						// check if the trace starts within this actor
+						switch (i)
 						{
-							// check if the trace starts within this actor
-							switch (i)
-							{
-							case 0:
-								line.y -= 2 * thing->radius;
-								break;
-
-							case 1:
-								line.x -= 2 * thing->radius;
-								break;
-
-							case 2:
-								line.y += 2 * thing->radius;
-								break;
-
-							case 3:
-								line.x += 2 * thing->radius;
-								break;
-							}
-							double frac2 = P_InterceptVector(&trace, &line);
-							if (frac2 >= Startfrac) goto addit;
+						case 0:
+							line.y -= 2 * thing->radius;
+							break;
+
+						case 1:
+							line.x -= 2 * thing->radius;
+							break;
+
+						case 2:
+							line.y += 2 * thing->radius;
+							break;
+
+						case 3:
+							line.x += 2 * thing->radius;
+							break;
 						}
-						continue;
+						double frac2 = P_InterceptVector(&trace, &line);
+						if (frac2 >= Startfrac) goto addit;
 					}
-				addit:
-					intercept_t newintercept;
-					newintercept.frac = frac;
-					newintercept.isaline = false;
-					newintercept.done = false;
-					newintercept.d.thing = thing;
-					intercepts.Push (newintercept);
-					break;
+					continue;
 				}
-			}
-
-			// If none of the sides was facing the trace, then the trace
-			// must have started inside the box, so add it as an intercept.
-			if (numfronts == 0)
-			{
+			addit:
 				intercept_t newintercept;
-				newintercept.frac = 0;
+				newintercept.frac = frac;
 				newintercept.isaline = false;
 				newintercept.done = false;
 				newintercept.d.thing = thing;
 				intercepts.Push (newintercept);
+				break;
 			}
 		}
+
+		// If none of the sides was facing the trace, then the trace
+		// must have started inside the box, so add it as an intercept.
+		if (numfronts == 0)
+		{
+			intercept_t newintercept;
+			newintercept.frac = 0;
+			newintercept.isaline = false;
+			newintercept.done = false;
+			newintercept.d.thing = thing;
+			intercepts.Push (newintercept);
+		}
+	}
+	else
+	{
+		// Old code for compatibility purposes
+		double 		x1, y1, x2, y2;
+		int 			s1, s2;
+		divline_t		dl;
+		double 		frac;
+			
+		bool tracepositive = (trace.dx * trace.dy)>0;
+					
+		// check a corner to corner crossection for hit
+		if (tracepositive)
+		{
+			x1 = thing->X() - thing->radius;
+			y1 = thing->Y() + thing->radius;
+					
+			x2 = thing->X() + thing->radius;
+			y2 = thing->Y() - thing->radius;					
+		}
 		else
 		{
-			// Old code for compatibility purposes
-			double 		x1, y1, x2, y2;
-			int 			s1, s2;
-			divline_t		dl;
-			double 		frac;
-				
-			bool tracepositive = (trace.dx * trace.dy)>0;
-						
-			// check a corner to corner crossection for hit
-			if (tracepositive)
-			{
-				x1 = thing->X() - thing->radius;
-				y1 = thing->Y() + thing->radius;
-						
-				x2 = thing->X() + thing->radius;
-				y2 = thing->Y() - thing->radius;					
-			}
-			else
-			{
-				x1 = thing->X() - thing->radius;
-				y1 = thing->Y() - thing->radius;
-						
-				x2 = thing->X() + thing->radius;
-				y2 = thing->Y() + thing->radius;					
-			}
+			x1 = thing->X() - thing->radius;
+			y1 = thing->Y() - thing->radius;
+					
+			x2 = thing->X() + thing->radius;
+			y2 = thing->Y() + thing->radius;					
+		}
+		
+		s1 = P_PointOnDivlineSide (x1, y1, &trace);
+		s2 = P_PointOnDivlineSide (x2, y2, &trace);
+
+		if (s1 != s2)
+		{
+			dl.x = x1;
+			dl.y = y1;
+			dl.dx = x2-x1;
+			dl.dy = y2-y1;
 			
-			s1 = P_PointOnDivlineSide (x1, y1, &trace);
-			s2 = P_PointOnDivlineSide (x2, y2, &trace);
+			frac = P_InterceptVector (&trace, &dl);
 
-			if (s1 != s2)
+			if (frac >= Startfrac)
 			{
-				dl.x = x1;
-				dl.y = y1;
-				dl.dx = x2-x1;
-				dl.dy = y2-y1;
-				
-				frac = P_InterceptVector (&trace, &dl);
-
-				if (frac >= Startfrac)
-				{
-					intercept_t newintercept;
-					newintercept.frac = frac;
-					newintercept.isaline = false;
-					newintercept.done = false;
-					newintercept.d.thing = thing;
-					intercepts.Push (newintercept);
-				}
+				intercept_t newintercept;
+				newintercept.frac = frac;
+				newintercept.isaline = false;
+				newintercept.done = false;
+				newintercept.d.thing = thing;
+				intercepts.Push (newintercept);
 			}
 		}
 	}
@@ -1978,13 +2006,15 @@ subsector_t *FLevelLocals::PointInSubsector(double x, double y)
 
 	fixed_t xx = FloatToFixed(x);
 	fixed_t yy = FloatToFixed(y);
-	do
+	void *entry = GameSubsectorGrid.GetEntry(xx, yy, node);
+	while (!((size_t)entry & 1))
 	{
+		node = (node_t *)entry;
 		side = R_PointOnSide(xx, yy, node);
-		node = (node_t *)node->children[side];
-	} while (!((size_t)node & 1));
+		entry = node->children[side];
+	}
 
-	return (subsector_t *)((uint8_t *)node - 1);
+	return (subsector_t *)((uint8_t *)entry - 1);
 }
 
 //==========================================================================
@@ -2031,16 +2061,16 @@ subsector_t *FLevelLocals::PointInRenderSubsector (fixed_t x, fixed_t y)
 	if (nodes.Size() == 0)
 		return &subsectors[0];
 	
-	node = HeadNode();
+	void *entry = RenderSubsectorGrid.GetEntry(x, y, HeadNode());
 	
-	do
+	while (!((size_t)entry & 1))
 	{
+		node = (node_t *)entry;
 		side = R_PointOnSide (x, y, node);
-		node = (node_t *)node->children[side];
+		entry = node->children[side];
 	}
-	while (!((size_t)node & 1));
 	
-	return (subsector_t *)((uint8_t *)node - 1);
+	return (subsector_t *)((uint8_t *)entry - 1);
 }
 
 
@@ -304,6 +304,7 @@ class FBlockThingsIterator
 	void StartBlock(int x, int y);
 	void SwitchBlock(int x, int y);
 	void ClearHash();
+	bool MarkChecked(AActor *me);
 
 	// The following is only for use in the path traverser 
 	// and therefore declared private.
@@ -373,6 +374,8 @@ protected:
 
 	virtual void AddLineIntercepts(int bx, int by);
 	virtual void AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible);
+	void AddThingIntercept(AActor *thing, bool compatible);
+	static bool MarkChecked(FBlockThingsIterator &it, AActor *me) { return it.MarkChecked(me); }
 	FPathTraverse(FLevelLocals *l) 
 	{
 		Level = l;
@@ -36,6 +36,7 @@
 
 msecnode_t *headsecnode = nullptr;
 FMemArena secnodearena;
+unsigned secnodechanges;	// changes whenever a node gets linked into or unlinked from any list
 
 //=============================================================================
 //
@@ -50,6 +51,7 @@ msecnode_t *P_GetSecnode()
 {
 	msecnode_t *node;
 
+	secnodechanges++;
 	if (headsecnode)
 	{
 		node = headsecnode;
@@ -72,6 +74,7 @@ msecnode_t *P_GetSecnode()
 
 void P_PutSecnode(msecnode_t *node)
 {
+	secnodechanges++;
 	node->m_snext = headsecnode;
 	headsecnode = node;
 }
@@ -935,6 +935,77 @@ done:
 	return res;
 }
 
+//==========================================================================
+//
+// FSightCache
+//
+//==========================================================================
+
+void FSightCache::Clear()
+{
+	for (auto &e : Entries) e.time = -1;
+	Hits = Misses = 0;
+}
+
+static inline uint64_t SightCacheMix(uint64_t h, double v)
+{
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	h ^= bits;
+	h *= 0x100000001b3ull;
+	return h ^ (h >> 29);
+}
+
+bool FSightCache::CheckSight(AActor *looker, AActor *target, int flags)
+{
+	// Only sight checks that do not call the RNG can be repeated safely.
+	assert(flags & SF_IGNOREVISIBILITY);
+
+	auto Level = looker->Level;
+	DVector3 lookerpos = looker->Pos();
+	DVector3 targetpos = target->Pos();
+
+	uint64_t h = 0xcbf29ce484222325ull;
+	h = SightCacheMix(h, lookerpos.X);
+	h = SightCacheMix(h, lookerpos.Y);
+	h = SightCacheMix(h, lookerpos.Z);
+	h = SightCacheMix(h, targetpos.X);
+	h = SightCacheMix(h, targetpos.Y);
+	h = SightCacheMix(h, targetpos.Z);
+	Entry &e = Entries[(h ^ (h >> 32)) & (CACHE_SIZE - 1)];
+
+	if (e.time == Level->maptime && e.geometry == Level->GeometryChangeCounter && e.flags == flags &&
+		e.lookerpos == lookerpos && e.targetpos == targetpos &&
+		e.lookerheight == looker->Height && e.targetheight == target->Height &&
+		e.lookersec == looker->Sector && e.targetsec == target->Sector)
+	{
+		Hits++;
+		return e.result;
+	}
+
+	Misses++;
+	e.result = !!P_CheckSight(looker, target, flags);
+	// P_CheckSight does not change the level, so the key is still current here.
+	e.lookerpos = lookerpos;
+	e.targetpos = targetpos;
+	e.lookerheight = looker->Height;
+	e.targetheight = target->Height;
+	e.lookersec = looker->Sector;
+	e.targetsec = target->Sector;
+	e.flags = flags;
+	e.time = Level->maptime;
+	e.geometry = Level->GeometryChangeCounter;
+	return e.result;
+}
+
+ADD_STAT (sightcache)
+{
+	FString out;
+	auto &cache = primaryLevel->RadiusSightCache;
+	out.Format ("Splash damage sight checks: %u cached, %u traced", cache.Hits, cache.Misses);
+	return out;
+}
+
 ADD_STAT (sight)
 {
 	FString out;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vectors.h"
+
+class AActor;
+struct sector_t;
+
+//============================================================================
+//
+// Short lived cache of P_CheckSight results for splash damage.
+//
+// A sight check that ignores visibility does not consume random numbers and
+// only depends on the positions, heights and sectors of the two actors and
+// on the level geometry. Entries are therefore keyed on exactly that data
+// and only stay valid for the tic they were made in and as long as no plane,
+// polyobject or blocking line changed.
+//
+//============================================================================
+
+class FSightCache
+{
+public:
+	void Clear();
+	bool CheckSight(AActor *looker, AActor *target, int flags);
+
+	unsigned Hits = 0;
+	unsigned Misses = 0;
+
+private:
+	struct Entry
+	{
+		DVector3 lookerpos;
+		DVector3 targetpos;
+		double lookerheight;
+		double targetheight;
+		sector_t *lookersec;
+		sector_t *targetsec;
+		int flags;
+		int time = -1;
+		unsigned geometry;
+		bool result;
+	};
+
+	enum
+	{
+		CACHE_SIZE = 512		// must be a power of 2
+	};
+
+	Entry Entries[CACHE_SIZE];
+};
@@ -0,0 +1,437 @@
+/*
+** p_soundgraph.cpp
+**
+** Sector adjacency graph and flood cache for monster sound alerts
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The flood performed here is the same one P_RecursiveSound used to do
+** by walking sector_t::Lines, but all the static parts (which lines are
+** two-sided, where the plane portals lead to) are precomputed, the door
+** checks are only redone for sectors that actually moved and complete
+** results get reused as long as nothing relevant changes.
+**
+*/
+
+#include "g_levellocals.h"
+#include "p_soundgraph.h"
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FSoundGraph::Clear()
+{
+	Level = nullptr;
+	Epoch = 0;
+	UseCounter = 0;
+	CheckedTime = -1;
+	EdgeStart.Reset();
+	Edges.Reset();
+	PortalLineStart.Reset();
+	PortalLines.Reset();
+	PlaneTargetStart.Reset();
+	PlaneTargets.Reset();
+	WatchedSectors.Reset();
+	WatchedLinePortals.Reset();
+	WatchedLines.Reset();
+	DirtyMark.Reset();
+	DirtySectors.Reset();
+	Traversed.Reset();
+	WorkList.Reset();
+	for (auto &c : Cache)
+	{
+		c.source = -1;
+		c.epoch = 0;
+		c.lastuse = 0;
+		c.nodes.Reset();
+	}
+}
+
+//==========================================================================
+//
+// Discards all cached floods. Needs to be called when something that
+// affects sound propagation changes which the graph cannot detect itself.
+//
+//==========================================================================
+
+void FSoundGraph::Invalidate()
+{
+	Epoch++;
+}
+
+//==========================================================================
+//
+// Called when a sector's planes move, e.g. from P_ChangeSector. The door
+// checks of this sector's lines will be redone before the next flood.
+//
+//==========================================================================
+
+void FSoundGraph::SectorMoved(sector_t *sec)
+{
+	if (Level == nullptr) return;
+
+	unsigned index = sec->Index();
+	if (index < DirtyMark.Size() && !DirtyMark[index])
+	{
+		DirtyMark[index] = 1;
+		DirtySectors.Push(sec);
+	}
+}
+
+//==========================================================================
+//
+// The 'closed door' check from P_RecursiveSound.
+// Note that this is not symmetric so it has to be done for both directions.
+//
+//==========================================================================
+
+bool FSoundGraph::IsClosed(sector_t *sec, sector_t *other, line_t *check)
+{
+	return (sec->floorplane.ZatPoint(check->v1->fPos()) >=
+		other->ceilingplane.ZatPoint(check->v1->fPos()) &&
+		sec->floorplane.ZatPoint(check->v2->fPos()) >=
+		other->ceilingplane.ZatPoint(check->v2->fPos()))
+		|| (other->floorplane.ZatPoint(check->v1->fPos()) >=
+			sec->ceilingplane.ZatPoint(check->v1->fPos()) &&
+			other->floorplane.ZatPoint(check->v2->fPos()) >=
+			sec->ceilingplane.ZatPoint(check->v2->fPos()))
+		|| (other->floorplane.ZatPoint(check->v1->fPos()) >=
+			other->ceilingplane.ZatPoint(check->v1->fPos()) &&
+			other->floorplane.ZatPoint(check->v2->fPos()) >=
+			other->ceilingplane.ZatPoint(check->v2->fPos()));
+}
+
+uint8_t FSoundGraph::PortalBlockBits(sector_t *sec)
+{
+	return uint8_t(sec->PortalBlocksSound(sector_t::floor) | (sec->PortalBlocksSound(sector_t::ceiling) << 1));
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FSoundGraph::Build(FLevelLocals *l)
+{
+	Clear();
+	Level = l;
+
+	unsigned numsectors = Level->sectors.Size();
+	EdgeStart.Resize(numsectors + 1);
+	PortalLineStart.Resize(numsectors + 1);
+	PlaneTargetStart.Resize(numsectors * 2 + 1);
+
+	for (auto &sec : Level->sectors)
+	{
+		unsigned index = sec.Index();
+
+		EdgeStart[index] = Edges.Size();
+		PortalLineStart[index] = PortalLines.Size();
+		for (auto check : sec.Lines)
+		{
+			if (check->portalindex != UINT_MAX)
+			{
+				PortalLines.Push(check);
+			}
+			if (check->sidedef[1] == nullptr || !(check->flags & ML_TWOSIDED)) continue;
+			if (check->sidedef[0]->sector == check->sidedef[1]->sector) continue;
+
+			sector_t *other = check->sidedef[0]->sector == &sec ? check->sidedef[1]->sector : check->sidedef[0]->sector;
+			Edges.Push({ check, other, UINT_MAX, IsClosed(&sec, other, check) });
+		}
+
+		// The sectors the plane portals look into only depend on static portal data,
+		// whether sound may actually pass through gets checked in the flood itself.
+		for (int plane = sector_t::floor; plane <= sector_t::ceiling; plane++)
+		{
+			unsigned first = PlaneTargets.Size();
+			PlaneTargetStart[index * 2 + plane] = first;
+			if (!(sec.planes[plane].Flags & PLANEF_LINKED)) continue;
+
+			DVector2 disp = sec.GetPortalDisplacement(plane);
+			for (auto check : sec.Lines)
+			{
+				sector_t *target = Level->PointInSector(check->v1->fPos() + check->Delta() / 2 + disp);
+				unsigned i;
+				for (i = first; i < PlaneTargets.Size(); i++)
+				{
+					if (PlaneTargets[i] == target) break;
+				}
+				if (i == PlaneTargets.Size()) PlaneTargets.Push(target);
+			}
+		}
+		if ((sec.planes[sector_t::floor].Flags | sec.planes[sector_t::ceiling].Flags) & PLANEF_LINKED)
+		{
+			WatchedSectors.Push({ &sec, PortalBlockBits(&sec) });
+		}
+	}
+	EdgeStart[numsectors] = Edges.Size();
+	PortalLineStart[numsectors] = PortalLines.Size();
+	PlaneTargetStart[numsectors * 2] = PlaneTargets.Size();
+
+	// Connect each edge with its counterpart so that a moving sector can update both directions.
+	for (unsigned i = 0; i < numsectors; i++)
+	{
+		for (unsigned e = EdgeStart[i]; e < EdgeStart[i + 1]; e++)
+		{
+			auto &edge = Edges[e];
+			unsigned o = edge.other->Index();
+			for (unsigned r = EdgeStart[o]; r < EdgeStart[o + 1]; r++)
+			{
+				if (Edges[r].line == edge.line && Edges[r].other == &Level->sectors[i])
+				{
+					edge.reverse = r;
+					break;
+				}
+			}
+		}
+	}
+
+	for (auto &port : Level->linePortals)
+	{
+		WatchedLinePortals.Push({ port.mDestination, port.mFlags & PORTF_SOUNDTRAVERSE });
+	}
+
+	// Every line that is or can become an edge of the graph.
+	for (auto &line : Level->lines)
+	{
+		if (line.sidedef[1] != nullptr && line.sidedef[0]->sector != line.sidedef[1]->sector)
+		{
+			WatchedLines.Push({ &line, line.flags & (ML_SOUNDBLOCK | ML_TWOSIDED) });
+		}
+	}
+
+	DirtyMark.Resize(numsectors);
+	memset(DirtyMark.Data(), 0, numsectors);
+	Traversed.Resize(numsectors);
+	CheckedTime = Level->maptime;
+	memset(Traversed.Data(), 0, numsectors * sizeof(int));
+}
+
+//==========================================================================
+//
+// Brings the graph up to date with the level and discards all cached
+// floods if something relevant for sound propagation has changed.
+// Returns false if the graph needs to be rebuilt.
+//
+//==========================================================================
+
+bool FSoundGraph::Update()
+{
+	bool changed = false;
+
+	// Sector movement gets reported, so this is cheap and done before every flood.
+	for (auto sec : DirtySectors)
+	{
+		unsigned index = sec->Index();
+		DirtyMark[index] = 0;
+		for (unsigned e = EdgeStart[index]; e < EdgeStart[index + 1]; e++)
+		{
+			auto &edge = Edges[e];
+			bool closed = IsClosed(sec, edge.other, edge.line);
+			if (closed != edge.closed)
+			{
+				edge.closed = closed;
+				changed = true;
+			}
+			if (edge.reverse != UINT_MAX)
+			{
+				auto &rev = Edges[edge.reverse];
+				closed = IsClosed(edge.other, sec, edge.line);
+				if (closed != rev.closed)
+				{
+					rev.closed = closed;
+					changed = true;
+				}
+			}
+		}
+	}
+	DirtySectors.Clear();
+
+	// Everything else has to be compared against the snapshot. That is only done once per tic
+	// so that repeated alerts, like from rapid fire, can use the cached floods without scanning the level.
+	if (CheckedTime != Level->maptime)
+	{
+		CheckedTime = Level->maptime;
+
+		for (auto &watch : WatchedLines)
+		{
+			uint32_t flags = watch.line->flags & (ML_SOUNDBLOCK | ML_TWOSIDED);
+			if (flags != watch.flags)
+			{
+				// Toggling ML_TWOSIDED adds or removes an edge.
+				if ((flags ^ watch.flags) & ML_TWOSIDED) return false;
+				watch.flags = flags;
+				changed = true;
+			}
+		}
+
+		for (auto &watch : WatchedSectors)
+		{
+			uint8_t blocks = PortalBlockBits(watch.sec);
+			if (blocks != watch.blocks)
+			{
+				watch.blocks = blocks;
+				changed = true;
+			}
+		}
+
+		for (unsigned i = 0; i < WatchedLinePortals.Size(); i++)
+		{
+			auto &port = Level->linePortals[i];
+			auto &watch = WatchedLinePortals[i];
+			uint32_t flags = port.mFlags & PORTF_SOUNDTRAVERSE;
+			if (port.mDestination != watch.destination || flags != watch.flags)
+			{
+				watch.destination = port.mDestination;
+				watch.flags = flags;
+				changed = true;
+			}
+		}
+	}
+
+	if (changed) Epoch++;
+	return true;
+}
+
+//==========================================================================
+//
+// Returns all sectors a sound starting in 'source' reaches, along with
+// the soundtraversed value each one ends up with. Each sector is listed
+// only once, the source sector always comes first.
+//
+//==========================================================================
+
+const TArray<FSoundGraph::FloodNode> &FSoundGraph::Flood(sector_t *source)
+{
+	auto level = source->Level;
+	if (Level != level || EdgeStart.Size() != level->sectors.Size() + 1 ||
+		WatchedLinePortals.Size() != level->linePortals.Size() || !Update())
+	{
+		Build(level);
+	}
+
+	int index = source->Index();
+	CachedFlood *victim = &Cache[0];
+	for (auto &c : Cache)
+	{
+		if (c.source == index && c.epoch == Epoch)
+		{
+			c.lastuse = ++UseCounter;
+			return c.nodes;
+		}
+		if (c.lastuse < victim->lastuse) victim = &c;
+	}
+
+	victim->source = index;
+	victim->epoch = Epoch;
+	victim->lastuse = ++UseCounter;
+	RunFlood(source, victim->nodes);
+	return victim->nodes;
+}
+
+//==========================================================================
+//
+// Traverses adjacent sectors, sound blocking lines cut off traversal.
+// Sectors which get reached with fewer sound blocking lines crossed
+// than before get reprocessed, just like P_RecursiveSound did.
+//
+//==========================================================================
+
+void FSoundGraph::RunFlood(sector_t *source, TArray<FloodNode> &result)
+{
+	result.Clear();
+	WorkList.Clear();
+
+	auto mark = [&](sector_t *sec, int soundblocks)
+	{
+		int &traversed = Traversed[sec->Index()];
+		if (traversed != 0 && traversed <= soundblocks + 1)
+		{
+			return;		// already flooded
+		}
+		if (traversed == 0) result.Push({ sec, 0 });
+		traversed = soundblocks + 1;
+		WorkList.Push({ sec, soundblocks });
+	};
+
+	mark(source, 0);
+	for (unsigned i = 0; i < WorkList.Size(); i++)
+	{
+		sector_t *sec = WorkList[i].sec;
+		int soundblocks = WorkList[i].soundtraversed;	// the work list stores the number of sound blocks crossed.
+		unsigned index = sec->Index();
+
+		for (int plane = sector_t::floor; plane <= sector_t::ceiling; plane++)
+		{
+			if (!sec->PortalBlocksSound(plane))
+			{
+				for (unsigned t = PlaneTargetStart[index * 2 + plane]; t < PlaneTargetStart[index * 2 + plane + 1]; t++)
+				{
+					mark(PlaneTargets[t], soundblocks);
+				}
+			}
+		}
+
+		for (unsigned p = PortalLineStart[index]; p < PortalLineStart[index + 1]; p++)
+		{
+			FLinePortal *port = PortalLines[p]->getPortal();
+			if (port && (port->mFlags & PORTF_SOUNDTRAVERSE) && port->mDestination)
+			{
+				mark(port->mDestination->frontsector, soundblocks);
+			}
+		}
+
+		for (unsigned e = EdgeStart[index]; e < EdgeStart[index + 1]; e++)
+		{
+			auto &edge = Edges[e];
+			if (edge.closed) continue;
+
+			if (edge.line->flags & ML_SOUNDBLOCK)
+			{
+				if (!soundblocks) mark(edge.other, 1);
+			}
+			else
+			{
+				mark(edge.other, soundblocks);
+			}
+		}
+	}
+
+	for (auto &node : result)
+	{
+		int &traversed = Traversed[node.sec->Index()];
+		node.soundtraversed = traversed;
+		traversed = 0;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "tarray.h"
+
+struct sector_t;
+struct line_t;
+struct FLevelLocals;
+
+//============================================================================
+//
+// Precomputed sector adjacency for the monster alert flood in P_NoiseAlert.
+//
+// The graph stores for each sector its two-sided lines (with the current
+// closed/open state of the opening), its sound traversing line portals and
+// the sectors its linked plane portals look into. Flood results are cached
+// per source sector and only get discarded when an opening actually changes
+// state, a portal changes its sound blocking or a line's ML_SOUNDBLOCK or
+// ML_TWOSIDED flag changes. Line flags can be written directly by scripts,
+// so they get compared against a snapshot once per tic instead of relying
+// on every writer to call Invalidate.
+//
+//============================================================================
+
+class FSoundGraph
+{
+public:
+	struct FloodNode
+	{
+		sector_t *sec;
+		int soundtraversed;		// same meaning as sector_t::soundtraversed
+	};
+
+	void Clear();
+	void Invalidate();
+	void SectorMoved(sector_t *sec);
+	const TArray<FloodNode> &Flood(sector_t *source);
+
+private:
+	struct Edge
+	{
+		line_t *line;
+		sector_t *other;
+		unsigned reverse;		// index of the edge going the opposite direction through the same line
+		bool closed;
+	};
+
+	struct PortalWatch
+	{
+		sector_t *sec;
+		uint8_t blocks;
+	};
+
+	struct LinePortalWatch
+	{
+		line_t *destination;
+		uint32_t flags;
+	};
+
+	struct LineWatch
+	{
+		line_t *line;
+		uint32_t flags;
+	};
+
+	struct CachedFlood
+	{
+		int source = -1;
+		unsigned epoch = 0;
+		unsigned lastuse = 0;
+		TArray<FloodNode> nodes;
+	};
+
+	enum
+	{
+		MAX_CACHED_FLOODS = 32
+	};
+
+	FLevelLocals *Level = nullptr;
+	unsigned Epoch = 0;
+	unsigned UseCounter = 0;
+	int CheckedTime = -1;		// maptime of the last comparison against the watched state
+
+	TArray<unsigned> EdgeStart;
+	TArray<Edge> Edges;
+	TArray<unsigned> PortalLineStart;
+	TArray<line_t *> PortalLines;
+	TArray<unsigned> PlaneTargetStart;	// indexed by sector * 2 + plane
+	TArray<sector_t *> PlaneTargets;
+
+	TArray<PortalWatch> WatchedSectors;
+	TArray<LinePortalWatch> WatchedLinePortals;
+	TArray<LineWatch> WatchedLines;
+
+	TArray<uint8_t> DirtyMark;
+	TArray<sector_t *> DirtySectors;
+
+	TArray<int> Traversed;
+	TArray<FloodNode> WorkList;
+	CachedFlood Cache[MAX_CACHED_FLOODS];
+
+	void Build(FLevelLocals *Level);
+	bool Update();
+	void RunFlood(sector_t *source, TArray<FloodNode> &result);
+	static bool IsClosed(sector_t *sec, sector_t *other, line_t *check);
+	static uint8_t PortalBlockBits(sector_t *sec);
+};
@@ -0,0 +1,269 @@
+/*
+** p_subsectorgrid.cpp
+** Grid accelerated point to subsector lookup
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "p_subsectorgrid.h"
+#include "g_levellocals.h"
+#include "r_utility.h"
+#include "c_dispatch.h"
+#include "m_random.h"
+#include "stats.h"
+#include "p_effect.h"
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FSubsectorGrid::Clear()
+{
+	Head = nullptr;
+	Width = Height = 0;
+	Cells.Reset();
+}
+
+//==========================================================================
+//
+// The grid covers the level's vertices. Everything outside of it just
+// walks the tree from the head node.
+//
+//==========================================================================
+
+void FSubsectorGrid::Build(FLevelLocals *Level, node_t *head)
+{
+	Clear();
+	if (head == nullptr || Level->vertexes.Size() == 0) return;
+
+	double left = Level->vertexes[0].fX(), right = left;
+	double bottom = Level->vertexes[0].fY(), top = bottom;
+	for (auto &v : Level->vertexes)
+	{
+		left = min(left, v.fX());
+		right = max(right, v.fX());
+		bottom = min(bottom, v.fY());
+		top = max(top, v.fY());
+	}
+
+	CellShift = MIN_CELL_SHIFT;
+	int64_t x0, y0, x1, y1;
+	do
+	{
+		int64_t cellsize = int64_t(1) << CellShift;
+		x0 = (int64_t(FloatToFixed(left)) >> CellShift) << CellShift;
+		y0 = (int64_t(FloatToFixed(bottom)) >> CellShift) << CellShift;
+		x1 = int64_t(FloatToFixed(right)) + 1;
+		y1 = int64_t(FloatToFixed(top)) + 1;
+		Width = unsigned((x1 - x0 + cellsize - 1) >> CellShift);
+		Height = unsigned((y1 - y0 + cellsize - 1) >> CellShift);
+	} while (uint64_t(Width) * Height > MAX_CELLS && ++CellShift);
+
+	OriginX = x0;
+	OriginY = y0;
+	Head = head;
+	Cells.Resize(Width * Height);
+	Fill(head, 0, 0, Width, Height);
+}
+
+//==========================================================================
+//
+// Checks on which side of the node's partition line the given block of
+// cells is. Returns -1 if it straddles the line.
+//
+// This has to give the same answer R_PointOnSide would give for every
+// point in the block. The function it evaluates is linear as long as the
+// coordinate differences do not overflow, so checking the corners is
+// enough. Blocks where a difference would wrap around are never resolved.
+//
+//==========================================================================
+
+int FSubsectorGrid::RegionSide(const node_t *node, unsigned x0, unsigned y0, unsigned x1, unsigned y1) const
+{
+	// Queries always come in as fixed point values, so nothing outside that range needs to be considered.
+	const int64_t xs[2] = { max<int64_t>(INT32_MIN, OriginX + (int64_t(x0) << CellShift)), min<int64_t>(INT32_MAX, OriginX + (int64_t(x1) << CellShift) - 1) };
+	const int64_t ys[2] = { max<int64_t>(INT32_MIN, OriginY + (int64_t(y0) << CellShift)), min<int64_t>(INT32_MAX, OriginY + (int64_t(y1) << CellShift) - 1) };
+	int side = -1;
+
+	if (node->dx == INT32_MIN || node->dy == INT32_MIN) return -1;
+
+	for (auto x : xs)
+	{
+		for (auto y : ys)
+		{
+			int64_t ddx = node->x - x;
+			int64_t ddy = y - node->y;
+			if (ddx <= INT32_MIN || ddx > INT32_MAX || ddy <= INT32_MIN || ddy > INT32_MAX) return -1;
+
+			int s = R_PointOnSide(fixed_t(x), fixed_t(y), node);
+			if (side == -1) side = s;
+			else if (side != s) return -1;
+		}
+	}
+	return side;
+}
+
+//==========================================================================
+//
+// Descends the tree for a block of cells as far as possible, then splits
+// the block if it is still larger than one cell.
+//
+//==========================================================================
+
+void FSubsectorGrid::Fill(void *node, unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+	while (!((size_t)node & 1))
+	{
+		int side = RegionSide((node_t *)node, x0, y0, x1, y1);
+		if (side < 0) break;
+		node = ((node_t *)node)->children[side];
+	}
+
+	if (((size_t)node & 1) || (x1 - x0 == 1 && y1 - y0 == 1))
+	{
+		for (unsigned y = y0; y < y1; y++)
+		{
+			for (unsigned x = x0; x < x1; x++)
+			{
+				Cells[y * Width + x] = node;
+			}
+		}
+	}
+	else if (x1 - x0 >= y1 - y0)
+	{
+		unsigned mid = (x0 + x1) / 2;
+		Fill(node, x0, y0, mid, y1);
+		Fill(node, mid, y0, x1, y1);
+	}
+	else
+	{
+		unsigned mid = (y0 + y1) / 2;
+		Fill(node, x0, y0, x1, mid);
+		Fill(node, x0, mid, x1, y1);
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+unsigned FSubsectorGrid::CountResolved() const
+{
+	unsigned count = 0;
+	for (auto cell : Cells)
+	{
+		if ((size_t)cell & 1) count++;
+	}
+	return count;
+}
+
+//==========================================================================
+//
+// Replays the positions of all actors and particles in the current level
+// plus a batch of random points through the grid and the plain tree walk
+// and compares speed and results.
+//
+//==========================================================================
+
+static FRandom pr_benchpoints;	// unnamed so that it does not end up in savegames
+
+CCMD(benchpointlocation)
+{
+	if (primaryLevel == nullptr || primaryLevel->subsectors.Size() == 0 || primaryLevel->HeadNode() == nullptr)
+	{
+		Printf("No level loaded\n");
+		return;
+	}
+	auto Level = primaryLevel;
+	int repeat = argv.argc() > 1 ? max(1, atoi(argv[1])) : 20;
+
+	TArray<DVector2> points;
+	auto it = Level->GetThinkerIterator<AActor>();
+	AActor *mo;
+	while ((mo = it.Next()))
+	{
+		points.Push(mo->Pos().XY());
+	}
+	for (uint16_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
+	{
+		points.Push(Level->Particles[i].Pos.XY());
+	}
+	// pad the stream with random points inside the map bounds.
+	double left = Level->vertexes[0].fX(), right = left;
+	double bottom = Level->vertexes[0].fY(), top = bottom;
+	for (auto &v : Level->vertexes)
+	{
+		left = min(left, v.fX());
+		right = max(right, v.fX());
+		bottom = min(bottom, v.fY());
+		top = max(top, v.fY());
+	}
+	while (points.Size() < 65536)
+	{
+		points.Push(DVector2(left + (right - left) * pr_benchpoints.GenRand_Real1(), bottom + (top - bottom) * pr_benchpoints.GenRand_Real1()));
+	}
+
+	TArray<subsector_t *> expected(points.Size(), true);
+	cycle_t walk, grid;
+	walk.Reset();
+	grid.Reset();
+
+	walk.Clock();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (unsigned i = 0; i < points.Size(); i++)
+		{
+			fixed_t x = FloatToFixed(points[i].X), y = FloatToFixed(points[i].Y);
+			void *node = Level->HeadNode();
+			while (!((size_t)node & 1)) node = ((node_t *)node)->children[R_PointOnSide(x, y, (node_t *)node)];
+			expected[i] = (subsector_t *)((uint8_t *)node - 1);
+		}
+	}
+	walk.Unclock();
+
+	unsigned mismatches = 0;
+	grid.Clock();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (unsigned i = 0; i < points.Size(); i++)
+		{
+			if (Level->PointInRenderSubsector(points[i]) != expected[i]) mismatches++;
+		}
+	}
+	grid.Unclock();
+
+	Printf("%u queries x %d: tree walk %.3f ms, grid %.3f ms, %u mismatches\n", points.Size(), repeat, walk.TimeMS(), grid.TimeMS(), mismatches);
+	Printf("Render grid %ux%u, %u of %u cells resolve to a subsector\n", Level->RenderSubsectorGrid.GetWidth(), Level->RenderSubsectorGrid.GetHeight(),
+		Level->RenderSubsectorGrid.CountResolved(), Level->RenderSubsectorGrid.GetWidth() * Level->RenderSubsectorGrid.GetHeight());
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include "tarray.h"
+#include "m_fixed.h"
+
+struct node_t;
+struct FLevelLocals;
+
+//============================================================================
+//
+// Uniform grid over a BSP tree to speed up point location.
+//
+// For each cell the tree is descended as far as every point inside the cell
+// ends up on the same side of the partition lines. The cell then stores the
+// subsector it resolved to or the node where its points start to diverge.
+// Lookups continue the regular R_PointOnSide walk from that entry, so the
+// result is always the same as walking from the head node.
+//
+//============================================================================
+
+class FSubsectorGrid
+{
+public:
+	void Clear();
+	void Build(FLevelLocals *Level, node_t *head);
+
+	// Returns where to start the BSP walk for the given point.
+	// This is either a node or a subsector pointer with bit 0 set, just like node_t::children.
+	void *GetEntry(fixed_t x, fixed_t y, node_t *head) const
+	{
+		if (head == Head)
+		{
+			uint64_t cx = uint64_t((int64_t(x) - OriginX) >> CellShift);
+			uint64_t cy = uint64_t((int64_t(y) - OriginY) >> CellShift);
+			if (cx < Width && cy < Height) return Cells[unsigned(cy * Width + cx)];
+		}
+		return head;
+	}
+
+	unsigned GetWidth() const { return Width; }
+	unsigned GetHeight() const { return Height; }
+	unsigned CountResolved() const;
+
+private:
+	enum
+	{
+		MIN_CELL_SHIFT = FRACBITS + 6,	// 64 map units
+		MAX_CELLS = 512 * 512,
+	};
+
+	node_t *Head = nullptr;
+	int64_t OriginX = 0, OriginY = 0;
+	int CellShift = MIN_CELL_SHIFT;
+	unsigned Width = 0, Height = 0;
+	TArray<void *> Cells;
+
+	void Fill(void *node, unsigned x0, unsigned y0, unsigned x1, unsigned y1);
+	int RegionSide(const node_t *node, unsigned x0, unsigned y0, unsigned x1, unsigned y1) const;
+};
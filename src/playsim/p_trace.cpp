@@ -67,6 +67,8 @@ struct FTraceInfo
 	double startfrac;
 	double limitz;
 	int ptflags;
+	FTraceBatch *Batch;
+	bool BatchStart;		// the first 3D floor setup can be taken from the batch
 
 	// These are required for 3D-floor checking
 	// to create a fake sector with a floor 
@@ -105,6 +107,29 @@ struct FTraceInfo
 
 static bool EditTraceResult (uint32_t flags, FTraceResults &res);
 
+//==========================================================================
+//
+// Path traverser which takes the things in the blockmap cells
+// from the batch's cache if there is one.
+//
+//==========================================================================
+
+class FTracePathTraverse : public FPathTraverse
+{
+	FTraceBatch *Batch;
+
+protected:
+	void AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible) override;
+
+public:
+	FTracePathTraverse(FTraceBatch *batch, FLevelLocals *l, double x1, double y1, double x2, double y2, int flags, double startfrac = 0)
+		: FPathTraverse(l)
+	{
+		Batch = batch;
+		init(x1, y1, x2, y2, flags, startfrac);
+	}
+};
+
 
 
 static void GetPortalTransition(DVector3 &pos, sector_t *&sec)
@@ -149,11 +174,10 @@ static bool isLiquid(F3DFloor *ff)
 //
 //==========================================================================
 
-bool Trace(const DVector3 &start, sector_t *sector, const DVector3 &direction, double maxDist,
+static bool RunTrace(FTraceInfo &inf, const DVector3 &start, sector_t *sector, const DVector3 &direction, double maxDist,
 	ActorFlags actorMask, uint32_t wallMask, AActor *ignore, FTraceResults &res, uint32_t flags,
 	ETraceStatus(*callback)(FTraceResults &res, void *), void *callbackdata)
 {
-	FTraceInfo inf;
 	FTraceResults tempResult;
 
 	memset(&tempResult, 0, sizeof(tempResult));
@@ -161,7 +185,6 @@ bool Trace(const DVector3 &start, sector_t *sector, const DVector3 &direction, d
 
 	inf.Level = sector->Level;
 	inf.Start = start;
-	GetPortalTransition(inf.Start, sector);
 	inf.ptflags = actorMask ? PT_ADDLINES|PT_ADDTHINGS|PT_COMPATIBLE : PT_ADDLINES;
 	inf.Vec = direction;
 	inf.ActorMask = actorMask;
@@ -207,6 +230,244 @@ bool Trace(const DVector3 &start, sector_t *sector, const DVector3 &direction, d
 	}
 }
 
+bool Trace(const DVector3 &start, sector_t *sector, const DVector3 &direction, double maxDist,
+	ActorFlags actorMask, uint32_t wallMask, AActor *ignore, FTraceResults &res, uint32_t flags,
+	ETraceStatus(*callback)(FTraceResults &res, void *), void *callbackdata)
+{
+	FTraceInfo inf;
+	DVector3 startpos = start;
+
+	GetPortalTransition(startpos, sector);
+	inf.Batch = nullptr;
+	inf.BatchStart = false;
+	return RunTrace(inf, startpos, sector, direction, maxDist, actorMask, wallMask, ignore, res, flags, callback, callbackdata);
+}
+
+//==========================================================================
+//
+// FTraceBatch
+//
+//==========================================================================
+
+void FTraceBatch::Begin(const DVector3 &start, sector_t *sector)
+{
+	Level = sector->Level;
+	Origin = start;
+	OriginSector = sector;
+	OriginTime = Level->maptime;
+	Prepared = false;
+	BlockIndex.Clear();
+	BlockThings.Clear();
+}
+
+bool FTraceBatch::Matches(const DVector3 &start, sector_t *sector) const
+{
+	return OriginSector == sector && Level == sector->Level && OriginTime == Level->maptime && Origin == start;
+}
+
+void FTraceBatch::Clear()
+{
+	Level = nullptr;
+	OriginSector = nullptr;
+	StartSector = nullptr;
+	OriginTime = -1;
+	Prepared = false;
+	WaterChecks.Clear();
+	BlockIndex.Clear();
+	BlockThings.Clear();
+}
+
+//==========================================================================
+//
+// Does the portal transition and the 3D floor clipping of the start
+// position. This is the same as what FTraceInfo::Setup3DFloors does
+// when a trace begins, minus the checks that depend on the direction.
+//
+//==========================================================================
+
+void FTraceBatch::Prepare()
+{
+	Start = Origin;
+	StartSector = OriginSector;
+	GetPortalTransition(Start, StartSector);
+
+	Prepared = true;
+	PreparedGeometryChange = Level->GeometryChangeCounter;
+	WaterChecks.Clear();
+	ClippedShootThrough = true;
+
+	TDeletingArray<F3DFloor*> &ff = StartSector->e->XFloor.ffloors;
+	HasClippedSector = ff.Size() > 0;
+	if (!HasClippedSector) return;
+
+	memcpy(&ClippedSector, StartSector, sizeof(sector_t));
+
+	double bf = ClippedSector.floorplane.ZatPoint(Start);
+	double bc = ClippedSector.ceilingplane.ZatPoint(Start);
+
+	for (auto rover : ff)
+	{
+		if (!(rover->flags&FF_EXISTS))
+			continue;
+
+		WaterChecks.Push({ rover, bf });
+
+		if (!(rover->flags&FF_SHOOTTHROUGH))
+		{
+			double ff_bottom = rover->bottom.plane->ZatPoint(Start);
+			double ff_top = rover->top.plane->ZatPoint(Start);
+			// clip to the part of the sector we are in
+			if (Start.Z > ff_top)
+			{
+				// above
+				if (bf < ff_top)
+				{
+					ClippedSector.floorplane = *rover->top.plane;
+					ClippedSector.SetTexture(sector_t::floor, *rover->top.texture, false);
+					ClippedSector.ClearPortal(sector_t::floor);
+					bf = ff_top;
+				}
+			}
+			else if (Start.Z < ff_bottom)
+			{
+				//below
+				if (bc > ff_bottom)
+				{
+					ClippedSector.ceilingplane = *rover->bottom.plane;
+					ClippedSector.SetTexture(sector_t::ceiling, *rover->bottom.texture, false);
+					bc = ff_bottom;
+					ClippedSector.ClearPortal(sector_t::ceiling);
+				}
+			}
+			else
+			{
+				// inside
+				if (bf < ff_bottom)
+				{
+					ClippedSector.floorplane = *rover->bottom.plane;
+					ClippedSector.SetTexture(sector_t::floor, *rover->bottom.texture, false);
+					ClippedSector.ClearPortal(sector_t::floor);
+					bf = ff_bottom;
+				}
+
+				if (bc > ff_top)
+				{
+					ClippedSector.ceilingplane = *rover->top.plane;
+					ClippedSector.SetTexture(sector_t::ceiling, *rover->top.texture, false);
+					ClippedSector.ClearPortal(sector_t::ceiling);
+					bc = ff_top;
+				}
+				ClippedShootThrough = false;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// Returns a snapshot of a blockmap cell's thing list. This gets
+// collected once and is used by all rays until an actor gets linked
+// into or unlinked from that cell. Changes elsewhere in the blockmap,
+// like the puff spawned by the previous pellet, leave it alone.
+//
+//==========================================================================
+
+const FTraceBatch::BlockThing *FTraceBatch::GetBlockThings(int bx, int by, unsigned &count)
+{
+	auto &blockmap = Level->blockmap;
+	int index = by * blockmap.bmapwidth + bx;
+	unsigned changes = blockmap.blockchanges[index];
+	auto range = BlockIndex.CheckKey(index);
+	if (range == nullptr || range->changes != changes)
+	{
+		// An outdated snapshot just gets abandoned, the array gets reset with the next Begin.
+		range = &BlockIndex.Insert(index, { BlockThings.Size(), 0, changes });
+		for (FBlockNode *block = blockmap.blocklinks[index]; block != nullptr; block = block->NextActor)
+		{
+			AActor *me = block->Me;
+			BlockThings.Push({ me, !(block->NextBlock == nullptr && block->PrevBlock == &me->BlockNode) });
+		}
+		range->count = BlockThings.Size() - range->first;
+	}
+	count = range->count;
+	return count > 0 ? &BlockThings[range->first] : nullptr;
+}
+
+//==========================================================================
+//
+// Runs one ray of the batch
+//
+//==========================================================================
+
+bool FTraceBatch::Trace(const DVector3 &direction, double maxDist,
+	ActorFlags actorMask, uint32_t wallMask, AActor *ignore, FTraceResults &res, uint32_t flags,
+	ETraceStatus(*callback)(FTraceResults &res, void *), void *callbackdata)
+{
+	if (OriginTime != Level->maptime)
+	{
+		// Cached data must not live beyond the tic it was collected in.
+		Begin(Origin, OriginSector);
+	}
+	if (!Prepared || PreparedGeometryChange != Level->GeometryChangeCounter)
+	{
+		Prepare();
+	}
+
+	FTraceInfo inf;
+	inf.Batch = this;
+	inf.BatchStart = true;
+	return RunTrace(inf, Start, StartSector, direction, maxDist, actorMask, wallMask, ignore, res, flags, callback, callbackdata);
+}
+
+//==========================================================================
+//
+// FTracePathTraverse :: AddThingIntercepts
+//
+// Same as FBlockThingsIterator would return, but from the batch's
+// snapshot of the cell.
+//
+//==========================================================================
+
+void FTracePathTraverse::AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible)
+{
+	if (Batch == nullptr || !Level->blockmap.isValidBlock(bx, by))
+	{
+		FPathTraverse::AddThingIntercepts(bx, by, it, compatible);
+		return;
+	}
+
+	unsigned count;
+	auto things = Batch->GetBlockThings(bx, by, count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		AActor *me = things[i].thing;
+		if (!things[i].spansblocks)
+		{
+			// This actor doesn't span blocks, so we know it can only ever be checked once.
+		}
+		else if (compatible)
+		{
+			// Block boundaries for compatibility mode
+			double blockleft = (bx * FBlockmap::MAPBLOCKUNITS) + Level->blockmap.bmaporgx;
+			double blockright = blockleft + FBlockmap::MAPBLOCKUNITS;
+			double blockbottom = (by * FBlockmap::MAPBLOCKUNITS) + Level->blockmap.bmaporgy;
+			double blocktop = blockbottom + FBlockmap::MAPBLOCKUNITS;
+
+			// only return actors with the center in this block
+			if (!(me->X() >= blockleft && me->X() < blockright &&
+				me->Y() >= blockbottom && me->Y() < blocktop))
+			{
+				continue;
+			}
+		}
+		else if (!MarkChecked(it, me))
+		{
+			continue;
+		}
+		AddThingIntercept(me, compatible);
+	}
+}
+
 
 //============================================================================
 //
@@ -289,6 +550,38 @@ void FTraceInfo::EnterLinePortal(FPathTraverse &pt, intercept_t *in)
 
 void FTraceInfo::Setup3DFloors()
 {
+	if (BatchStart)
+	{
+		// The clipping at the start position was already done by the batch,
+		// only the checks depending on the direction are left.
+		BatchStart = false;
+		if (Batch->HasClippedSector)
+		{
+			memcpy(&DummySector[0], &Batch->ClippedSector, sizeof(sector_t));
+			CurSector = &DummySector[0];
+			sectorsel = 1;
+
+			for (auto &check : Batch->WaterChecks)
+			{
+				if (Results->Crossed3DWater == NULL)
+				{
+					if (Check3DFloorPlane(check.rover, false) && isLiquid(check.rover))
+					{
+						// only consider if the plane is above the actual floor.
+						if (check.rover->top.plane->ZatPoint(Results->HitPos) > check.floorz)
+						{
+							Results->Crossed3DWater = check.rover;
+							Results->Crossed3DWaterPos = Results->HitPos;
+							Results->Distance = 0;
+						}
+					}
+				}
+			}
+			if (!Batch->ClippedShootThrough) inshootthrough = false;
+		}
+		return;
+	}
+
 	TDeletingArray<F3DFloor*> &ff = CurSector->e->XFloor.ffloors;
 
 	if (ff.Size())
@@ -779,7 +1072,7 @@ bool FTraceInfo::TraceTraverse (int ptflags)
 	// Do a 3D floor check in the starting sector
 	Setup3DFloors();
 
-	FPathTraverse it(Level, Start.X, Start.Y, Vec.X * MaxDist, Vec.Y * MaxDist, ptflags | PT_DELTA, startfrac);
+	FTracePathTraverse it(Batch, Level, Start.X, Start.Y, Vec.X * MaxDist, Vec.Y * MaxDist, ptflags | PT_DELTA, startfrac);
 	intercept_t *in;
 	int lastsplashsector = -1;
 
@@ -1078,6 +1371,73 @@ DEFINE_ACTION_FUNCTION(DLineTracer, Trace)
 	ACTION_RETURN_BOOL(res);
 }
 
+IMPLEMENT_CLASS(DLineTracerBatch, false, false)
+
+DLineTracerBatch *DLineTracerBatch::FirstBatch;
+
+DLineTracerBatch::DLineTracerBatch()
+{
+	NextBatch = FirstBatch;
+	if (NextBatch != nullptr) NextBatch->PrevBatch = this;
+	FirstBatch = this;
+}
+
+DLineTracerBatch::~DLineTracerBatch()
+{
+	if (PrevBatch != nullptr) PrevBatch->NextBatch = NextBatch;
+	else FirstBatch = NextBatch;
+	if (NextBatch != nullptr) NextBatch->PrevBatch = PrevBatch;
+}
+
+//==========================================================================
+//
+// Called when a level's data gets deleted. A batch still pointing into
+// it would otherwise reference freed sectors and actors.
+//
+//==========================================================================
+
+void DLineTracerBatch::ClearLevel(FLevelLocals *Level)
+{
+	for (auto batch = FirstBatch; batch != nullptr; batch = batch->NextBatch)
+	{
+		if (batch->Batch.GetLevel() == Level) batch->Batch.Clear();
+	}
+}
+
+DEFINE_ACTION_FUNCTION(DLineTracerBatch, SetOrigin)
+{
+	PARAM_SELF_PROLOGUE(DLineTracerBatch);
+	PARAM_FLOAT(start_x);
+	PARAM_FLOAT(start_y);
+	PARAM_FLOAT(start_z);
+	PARAM_POINTER_NOT_NULL(sector, sector_t);
+	self->Batch.Begin(DVector3(start_x, start_y, start_z), sector);
+	return 0;
+}
+
+DEFINE_ACTION_FUNCTION(DLineTracerBatch, TraceRay)
+{
+	PARAM_SELF_PROLOGUE(DLineTracerBatch);
+	PARAM_FLOAT(direction_x);
+	PARAM_FLOAT(direction_y);
+	PARAM_FLOAT(direction_z);
+	PARAM_FLOAT(maxDist);
+	PARAM_INT(traceFlags);
+
+	if (!self->Batch.IsActive())
+	{
+		ThrowAbortException(X_OTHER, "LineTracerBatch.TraceRay called without an origin");
+	}
+
+	// same restrictions as LineTracer.Trace
+	traceFlags &= ~(TRACE_PCross | TRACE_Impact);
+	traceFlags |= TRACE_3DCallback;
+
+	bool res = self->Batch.Trace(DVector3(direction_x, direction_y, direction_z), maxDist,
+					 (ActorFlag)0xFFFFFFFF, 0xFFFFFFFF, nullptr, self->Results, traceFlags, &DLineTracer::TraceCallback, self);
+	ACTION_RETURN_BOOL(res);
+}
+
 ETraceStatus DLineTracer::TraceCallback(FTraceResults& res, void* pthis)
 {
 	DLineTracer* self = (DLineTracer*)pthis;
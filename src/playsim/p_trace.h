@@ -38,6 +38,7 @@
 #include "actor.h"
 #include "cmdlib.h"
 #include "textures.h"
+#include "r_defs.h"
 
 struct sector_t;
 struct line_t;
@@ -115,6 +116,74 @@ bool Trace(const DVector3 &start, sector_t *sector, const DVector3 &direction, d
 	ActorFlags ActorMask, uint32_t WallMask, AActor *ignore, FTraceResults &res, uint32_t traceFlags = 0,
 	ETraceStatus(*callback)(FTraceResults &res, void *) = NULL, void *callbackdata = NULL);
 
+//==========================================================================
+//
+// Runs several traces from a common origin, like the pellets of a
+// shotgun blast. The portal transition and the 3D floor setup of the
+// starting position are only done once and the contents of the blockmap
+// cells get gathered once for all rays. Results are identical to calling
+// Trace() for each ray, cached data gets discarded as soon as something
+// it depends on changes.
+//
+//==========================================================================
+
+class FTraceBatch
+{
+	friend struct FTraceInfo;
+	friend class FTracePathTraverse;
+
+	struct WaterCheck
+	{
+		F3DFloor *rover;
+		double floorz;	// floor height when the 3D floor was checked.
+	};
+
+	struct BlockThing
+	{
+		AActor *thing;
+		bool spansblocks;
+	};
+
+	struct BlockRange
+	{
+		unsigned first;
+		unsigned count;
+		unsigned changes;	// the block's change counter when the snapshot was taken
+	};
+
+	FLevelLocals *Level = nullptr;
+	DVector3 Origin;
+	sector_t *OriginSector = nullptr;
+	int OriginTime = -1;
+
+	// origin data after the portal transition and 3D floor clipping.
+	bool Prepared = false;
+	unsigned PreparedGeometryChange = 0;
+	DVector3 Start;
+	sector_t *StartSector = nullptr;
+	bool HasClippedSector = false;
+	bool ClippedShootThrough = true;
+	sector_t ClippedSector;
+	TArray<WaterCheck> WaterChecks;
+
+	// blockmap cells' thing lists
+	TMap<int, BlockRange> BlockIndex;
+	TArray<BlockThing> BlockThings;
+
+	void Prepare();
+	const BlockThing *GetBlockThings(int bx, int by, unsigned &count);
+
+public:
+	void Begin(const DVector3 &start, sector_t *sector);
+	bool Matches(const DVector3 &start, sector_t *sector) const;
+	void Clear();
+	bool IsActive() const { return OriginSector != nullptr; }
+	FLevelLocals *GetLevel() const { return Level; }
+	bool Trace(const DVector3 &direction, double maxDist,
+		ActorFlags ActorMask, uint32_t WallMask, AActor *ignore, FTraceResults &res, uint32_t traceFlags = 0,
+		ETraceStatus(*callback)(FTraceResults &res, void *) = NULL, void *callbackdata = NULL);
+};
+
 // [ZZ] this is the object that's used for ZScript
 class DLineTracer : public DObject
 {
@@ -125,4 +194,23 @@ public:
 	ETraceStatus CallZScriptCallback();
 };
 
+// ZScript interface to FTraceBatch
+// Scripts can keep these around across a level change, so all live
+// instances are tracked to drop their cached level data when it goes away.
+class DLineTracerBatch : public DLineTracer
+{
+	DECLARE_CLASS(DLineTracerBatch, DLineTracer)
+
+	DLineTracerBatch *PrevBatch = nullptr;
+	DLineTracerBatch *NextBatch = nullptr;
+	static DLineTracerBatch *FirstBatch;
+
+public:
+	FTraceBatch Batch;
+
+	DLineTracerBatch();
+	~DLineTracerBatch();
+	static void ClearLevel(FLevelLocals *Level);
+};
+
 #endif //__P_TRACE_H__
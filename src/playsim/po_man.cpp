@@ -1161,6 +1161,8 @@ void FPolyObj::LinkPolyobj ()
 	int bmapwidth = Level->blockmap.bmapwidth;
 	int bmapheight = Level->blockmap.bmapheight;
 
+	Level->GeometryChangeCounter++;
+
 	// calculate the polyobj bbox
 	Bounds.ClearBox();
 	for(unsigned i = 0; i < Sidedefs.Size(); i++)
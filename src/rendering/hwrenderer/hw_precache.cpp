@@ -40,8 +40,201 @@
 #include "modelrenderer.h"
 #include "hw_models.h"
 #include "d_main.h"
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 EXTERN_CVAR(Bool, gl_precache)
+CVAR(Int, gl_precache_threads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// 0 picks the number of threads from the CPU, 1 disables the worker threads
+
+//==========================================================================
+//
+// Parallel texture buffer creation
+//
+// Reading and decoding images goes through the file system and the image
+// source caches, none of which can be used from more than one thread, so
+// this stays on the main thread. Upscaling and edge smoothing only work on
+// the buffer itself and get handed to worker threads while the main thread
+// already loads the next image.
+//
+// The finished buffers are uploaded in the order they were queued, as soon
+// as all layers of their material are done, and freed right away. Only a
+// few buffers per thread may be waiting for that at any time, so memory
+// use does not grow with the size of the level.
+//
+//==========================================================================
+
+class FTexturePrecacher
+{
+	struct Job
+	{
+		FTexture *tex;
+		int flags;
+		int isTransparent;
+		bool masked;
+		bool done;
+		unsigned material;
+		FTextureBuffer buffer;
+	};
+
+	struct Material
+	{
+		FMaterial *mat;
+		SpriteHits *translations;	// nullptr for textures, which only get precached untranslated.
+	};
+
+	enum
+	{
+		JOBS_PER_THREAD = 4	// how many buffers may be in memory per thread before the oldest needs to be uploaded.
+	};
+
+	TMap<FTexture *, bool> Queued;
+	TArray<Job> Jobs;
+	TArray<Material> Materials;
+	std::mutex Lock;
+	std::condition_variable Ready;
+	std::condition_variable Finished;
+	unsigned Loaded = 0;
+	unsigned Next = 0;
+	unsigned Uploaded = 0;
+	bool Done = false;
+	std::exception_ptr WorkerError;
+
+	void WorkerMain()
+	{
+		while (true)
+		{
+			Job *job;
+			{
+				std::unique_lock<std::mutex> lock(Lock);
+				Ready.wait(lock, [this] { return Next < Loaded || Done; });
+				if (Next >= Loaded) return;
+				job = &Jobs[Next++];
+			}
+			try
+			{
+				job->masked = job->tex->ProcessTexBuffer(job->buffer, job->flags, job->isTransparent);
+			}
+			catch (...)
+			{
+				// An exception must not leave the thread. The main thread rethrows it when it waits for this job.
+				{
+					std::lock_guard<std::mutex> lock(Lock);
+					if (!WorkerError) WorkerError = std::current_exception();
+				}
+				Finished.notify_all();
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(Lock);
+				job->done = true;
+			}
+			Finished.notify_all();
+		}
+	}
+
+	// Lets the workers finish what has been loaded so far and waits for them.
+	// Must happen before the threads go out of scope, even when an error is thrown.
+	void StopWorkers(std::vector<std::thread> &threads)
+	{
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			Done = true;
+		}
+		Ready.notify_all();
+		for (auto &t : threads) t.join();
+		threads.clear();
+	}
+
+	// Waits for the oldest job that has not been uploaded yet. Once the last
+	// job of a material is done, the backend gets to create its textures.
+	void UploadNext()
+	{
+		auto &job = Jobs[Uploaded];
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			Finished.wait(lock, [&] { return job.done || WorkerError; });
+			if (!job.done) std::rethrow_exception(WorkerError);
+		}
+		job.tex->AddPrecachedBuffer(std::move(job.buffer), job.flags, job.masked);
+		Uploaded++;
+
+		if (Uploaded == Jobs.Size() || Jobs[Uploaded].material != job.material)
+		{
+			auto &mat = Materials[job.material];
+			if (mat.translations == nullptr)
+			{
+				screen->PrecacheMaterial(mat.mat, 0);
+			}
+			else
+			{
+				SpriteHits::Iterator it(*mat.translations);
+				SpriteHits::Pair *pair;
+				while (it.NextPair(pair)) screen->PrecacheMaterial(mat.mat, pair->Key);
+			}
+			FTexture::FlushPrecachedBuffers();	// whatever the backend did not take.
+		}
+	}
+
+public:
+	void AddMaterial(FMaterial *mat, SpriteHits *translations)
+	{
+		// The base layer may be needed with translations only, the other layers always get created untranslated.
+		bool untranslated = translations == nullptr || translations->CheckKey(0);
+		auto &layers = mat->GetLayerArray();
+		for (unsigned i = untranslated ? 0 : 1; i < layers.Size(); i++)
+		{
+			auto tex = layers[i].layerTexture;
+			int flags = layers[i].scaleFlags | CTF_ProcessData;
+			if (tex == nullptr || tex->GetImage() == nullptr || tex->isHardwareCanvas()) continue;
+			if (tex->SystemTextures.GetHardwareTexture(0, layers[i].scaleFlags) != nullptr) continue;
+			if (Queued.CheckKey(tex)) continue;	// must not process the same texture twice at the same time.
+			Queued.Insert(tex, true);
+			Jobs.Reserve(1);
+			auto &job = Jobs.Last();
+			job.tex = tex;
+			job.flags = flags;
+			job.done = false;
+			job.material = Materials.Size();
+		}
+		// Materials whose layers all exist already are left to the regular precaching.
+		if (Jobs.Size() > 0 && Jobs.Last().material == Materials.Size())
+		{
+			Materials.Push({ mat, translations });
+		}
+	}
+
+	void Run(int numthreads)
+	{
+		std::vector<std::thread> threads;
+		for (int i = 0; i < numthreads; i++) threads.emplace_back([this] { WorkerMain(); });
+
+		unsigned window = (numthreads + 1) * JOBS_PER_THREAD;
+		try
+		{
+			for (auto &job : Jobs)
+			{
+				while (Loaded - Uploaded >= window) UploadNext();
+				job.isTransparent = job.tex->LoadTexBuffer(job.buffer, 0, job.flags);
+				{
+					std::lock_guard<std::mutex> lock(Lock);
+					Loaded++;
+				}
+				Ready.notify_one();
+			}
+			while (Uploaded < Jobs.Size()) UploadNext();
+		}
+		catch (...)
+		{
+			StopWorkers(threads);
+			FTexture::FlushPrecachedBuffers();
+			throw;
+		}
+		StopWorkers(threads);
+	}
+};
 
 //==========================================================================
 //
@@ -299,6 +492,36 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 			}
 		}
 
+		int numthreads = gl_precache_threads > 0 ? gl_precache_threads : (int)std::thread::hardware_concurrency();
+		numthreads = clamp(numthreads, 1, 32) - 1;	// the main thread is busy loading the images.
+		if (numthreads > 0)
+		{
+			// create and upload the texture buffers up front so that the expensive parts can run in parallel.
+			FTexturePrecacher precacher;
+			for (int i = cnt - 1; i >= 0; i--)
+			{
+				auto gtex = TexMan.GameByIndex(i);
+				if (gtex == nullptr) continue;
+				if (texhitlist[i] & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky))
+				{
+					int scaleflags = 0;
+					if (shouldUpscale(gtex, UF_Texture)) scaleflags |= CTF_Upscale;
+
+					FMaterial *mat = FMaterial::ValidateTexture(gtex, scaleflags);
+					if (mat) precacher.AddMaterial(mat, nullptr);
+				}
+				if (spritehitlist[i] != nullptr && (*spritehitlist[i]).CountUsed() > 0)
+				{
+					int scaleflags = CTF_Expand;
+					if (shouldUpscale(gtex, UF_Sprite)) scaleflags |= CTF_Upscale;
+
+					FMaterial *mat = FMaterial::ValidateTexture(gtex, scaleflags);
+					if (mat) precacher.AddMaterial(mat, spritehitlist[i]);
+				}
+			}
+			precacher.Run(numthreads);
+		}
+
 		// cache all used textures
 		for (int i = cnt - 1; i >= 0; i--)
 		{
@@ -314,6 +537,7 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 		}
 
 
+		FTexture::FlushPrecachedBuffers();	// whatever the backend did not need anymore.
 		FImageSource::EndPrecaching();
 
 		// cache all used models
@@ -42,6 +42,7 @@
 #include "hw_clock.h"
 #include "flatvertices.h"
 #include "hw_vertexbuilder.h"
+#include "tracezones.h"
 
 #ifdef ARCH_IA32
 #include <immintrin.h>
@@ -55,6 +56,26 @@ thread_local bool isWorkerThread;
 ctpl::thread_pool renderPool(1);
 bool inited = false;
 
+//==========================================================================
+//
+// Number of threads processing the jobs queued by the BSP traversal.
+// 0 picks a default based on the number of cores, leaving enough for
+// the main thread and the rest of the engine.
+//
+//==========================================================================
+
+CUSTOM_CVAR(Int, gl_multithread_workers, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > MAX_SCENE_WORKERS) self = MAX_SCENE_WORKERS;
+}
+
+static int GetSceneWorkerCount()
+{
+	if (gl_multithread_workers > 0) return gl_multithread_workers;
+	return clamp<int>(std::thread::hardware_concurrency() / 2, 1, 4);
+}
+
 struct RenderJob
 {
 	enum
@@ -64,14 +85,16 @@ struct RenderJob
 		SpriteJob,
 		ParticleJob,
 		PortalJob,
-		TerminateJob	// inserted when all work is done so that the worker can return.
 	};
 	
 	int type;
+	uint32_t seq;	// position in the traversal order, used to merge the worker outputs.
 	subsector_t *sub;
 	seg_t *seg;
 };
 
+static uint32_t jobSequence;
+static std::atomic<bool> jobsDone;
 
 class RenderJobQueue
 {
@@ -83,13 +106,18 @@ public:
 	{
 		// This does not check for array overflows. The pool should be large enough that it never hits the limit.
 
-		pool[writeindex] = { type, sub, seg };
+		pool[writeindex] = { type, jobSequence++, sub, seg };
 		writeindex++;	// update index only after the value has been written.
 	}
 
 	RenderJob *GetJob()
 	{
-		if (readindex < writeindex) return &pool[readindex++];
+		// Multiple workers may read from the same queue so the index must be claimed atomically.
+		int index = readindex;
+		while (index < writeindex)
+		{
+			if (readindex.compare_exchange_weak(index, index + 1)) return &pool[index];
+		}
 		return nullptr;
 	}
 	
@@ -100,19 +128,60 @@ public:
 	}
 };
 
-static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
+// One static queue of each is sufficient here. This code will never be called recursively.
+// Walls and flats can be processed by any worker. Sprites are deduplicated through the actors'
+// validcount and sector portals modify shared data, so all of these go to the first worker.
+static RenderJobQueue jobQueue;
+static RenderJobQueue spriteQueue;
+
+static int lastWorkerCount;
+static int lastJobCounts[MAX_SCENE_WORKERS + 1];
+static cycle_t MergeTime;
 
-void HWDrawInfo::WorkerThread()
+ADD_STAT(hwworkers)
 {
+	FString out;
+	out.Format("%d workers, merge=%2.3f ms, jobs:", lastWorkerCount, MergeTime.TimeMS());
+	for (int i = 0; i < lastWorkerCount; i++)
+	{
+		out.AppendFormat(" %d", lastJobCounts[i]);
+	}
+	out.AppendFormat(", sprite jobs: %d", lastJobCounts[SPRITE_WORKER_OUTPUT]);
+	return out;
+}
+
+void HWDrawInfo::WorkerThread(int worker)
+{
+	Trace_SetThreadName("BSP worker");
+	TRACE_ZONE("HWDrawInfo::WorkerThread");
 	sector_t *front, *back;
 
-	WTTotal.Clock();
+	// The profiling clocks are not thread safe so only the first worker may use them.
+	static thread_local glcycle_t unusedClock;
+	auto &setupWall = worker == 0 ? SetupWall : unusedClock;
+	auto &setupFlat = worker == 0 ? SetupFlat : unusedClock;
+	auto &setupSprite = worker == 0 ? SetupSprite : unusedClock;
+	auto &wtTotal = worker == 0 ? WTTotal : unusedClock;
+
+	auto &output = SceneWorkerOutputs[worker];
+	auto &spriteOutput = SceneWorkerOutputs[SPRITE_WORKER_OUTPUT];
+
+	wtTotal.Clock();
 	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
 	while (true)
 	{
-		auto job = jobQueue.GetJob();
+		// This must be checked before looking at the queues. Once it is set, an empty queue means that all work is done.
+		bool done = jobsDone;
+		RenderJob *job = worker == 0 ? spriteQueue.GetJob() : nullptr;
+		CurrentWorkerOutput = &spriteOutput;
+		if (job == nullptr)
+		{
+			job = jobQueue.GetJob();
+			CurrentWorkerOutput = &output;
+		}
 		if (job == nullptr)
 		{
+			if (done) break;
 #ifdef ARCH_IA32
 			// The queue is empty. But yielding would be too costly here and possibly cause further delays down the line if the thread is halted.
 			// So instead add a few pause instructions and retry immediately.
@@ -127,19 +196,20 @@ void HWDrawInfo::WorkerThread()
 			_mm_pause();
 			_mm_pause();
 #endif // ARCH_IA32
+			continue;
 		}
+
+		CurrentWorkerOutput->job = job->seq;
+		CurrentWorkerOutput->jobs++;
+
 		// Note that the main thread MUST have prepared the fake sectors that get used below!
 		// This worker thread cannot prepare them itself without costly synchronization.
-		else switch (job->type)
+		switch (job->type)
 		{
-		case RenderJob::TerminateJob:
-			WTTotal.Unclock();
-			return;
-
 		case RenderJob::WallJob:
 		{
 			HWWall wall;
-			SetupWall.Clock();
+			setupWall.Clock();
 			wall.sub = job->sub;
 
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
@@ -170,44 +240,183 @@ void HWDrawInfo::WorkerThread()
 			else back = nullptr;
 
 			wall.Process(this, job->seg, front, back);
-			rendered_lines++;
-			SetupWall.Unclock();
+			CurrentWorkerOutput->lines++;
+			setupWall.Unclock();
 			break;
 		}
 
 		case RenderJob::FlatJob:
 		{
 			HWFlat flat;
-			SetupFlat.Clock();
+			setupFlat.Clock();
 			flat.section = job->sub->section;
 			front = hw_FakeFlat(job->sub->render_sector, in_area, false);
 			flat.ProcessSector(this, front);
-			SetupFlat.Unclock();
+			setupFlat.Unclock();
 			break;
 		}
 
 		case RenderJob::SpriteJob:
-			SetupSprite.Clock();
+			setupSprite.Clock();
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
 			RenderThings(job->sub, front);
-			SetupSprite.Unclock();
+			setupSprite.Unclock();
 			break;
 
 		case RenderJob::ParticleJob:
-			SetupSprite.Clock();
+			setupSprite.Clock();
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
 			RenderParticles(job->sub, front);
-			SetupSprite.Unclock();
+			setupSprite.Unclock();
 			break;
 
 		case RenderJob::PortalJob:
 			AddSubsectorToPortal((FSectorPortalGroup *)job->seg, job->sub);
 			break;
 		}
+	}
+	CurrentWorkerOutput = nullptr;
+	wtTotal.Unclock();
+}
+
+//==========================================================================
+//
+// Merges per-worker arrays that are each sorted by job sequence number.
+// Each step copies the longest run from one worker that comes before
+// anything still pending in the others. The merge stops at the first
+// item 'stop' rejects and continues from there on the next call.
+//
+//==========================================================================
+
+template<class Size, class Job, class Stop, class Append>
+static void MergeBySequence(unsigned *pos, int count, Size size, Job job, Stop stop, Append append)
+{
+	while (true)
+	{
+		int best = -1;
+		uint32_t bestjob = UINT32_MAX, nextjob = UINT32_MAX;
+		for (int i = 0; i < count; i++)
+		{
+			if (pos[i] >= size(i)) continue;
+			uint32_t j = job(i, pos[i]);
+			if (j < bestjob)
+			{
+				nextjob = bestjob;
+				bestjob = j;
+				best = i;
+			}
+			else if (j < nextjob) nextjob = j;
+		}
+		if (best < 0 || stop(best, pos[best])) return;
+		do
+		{
+			append(best, pos[best]++);
+		} while (pos[best] < size(best) && job(best, pos[best]) < nextjob && !stop(best, pos[best]));
+	}
+}
+
+//==========================================================================
+//
+// Puts everything the workers produced into this HWDrawInfo in the same
+// order a single thread would have produced it. The recorded operations
+// on the shared data are performed in between, at the point where their
+// job created them, because some of them add draw items of their own.
+//
+//==========================================================================
+
+void HWDrawInfo::MergeWorkerOutputs(int numworkers)
+{
+	HWWorkerOutput *outputs[MAX_SCENE_WORKERS + 1];
+	int count = 0;
+	for (int i = 0; i < numworkers; i++) outputs[count++] = &SceneWorkerOutputs[i];
+	outputs[count++] = &SceneWorkerOutputs[SPRITE_WORKER_OUTPUT];
+
+	MergeTime.Reset();
+	MergeTime.Clock();
+
+	// Appends all items that were created before the given operation, or all that are left.
+	unsigned itempos[GLDL_TYPES][MAX_SCENE_WORKERS + 1] = {};
+	auto mergeItems = [&](int worker, const HWDeferredOp *op)
+	{
+		for (int list = 0; list < GLDL_TYPES; list++)
+		{
+			MergeBySequence(itempos[list], count,
+				[&](int i) { return outputs[i]->itemjobs[list].Size(); },
+				[&](int i, unsigned n) { return outputs[i]->itemjobs[list][n]; },
+				[&](int i, unsigned n)
+				{
+					if (op == nullptr) return false;
+					uint32_t j = outputs[i]->itemjobs[list][n];
+					return j > op->job || (j == op->job && (i != worker || n >= op->items[list]));
+				},
+				[&](int i, unsigned n) { drawlists[list].AppendItem(outputs[i]->drawlists[list], n); });
+		}
+	};
+
+	unsigned oppos[MAX_SCENE_WORKERS + 1] = {};
+	MergeBySequence(oppos, count,
+		[&](int i) { return outputs[i]->deferred.Size(); },
+		[&](int i, unsigned n) { return outputs[i]->deferred[n].job; },
+		[&](int i, unsigned n) { return false; },
+		[&](int i, unsigned n)
+		{
+			auto &op = outputs[i]->deferred[n];
+			mergeItems(i, &op);
+			ReplayDeferredOp(op);
+		});
+	mergeItems(-1, nullptr);
+
+	for (int k = 0; k < 2; k++)
+	{
+		unsigned decalpos[MAX_SCENE_WORKERS + 1] = {};
+		MergeBySequence(decalpos, count,
+			[&](int i) { return outputs[i]->decaljobs[k].Size(); },
+			[&](int i, unsigned n) { return outputs[i]->decaljobs[k][n]; },
+			[&](int i, unsigned n) { return false; },
+			[&](int i, unsigned n) { Decals[k].Push(outputs[i]->decals[k][n]); });
+	}
 
+	for (int i = 0; i < count; i++)
+	{
+		rendered_lines += outputs[i]->lines;
+		rendered_flats += outputs[i]->flats;
+		iter_dlight += outputs[i]->iter_dlight;
+		draw_dlight += outputs[i]->draw_dlight;
+		iter_dlightf += outputs[i]->iter_dlightf;
+		draw_dlightf += outputs[i]->draw_dlightf;
+		lastJobCounts[outputs[i] - SceneWorkerOutputs] = outputs[i]->jobs;
+		outputs[i]->Clear();
 	}
+	MergeTime.Unclock();
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void HWDrawInfo::ReplayDeferredOp(HWDeferredOp &op)
+{
+	switch (op.type)
+	{
+	case HWDeferredOp::PutPortal:
+		((HWWall *)op.ptr)->PutPortal(this, op.ptype, op.plane);
+		break;
+
+	case HWDeferredOp::SubsectorToPortal:
+		AddSubsectorToPortal((FSectorPortalGroup *)op.ptr, op.sub);
+		break;
+
+	case HWDeferredOp::UpperMissingTexture:
+		AddUpperMissingTexture((side_t *)op.ptr, op.sub, op.height);
+		break;
+
+	case HWDeferredOp::LowerMissingTexture:
+		AddLowerMissingTexture((side_t *)op.ptr, op.sub, op.height);
+		break;
+	}
+}
 
 
 
@@ -670,7 +879,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 	{
 		if (multithread)
 		{
-			jobQueue.AddJob(RenderJob::ParticleJob, sub, nullptr);
+			spriteQueue.AddJob(RenderJob::ParticleJob, sub, nullptr);
 		}
 		else
 		{
@@ -696,7 +905,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 		{
 			if (multithread)
 			{
-				jobQueue.AddJob(RenderJob::SpriteJob, sub, nullptr);
+				spriteQueue.AddJob(RenderJob::SpriteJob, sub, nullptr);
 			}
 			else
 			{
@@ -762,7 +971,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 				{
 					if (multithread)
 					{
-						jobQueue.AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
+						spriteQueue.AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
 					}
 					else
 					{
@@ -775,7 +984,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 				{
 					if (multithread)
 					{
-						jobQueue.AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
+						spriteQueue.AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
 					}
 					else
 					{
@@ -833,6 +1042,7 @@ void HWDrawInfo::RenderBSPNode (void *node)
 
 void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 {
+	TRACE_ZONE("HWDrawInfo::RenderBSP");
 	Bsp.Clock();
 
 	// Give the DrawInfo the viewpoint in fixed point because that's what the nodes are.
@@ -844,17 +1054,29 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	multithread = gl_multithread;
 	if (multithread)
 	{
+		int numworkers = GetSceneWorkerCount();
+		if (renderPool.size() != numworkers) renderPool.resize(numworkers);
+		lastWorkerCount = numworkers;
+
 		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
-			WorkerThread();
-		});
+		spriteQueue.ReleaseAll();
+		jobSequence = 0;
+		jobsDone = false;
+		std::future<void> futures[MAX_SCENE_WORKERS];
+		for (int i = 0; i < numworkers; i++)
+		{
+			futures[i] = renderPool.push([this, i](int id) {
+				WorkerThread(i);
+			});
+		}
 		RenderBSPNode(node);
 
-		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		jobsDone = true;
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		for (int i = 0; i < numworkers; i++) futures[i].wait();
 		MTWait.Unclock();
+		MergeWorkerOutputs(numworkers);
 	}
 	else
 	{
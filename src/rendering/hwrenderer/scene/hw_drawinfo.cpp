@@ -412,6 +412,14 @@ HWPortal * HWDrawInfo::FindPortal(const void * src)
 
 HWDecal *HWDrawInfo::AddDecal(bool onmirror)
 {
+	if (CurrentWorkerOutput != nullptr)
+	{
+		auto out = CurrentWorkerOutput;
+		auto decal = (HWDecal*)out->allocator.Alloc(sizeof(HWDecal));
+		out->decals[onmirror ? 1 : 0].Push(decal);
+		out->decaljobs[onmirror ? 1 : 0].Push(out->job);
+		return decal;
+	}
 	auto decal = (HWDecal*)RenderDataAllocator.Alloc(sizeof(HWDecal));
 	Decals[onmirror ? 1 : 0].Push(decal);
 	return decal;
@@ -732,6 +740,12 @@ void HWDrawInfo::ProcessScene(bool toscreen)
 
 void HWDrawInfo::AddSubsectorToPortal(FSectorPortalGroup *ptg, subsector_t *sub)
 {
+	if (auto op = DeferOp(HWDeferredOp::SubsectorToPortal))
+	{
+		op->ptr = ptg;
+		op->sub = sub;
+		return;
+	}
 	auto portal = FindPortal(ptg);
 	if (!portal)
 	{
@@ -94,6 +94,74 @@ enum DrawListType
 	GLDL_TYPES,
 };
 
+//==========================================================================
+//
+// Scene worker output
+//
+// With multithreaded BSP processing each worker collects its draw items
+// here instead of writing to the HWDrawInfo. Every item is tagged with
+// the sequence number of the job that created it so that the main thread
+// can merge everything back in the order the BSP traversal queued it,
+// no matter which worker ended up processing which job.
+//
+// Operations that modify shared state (portals and the render hacks) are
+// recorded and replayed by the main thread while merging, right after the
+// items that came before them.
+//
+//==========================================================================
+
+struct HWDeferredOp
+{
+	enum
+	{
+		PutPortal,
+		SubsectorToPortal,
+		UpperMissingTexture,
+		LowerMissingTexture,
+	};
+
+	int type;
+	uint32_t job;
+	void *ptr;			// the wall copy, portal group or side, depending on type.
+	subsector_t *sub;
+	float height;
+	int ptype, plane;
+	unsigned items[GLDL_TYPES];	// the worker's item counts when this was recorded.
+};
+
+enum
+{
+	MAX_SCENE_WORKERS = 8,
+	SPRITE_WORKER_OUTPUT = MAX_SCENE_WORKERS,	// sprites, particles and sector portals all get processed by the first worker.
+};
+
+struct HWWorkerOutput
+{
+	HWDrawList drawlists[GLDL_TYPES];
+	TArray<uint32_t> itemjobs[GLDL_TYPES];
+	TArray<HWDecal *> decals[2];
+	TArray<uint32_t> decaljobs[2];
+	TArray<HWDeferredOp> deferred;
+	FMemArena allocator{ 1024 * 1024 };
+	uint32_t job = 0;
+	int jobs = 0;
+	int lines = 0;
+	int flats = 0;
+	int iter_dlight = 0, draw_dlight = 0;	// the hw_clock.h counters for this worker
+	int iter_dlightf = 0, draw_dlightf = 0;
+
+	HWDrawList &NewItem(int list)
+	{
+		itemjobs[list].Push(job);
+		return drawlists[list];
+	}
+
+	void Clear();
+};
+
+extern HWWorkerOutput SceneWorkerOutputs[MAX_SCENE_WORKERS + 1];
+extern thread_local HWWorkerOutput *CurrentWorkerOutput;	// only set on scene worker threads.
+
 
 struct HWDrawInfo
 {
@@ -188,7 +256,9 @@ private:
 	subsector_t *currentsubsector;	// used by the line processing code.
 	sector_t *currentsector;
 
-	void WorkerThread();
+	void WorkerThread(int worker);
+	void MergeWorkerOutputs(int numworkers);
+	void ReplayDeferredOp(HWDeferredOp &op);
 
 	void UnclipSubsector(subsector_t *sub);
 	
@@ -312,6 +382,21 @@ public:
 
     HWDecal *AddDecal(bool onmirror);
 
+	HWDrawList &OutputList(int list)
+	{
+		return CurrentWorkerOutput ? CurrentWorkerOutput->NewItem(list) : drawlists[list];
+	}
+
+	// Returns nullptr on the main thread, which means the operation should be done right away.
+	HWDeferredOp *DeferOp(int type)
+	{
+		if (CurrentWorkerOutput == nullptr) return nullptr;
+		auto &op = CurrentWorkerOutput->deferred[CurrentWorkerOutput->deferred.Reserve(1)];
+		op = { type, CurrentWorkerOutput->job, nullptr, nullptr, 0.f, 0, 0 };
+		for (int i = 0; i < GLDL_TYPES; i++) op.items[i] = CurrentWorkerOutput->itemjobs[i].Size();
+		return &op;
+	}
+
 	bool isSoftwareLighting() const
 	{
 		return lightmode == ELightMode::ZDoomSoftware || lightmode == ELightMode::DoomSoftware || lightmode == ELightMode::Build;
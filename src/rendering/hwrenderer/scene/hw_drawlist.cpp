@@ -39,10 +39,43 @@
 #include "hw_fakeflat.h"
 
 FMemArena RenderDataAllocator(1024*1024);	// Use large blocks to reduce allocation time.
+HWWorkerOutput SceneWorkerOutputs[MAX_SCENE_WORKERS + 1];
+thread_local HWWorkerOutput *CurrentWorkerOutput;
 
 void ResetRenderDataAllocator()
 {
 	RenderDataAllocator.FreeAll();
+	// The merged draw lists point into the workers' arenas so these can only be released once the frame is done.
+	for (auto &out : SceneWorkerOutputs) out.allocator.FreeAll();
+}
+
+// Scene workers must not touch the global allocator.
+static inline FMemArena &CurrentRenderDataAllocator()
+{
+	return CurrentWorkerOutput ? CurrentWorkerOutput->allocator : RenderDataAllocator;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void HWWorkerOutput::Clear()
+{
+	for (int i = 0; i < GLDL_TYPES; i++)
+	{
+		drawlists[i].Reset();
+		itemjobs[i].Clear();
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		decals[i].Clear();
+		decaljobs[i].Clear();
+	}
+	deferred.Clear();
+	jobs = lines = flats = 0;
+	iter_dlight = draw_dlight = iter_dlightf = draw_dlightf = 0;
 }
 
 //==========================================================================
@@ -758,7 +791,7 @@ void HWDrawList::SortFlats()
 
 HWWall *HWDrawList::NewWall()
 {
-	auto wall = (HWWall*)RenderDataAllocator.Alloc(sizeof(HWWall));
+	auto wall = (HWWall*)CurrentRenderDataAllocator().Alloc(sizeof(HWWall));
 	drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(wall)));
 	return wall;
 }
@@ -770,7 +803,7 @@ HWWall *HWDrawList::NewWall()
 //==========================================================================
 HWFlat *HWDrawList::NewFlat()
 {
-	auto flat = (HWFlat*)RenderDataAllocator.Alloc(sizeof(HWFlat));
+	auto flat = (HWFlat*)CurrentRenderDataAllocator().Alloc(sizeof(HWFlat));
 	drawitems.Push(HWDrawItem(DrawType_FLAT,flats.Push(flat)));
 	return flat;
 }
@@ -782,11 +815,35 @@ HWFlat *HWDrawList::NewFlat()
 //==========================================================================
 HWSprite *HWDrawList::NewSprite()
 {	
-	auto sprite = (HWSprite*)RenderDataAllocator.Alloc(sizeof(HWSprite));
+	auto sprite = (HWSprite*)CurrentRenderDataAllocator().Alloc(sizeof(HWSprite));
 	drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(sprite)));
 	return sprite;
 }
 
+//==========================================================================
+//
+// Moves one item from a worker's list to the end of this one.
+// The item's data is still owned by the worker's arena.
+//
+//==========================================================================
+
+void HWDrawList::AppendItem(HWDrawList &src, unsigned i)
+{
+	auto &item = src.drawitems[i];
+	switch (item.rendertype)
+	{
+	case DrawType_WALL:
+		drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(src.walls[item.index])));
+		break;
+	case DrawType_FLAT:
+		drawitems.Push(HWDrawItem(DrawType_FLAT, flats.Push(src.flats[item.index])));
+		break;
+	case DrawType_SPRITE:
+		drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(src.sprites[item.index])));
+		break;
+	}
+}
+
 //==========================================================================
 //
 //
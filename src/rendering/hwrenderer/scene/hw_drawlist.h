@@ -91,6 +91,7 @@ public:
 	HWWall *NewWall();
 	HWFlat *NewFlat();
 	HWSprite *NewSprite();
+	void AppendItem(HWDrawList &src, unsigned i);
 	void Reset();
 	void SortWalls();
 	void SortFlats();
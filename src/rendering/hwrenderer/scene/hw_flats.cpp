@@ -157,6 +157,11 @@ void HWFlat::SetupLights(HWDrawInfo *di, FLightNode * node, FDynLightData &light
 		dynlightindex = -1;
 		return;	// no lights on additively blended surfaces.
 	}
+
+	// Scene workers count into their own output, it gets added to the totals when merging.
+	int &iterlights = CurrentWorkerOutput ? CurrentWorkerOutput->iter_dlightf : iter_dlightf;
+	int &drawlights = CurrentWorkerOutput ? CurrentWorkerOutput->draw_dlightf : draw_dlightf;
+
 	while (node)
 	{
 		FDynamicLight * light = node->lightsource;
@@ -166,7 +171,7 @@ void HWFlat::SetupLights(HWDrawInfo *di, FLightNode * node, FDynLightData &light
 			node = node->nextLight;
 			continue;
 		}
-		iter_dlightf++;
+		iterlights++;
 
 		// we must do the side check here because gl_GetLight needs the correct plane orientation
 		// which we don't have for Legacy-style 3D-floors
@@ -178,7 +183,7 @@ void HWFlat::SetupLights(HWDrawInfo *di, FLightNode * node, FDynLightData &light
 		}
 
 		p.Set(plane.plane.Normal(), plane.plane.fD());
-		draw_dlightf += GetLight(lightdata, portalgroup, p, light, false);
+		drawlights += GetLight(lightdata, portalgroup, p, light, false);
 		node = node->nextLight;
 	}
 
@@ -440,7 +445,8 @@ void HWFlat::Process(HWDrawInfo *di, sector_t * model, int whichplane, bool fog)
 
 	// For hacks this won't go into a render list.
 	PutFlat(di, fog);
-	rendered_flats++;
+	if (CurrentWorkerOutput) CurrentWorkerOutput->flats++;
+	else rendered_flats++;
 }
 
 //==========================================================================
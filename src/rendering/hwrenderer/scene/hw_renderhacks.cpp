@@ -194,6 +194,13 @@ void HWDrawInfo::AddOtherCeilingPlane(int sector, gl_subsectorrendernode * node)
 //==========================================================================
 void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
+	if (auto op = DeferOp(HWDeferredOp::UpperMissingTexture))
+	{
+		op->ptr = side;
+		op->sub = sub;
+		op->height = Backheight;
+		return;
+	}
 	if (!side->segs[0]->backsector) return;
 
 	for (int i = 0; i < side->numsegs; i++)
@@ -246,6 +253,13 @@ void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float B
 //==========================================================================
 void HWDrawInfo::AddLowerMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
+	if (auto op = DeferOp(HWDeferredOp::LowerMissingTexture))
+	{
+		op->ptr = side;
+		op->sub = sub;
+		op->height = Backheight;
+		return;
+	}
 	sector_t *backsec = side->segs[0]->backsector;
 	if (!backsec) return;
 	if (backsec->transdoor)
@@ -401,6 +401,10 @@ void HWWall::SetupLights(HWDrawInfo *di, FDynLightData &lightdata)
 	auto normal = glseg.Normal();
 	p.Set(normal, -normal.X * glseg.x1 - normal.Z * glseg.y1);
 
+	// Scene workers count into their own output, it gets added to the totals when merging.
+	int &iterlights = CurrentWorkerOutput ? CurrentWorkerOutput->iter_dlight : iter_dlight;
+	int &drawlights = CurrentWorkerOutput ? CurrentWorkerOutput->draw_dlight : draw_dlight;
+
 	FLightNode *node;
 	if (seg->sidedef == NULL)
 	{
@@ -422,7 +426,7 @@ void HWWall::SetupLights(HWDrawInfo *di, FDynLightData &lightdata)
 	{
 		if (node->lightsource->IsActive())
 		{
-			iter_dlight++;
+			iterlights++;
 
 			DVector3 posrel = node->lightsource->PosRelative(seg->frontsector->PortalGroup);
 			float x = posrel.X;
@@ -465,7 +469,7 @@ void HWWall::SetupLights(HWDrawInfo *di, FDynLightData &lightdata)
 				}
 				if (outcnt[0]!=4 && outcnt[1]!=4 && outcnt[2]!=4 && outcnt[3]!=4) 
 				{
-					draw_dlight += GetLight(lightdata, seg->frontsector->PortalGroup, p, node->lightsource, true);
+					drawlights += GetLight(lightdata, seg->frontsector->PortalGroup, p, node->lightsource, true);
 				}
 			}
 		}
@@ -567,6 +571,17 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 {
 	HWPortal * portal = nullptr;
 
+	if (auto op = di->DeferOp(HWDeferredOp::PutPortal))
+	{
+		auto copy = (HWWall*)CurrentWorkerOutput->allocator.Alloc(sizeof(HWWall));
+		*copy = *this;
+		op->ptr = copy;
+		op->ptype = ptype;
+		op->plane = plane;
+		vertcount = 0;
+		return;
+	}
+
 	MakeVertices(di, false);
 	switch (ptype)
 	{
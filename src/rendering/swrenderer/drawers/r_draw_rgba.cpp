@@ -1044,6 +1044,44 @@ namespace swrenderer
 		drawerargs.SetTextureUPos(texturefracx);
 		drawerargs.SetTextureVPos(texelY);
 		drawerargs.SetTextureVStep(texelStepY);
-		DrawerT::DrawColumn(drawerargs);
+
+		if (drawerargs.dc_num_lights == 0)
+		{
+			DrawerT::DrawColumn(drawerargs);
+			return;
+		}
+
+		// Split the column so that each part only evaluates the lights that can reach it
+		int numlights = drawerargs.dc_num_lights;
+		DrawerLight lights[WallColumnDrawerArgs::MAX_DRAWER_LIGHTS];
+		float center[WallColumnDrawerArgs::MAX_DRAWER_LIGHTS];
+		float extent2[WallColumnDrawerArgs::MAX_DRAWER_LIGHTS];
+		for (int i = 0; i < numlights; i++)
+		{
+			lights[i] = drawerargs.dc_lights[i];
+			float radius = 256.0f / lights[i].radius;
+			center[i] = lights[i].z;
+			extent2[i] = radius * radius - lights[i].x;
+		}
+
+		float viewposZ = drawerargs.dc_viewpos.Z;
+		float stepZ = drawerargs.dc_viewpos_step.Z;
+		lightculler.Cull(lights, numlights, center, extent2, viewposZ, stepZ, count);
+
+		for (int i = 0, n = lightculler.NumSegments(); i < n; i++)
+		{
+			auto seg = lightculler.GetSegment(i);
+			drawerargs.SetDest(x, y1 + seg.start);
+			drawerargs.SetCount(seg.count);
+			drawerargs.SetTextureVPos(texelY + texelStepY * (uint32_t)seg.start);
+			drawerargs.dc_viewpos.Z = viewposZ + stepZ * seg.start;
+			memcpy(drawerargs.dc_lights, seg.lights, seg.numlights * sizeof(DrawerLight));
+			drawerargs.dc_num_lights = seg.numlights;
+			DrawerT::DrawColumn(drawerargs);
+		}
+
+		drawerargs.dc_viewpos.Z = viewposZ;
+		memcpy(drawerargs.dc_lights, lights, numlights * sizeof(DrawerLight));
+		drawerargs.dc_num_lights = numlights;
 	}
 }
@@ -140,6 +140,7 @@ namespace swrenderer
 		template<typename DrawerT> void DrawWallColumn32(WallColumnDrawerArgs& drawerargs, int x, int y1, int y2, uint32_t texelX, uint32_t texelY, uint32_t texelStepX, uint32_t texelStepY);
 
 		WallColumnDrawerArgs wallcolargs;
+		DrawerLightCuller lightculler;
 	};
 
 	/////////////////////////////////////////////////////////////////////////////
@@ -269,11 +269,59 @@ namespace swrenderer
 		drawerargs.SetDestX1(x1);
 		drawerargs.SetDestX2(x2);
 
-		drawerargs.DrawSpan(Thread);
+		if (drawerargs.dc_num_lights > 0 && viewport->RenderTarget->IsBgra())
+			DrawLitSpan(x1, x2);
+		else
+			drawerargs.DrawSpan(Thread);
+
 		if (r_modelscene)
 			drawerargs.DrawDepthSpan(Thread, zbufferdepth, zbufferdepth);
 	}
 
+	// Splits the span so that each part only evaluates the lights that can reach it
+	void RenderFlatPlane::DrawLitSpan(int x1, int x2)
+	{
+		DrawerLight *lights = drawerargs.dc_lights;
+		int numlights = drawerargs.dc_num_lights;
+		lightcenter.Resize(numlights);
+		lightextent2.Resize(numlights);
+		float *center = lightcenter.Data();
+		float *extent2 = lightextent2.Data();
+		for (int i = 0; i < numlights; i++)
+		{
+			float radius = 256.0f / lights[i].radius;
+			center[i] = lights[i].x;
+			extent2[i] = radius * radius - lights[i].y;
+		}
+
+		float viewposX = drawerargs.dc_viewpos.X;
+		float stepX = drawerargs.dc_viewpos_step.X;
+		uint32_t xfrac = drawerargs.TextureUPos();
+		uint32_t yfrac = drawerargs.TextureVPos();
+		uint32_t xstep = drawerargs.TextureUStep();
+		uint32_t ystep = drawerargs.TextureVStep();
+		lightculler.Cull(lights, numlights, center, extent2, viewposX, stepX, x2 - x1 + 1);
+
+		for (int i = 0, n = lightculler.NumSegments(); i < n; i++)
+		{
+			auto seg = lightculler.GetSegment(i);
+			drawerargs.SetDestX1(x1 + seg.start);
+			drawerargs.SetDestX2(x1 + seg.start + seg.count - 1);
+			drawerargs.SetTextureFrac(xfrac + xstep * (uint32_t)seg.start, yfrac + ystep * (uint32_t)seg.start);
+			drawerargs.dc_viewpos.X = viewposX + stepX * seg.start;
+			drawerargs.dc_lights = seg.lights;
+			drawerargs.dc_num_lights = seg.numlights;
+			drawerargs.DrawSpan(Thread);
+		}
+
+		drawerargs.SetDestX1(x1);
+		drawerargs.SetDestX2(x2);
+		drawerargs.SetTextureFrac(xfrac, yfrac);
+		drawerargs.dc_viewpos.X = viewposX;
+		drawerargs.dc_lights = lights;
+		drawerargs.dc_num_lights = numlights;
+	}
+
 	/////////////////////////////////////////////////////////////////////////
 	
 	RenderColoredPlane::RenderColoredPlane(RenderThread *thread)
@@ -40,6 +40,7 @@ namespace swrenderer
 
 	private:
 		void RenderLine(int y, int x1, int x2) override;
+		void DrawLitSpan(int x1, int x2);
 
 		int minx;
 		double planeheight;
@@ -53,6 +54,8 @@ namespace swrenderer
 		FSoftwareTexture *tex;
 
 		SpanDrawerArgs drawerargs;
+		DrawerLightCuller lightculler;
+		TArray<float> lightcenter, lightextent2;	// reused by every lit span
 	};
 
 	class RenderColoredPlane : PlaneRenderer
@@ -50,6 +50,7 @@ namespace swrenderer
 		void Render(RenderThread *thread, fixed_t alpha, bool additive, bool masked);
 
 		VisiblePlane *next = nullptr;		// Next visplane in hash chain -- killough
+		unsigned fingerprint = 0;			// Hash of everything FindPlane compares
 
 		FDynamicColormap *colormap = nullptr;		// [RH] Support multiple colormaps
 		FSectorPortal *portal = nullptr;			// [RH] Support sky boxes
@@ -57,33 +57,91 @@ namespace swrenderer
 	VisiblePlaneList::VisiblePlaneList(RenderThread *thread)
 	{
 		Thread = thread;
+		visplanes.Resize(MINVISPLANES);
+		Clear();
 	}
 
 	VisiblePlaneList::VisiblePlaneList()
 	{
-		for (auto &plane : visplanes)
-			plane = nullptr;
 	}
 
-	VisiblePlane *VisiblePlaneList::Add(unsigned hash)
+	VisiblePlane *VisiblePlaneList::Add(unsigned fingerprint)
 	{
+		if (++numplanes > (int)visplanes.Size() * 2 && visplanes.Size() < MAXVISPLANES)
+			Grow();
+		peakplanes = max(peakplanes, numplanes);
+		Stats.Planes++;
+
+		VisiblePlane *newplane = Thread->FrameMemory->NewObject<VisiblePlane>(Thread);
+		VisiblePlane *&bucket = visplanes[fingerprint & (visplanes.Size() - 1)];
+		newplane->fingerprint = fingerprint;
+		newplane->next = bucket;
+		bucket = newplane;
+		return newplane;
+	}
+
+	VisiblePlane *VisiblePlaneList::AddPortalPlane()
+	{
+		Stats.Planes++;
+
 		VisiblePlane *newplane = Thread->FrameMemory->NewObject<VisiblePlane>(Thread);
-		newplane->next = visplanes[hash];
-		visplanes[hash] = newplane;
+		newplane->next = portalplanes;
+		portalplanes = newplane;
 		return newplane;
 	}
 
+	void VisiblePlaneList::Grow()
+	{
+		TArray<VisiblePlane *> oldplanes = std::move(visplanes);
+		visplanes.Resize(oldplanes.Size() * 2);
+		for (auto &bucket : visplanes)
+			bucket = nullptr;
+		Stats.Buckets = visplanes.Size();
+
+		// Append at the end of the new chains so that planes with the same key
+		// keep their order and FindPlane still returns the newest of them.
+		TArray<VisiblePlane **> tails(visplanes.Size(), true);
+		for (unsigned i = 0; i < visplanes.Size(); i++)
+			tails[i] = &visplanes[i];
+
+		for (VisiblePlane *chain : oldplanes)
+		{
+			while (chain != nullptr)
+			{
+				VisiblePlane *next = chain->next;
+				unsigned i = chain->fingerprint & (visplanes.Size() - 1);
+				chain->next = nullptr;
+				*tails[i] = chain;
+				tails[i] = &chain->next;
+				chain = next;
+			}
+		}
+	}
+
 	void VisiblePlaneList::Clear()
 	{
-		for (int i = 0; i <= MAXVISPLANES; i++)
-			visplanes[i] = nullptr;
+		// Size the table for what the last frame needed
+		unsigned size = visplanes.Size();
+		while (size > MINVISPLANES && peakplanes < (int)size / 2)
+			size /= 2;
+		if (size != visplanes.Size())
+			visplanes.Resize(size);
+
+		for (auto &bucket : visplanes)
+			bucket = nullptr;
+		portalplanes = nullptr;
+		numplanes = 0;
+		peakplanes = 0;
+
+		Stats = {};
+		Stats.Buckets = visplanes.Size();
 	}
 
 	void VisiblePlaneList::ClearKeepFakePlanes()
 	{
-		for (int i = 0; i <= MAXVISPLANES - 1; i++)
+		for (auto &bucket : visplanes)
 		{
-			for (VisiblePlane **probe = &visplanes[i]; *probe != nullptr; )
+			for (VisiblePlane **probe = &bucket; *probe != nullptr; )
 			{
 				if ((*probe)->sky < 0)
 				{ // fake: move past it
@@ -94,16 +152,59 @@ namespace swrenderer
 					VisiblePlane *vis = *probe;
 					*probe = vis->next;
 					vis->next = nullptr;
+					numplanes--;
 				}
 			}
 		}
 	}
 
+	unsigned VisiblePlaneList::CalcFingerprint(const secplane_t &height, FTextureID picnum, int lightlevel, FDynamicColormap *colormap, const FTransform &xform, int sky, int portaluniq, int mirrorflags, int skybox)
+	{
+		uint32_t hash = 2166136261u;
+		auto mix = [&](uint64_t v)
+		{
+			hash = (hash ^ (uint32_t)(v ^ (v >> 32))) * 16777619u;
+		};
+		auto mixd = [&](double d)
+		{
+			// Adding 0 turns -0 into +0, which compare equal.
+			d += 0.0;
+			uint64_t v;
+			memcpy(&v, &d, sizeof(v));
+			mix(v);
+		};
+
+		// Only what the == operators of the key types look at may go in here.
+		// The view position is left out because the planes store the stacked
+		// one, which FindPlane compares against the current position.
+		mixd(height.normal.X);
+		mixd(height.normal.Y);
+		mixd(height.normal.Z);
+		mixd(height.D);
+		mix(picnum.GetIndex());
+		mix(lightlevel);
+		mix((uintptr_t)colormap);
+		mixd(xform.xOffs);
+		mixd(xform.yOffs + xform.baseyOffs);
+		mixd(xform.xScale);
+		mixd(xform.yScale);
+		mixd((xform.Angle + xform.baseAngle).Degrees);
+		mix((uint32_t)sky);
+		mix(portaluniq);
+		mix(mirrorflags);
+		mix(skybox);
+
+		// The table index uses the low bits, so spread the high ones down.
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6b;
+		hash ^= hash >> 13;
+		return hash;
+	}
+
 	VisiblePlane *VisiblePlaneList::FindPlane(const secplane_t &height, FTextureID picnum, int lightlevel, bool foggy, double Alpha, bool additive, const FTransform &xxform, int sky, FSectorPortal *portal, FDynamicColormap *basecolormap, Fake3DOpaque::Type fakeFloorType, fixed_t fakeAlpha)
 	{
 		secplane_t plane;
 		VisiblePlane *check;
-		unsigned hash;						// killough
 		bool isskybox;
 		const FTransform *xform = &xxform;
 		fixed_t alpha = FLOAT2FIXED(Alpha);
@@ -148,12 +249,9 @@ namespace swrenderer
 			alpha = OPAQUE;
 		}
 
-		// New visplane algorithm uses hash table -- killough
-		hash = isskybox ? ((unsigned)MAXVISPLANES) : CalcHash(picnum.GetIndex(), lightlevel, height);
-		
-		for (check = visplanes[hash]; check; check = check->next)	// killough
+		if (isskybox)
 		{
-			if (isskybox)
+			for (check = portalplanes; check; check = check->next)
 			{
 				if (portal == check->portal && plane == check->height)
 				{
@@ -191,8 +289,20 @@ namespace swrenderer
 					}
 				}
 			}
-			else
-				if (plane == check->height &&
+			check = AddPortalPlane();
+		}
+		else
+		{
+			// New visplane algorithm uses hash table -- killough
+			unsigned fingerprint = CalcFingerprint(plane, picnum, lightlevel, basecolormap, *xform, sky,
+				renderportal->CurrentPortalUniq, renderportal->MirrorFlags, Thread->Clip3D->CurrentSkybox);
+
+			int probes = 0;
+			for (check = visplanes[fingerprint & (visplanes.Size() - 1)]; check; check = check->next)	// killough
+			{
+				probes++;
+				if (fingerprint == check->fingerprint &&
+					plane == check->height &&
 					picnum == check->picnum &&
 					lightlevel == check->lightlevel &&
 					basecolormap == check->colormap &&	// [RH] Add more checks
@@ -204,11 +314,18 @@ namespace swrenderer
 					Thread->Viewport->viewpoint.Pos == check->viewpos
 					)
 				{
-					return check;
+					break;
 				}
-		}
+			}
+
+			Stats.Lookups++;
+			Stats.Probes += probes;
+			Stats.MaxProbes = max(Stats.MaxProbes, probes);
+			if (check != nullptr)
+				return check;
 
-		check = Add(hash);		// killough
+			check = Add(fingerprint);		// killough
+		}
 
 		check->height = plane;
 		check->picnum = picnum;
@@ -273,17 +390,16 @@ namespace swrenderer
 		else
 		{
 			// make a new visplane
-			unsigned hash;
+			VisiblePlane *new_pl;
 
 			if (pl->portal != nullptr && !Thread->Portal->InSkyBox(pl->portal) && viewactive)
 			{
-				hash = MAXVISPLANES;
+				new_pl = AddPortalPlane();
 			}
 			else
 			{
-				hash = CalcHash(pl->picnum.GetIndex(), pl->lightlevel, pl->height);
+				new_pl = Add(pl->fingerprint);
 			}
-			VisiblePlane *new_pl = Add(hash);
 
 			new_pl->height = pl->height;
 			new_pl->picnum = pl->picnum;
@@ -311,15 +427,15 @@ namespace swrenderer
 
 	bool VisiblePlaneList::HasPortalPlanes() const
 	{
-		return visplanes[MAXVISPLANES] != nullptr;
+		return portalplanes != nullptr;
 	}
 
 	VisiblePlane *VisiblePlaneList::PopFirstPortalPlane()
 	{
-		VisiblePlane *pl = visplanes[VisiblePlaneList::MAXVISPLANES];
+		VisiblePlane *pl = portalplanes;
 		if (pl)
 		{
-			visplanes[VisiblePlaneList::MAXVISPLANES] = pl->next;
+			portalplanes = pl->next;
 			pl->next = nullptr;
 		}
 		return pl;
@@ -327,7 +443,7 @@ namespace swrenderer
 
 	void VisiblePlaneList::ClearPortalPlanes()
 	{
-		visplanes[VisiblePlaneList::MAXVISPLANES] = nullptr;
+		portalplanes = nullptr;
 	}
 
 	int VisiblePlaneList::Render()
@@ -336,14 +452,13 @@ namespace swrenderer
 			PlaneCycles.Clock();
 
 		VisiblePlane *pl;
-		int i;
 		int vpcount = 0;
 
 		RenderPortal *renderportal = Thread->Portal.get();
 
-		for (i = 0; i < MAXVISPLANES; i++)
+		for (auto bucket : visplanes)
 		{
-			for (pl = visplanes[i]; pl; pl = pl->next)
+			for (pl = bucket; pl; pl = pl->next)
 			{
 				// kg3D - draw only correct planes
 				if (pl->CurrentPortalUniq != renderportal->CurrentPortalUniq || pl->CurrentSkybox != Thread->Clip3D->CurrentSkybox)
@@ -365,16 +480,15 @@ namespace swrenderer
 	void VisiblePlaneList::RenderHeight(double height)
 	{
 		VisiblePlane *pl;
-		int i;
 
 		DVector3 oViewPos = Thread->Viewport->viewpoint.Pos;
 		DAngle oViewAngle = Thread->Viewport->viewpoint.Angles.Yaw;
 		
 		RenderPortal *renderportal = Thread->Portal.get();
 
-		for (i = 0; i < MAXVISPLANES; i++)
+		for (auto bucket : visplanes)
 		{
-			for (pl = visplanes[i]; pl; pl = pl->next)
+			for (pl = bucket; pl; pl = pl->next)
 			{
 				if (pl->CurrentSkybox != Thread->Clip3D->CurrentSkybox || pl->CurrentPortalUniq != renderportal->CurrentPortalUniq)
 					continue;
@@ -32,6 +32,15 @@ namespace swrenderer
 	class RenderThread;
 	struct VisiblePlane;
 
+	struct VisiblePlaneStats
+	{
+		int Planes = 0;			// Planes created
+		int Lookups = 0;		// FindPlane calls outside of portals
+		int Probes = 0;			// Planes looked at by those calls
+		int MaxProbes = 0;		// Longest search
+		int Buckets = 0;		// Hash table size
+	};
+
 	class VisiblePlaneList
 	{
 	public:
@@ -52,13 +61,27 @@ namespace swrenderer
 
 		RenderThread *Thread = nullptr;
 
+		// Counts for the current frame, reset by Clear
+		VisiblePlaneStats Stats;
+
 	private:
 		VisiblePlaneList();
-		VisiblePlane *Add(unsigned hash);
+		VisiblePlane *Add(unsigned fingerprint);
+		VisiblePlane *AddPortalPlane();
+		void Grow();
 
-		enum { MAXVISPLANES = 128 }; // must be a power of 2
-		VisiblePlane *visplanes[MAXVISPLANES + 1];
+		// The table starts at the size the previous frame ended with and doubles
+		// whenever the chains get longer than two planes on average.
+		enum
+		{
+			MINVISPLANES = 128,		// must be a power of 2
+			MAXVISPLANES = 1 << 16
+		};
+		TArray<VisiblePlane *> visplanes;
+		VisiblePlane *portalplanes = nullptr;
+		int numplanes = 0;
+		int peakplanes = 0;
 
-		static unsigned CalcHash(int picnum, int lightlevel, const secplane_t &height) { return (unsigned)((picnum) * 3 + (lightlevel)+(FLOAT2FIXED((height).fD())) * 7) & (MAXVISPLANES - 1); }
+		static unsigned CalcFingerprint(const secplane_t &height, FTextureID picnum, int lightlevel, FDynamicColormap *colormap, const FTransform &xform, int sky, int portaluniq, int mirrorflags, int skybox);
 	};
 }
@@ -93,7 +93,7 @@ void FSoftwareRenderer::PreparePrecache(FGameTexture *ttex, int cache)
 
 		if (tex->CheckPixels())
 		{
-			if (cache == 0) tex->Unload();
+			if (cache == 0) tex->Evict();
 		}
 		else if (cache != 0)
 		{
@@ -186,6 +186,7 @@ void FSoftwareRenderer::Precache(uint8_t *texhitlist, TMap<PClassActor*, bool> &
 
 void FSoftwareRenderer::RenderView(player_t *player, DCanvas *target, void *videobuffer, int bufferpitch)
 {
+	FSoftwareTexture::BeginFrame();
 	mScene.MainThread()->Viewport->viewpoint = r_viewpoint;
 	mScene.MainThread()->Viewport->viewwindow = r_viewwindow;
 	mScene.RenderView(player, target, videobuffer, bufferpitch);
@@ -57,6 +57,7 @@
 #include "r_memory.h"
 #include "swrenderer/r_renderthread.h"
 #include "swrenderer/things/r_playersprite.h"
+#include "tracezones.h"
 #include <chrono>
 
 #ifdef WIN32
@@ -74,6 +75,7 @@ bool r_modelscene = false;
 namespace swrenderer
 {
 	cycle_t WallCycles, PlaneCycles, MaskedCycles;
+	static std::vector<VisiblePlaneStats> PlaneStats;
 	
 	RenderScene::RenderScene()
 	{
@@ -194,6 +196,7 @@ namespace swrenderer
 
 	void RenderScene::RenderThreadSlices()
 	{
+		TRACE_ZONE("RenderScene::RenderThreadSlices");
 		int numThreads = std::thread::hardware_concurrency();
 		if (numThreads == 0)
 			numThreads = 1;
@@ -218,6 +221,8 @@ namespace swrenderer
 			Threads[i]->X1 = viewwidth * i / numThreads;
 			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
 		}
+		// No thread is drawing right now, so this is the only safe place to release texture data.
+		FSoftwareTexture::EvictTextures();
 		run_id++;
 		FSoftwareTexture::CurrentUpdate = run_id;
 		start_lock.unlock();
@@ -249,6 +254,10 @@ namespace swrenderer
 			finished_threads = 0;
 		}
 
+		PlaneStats.resize(Threads.size());
+		for (size_t i = 0; i < Threads.size(); i++)
+			PlaneStats[i] = Threads[i]->PlaneList->Stats;
+
 		// Change main thread back to covering the whole screen for player sprites
 		MainThread()->X1 = 0;
 		MainThread()->X2 = viewwidth;
@@ -256,6 +265,7 @@ namespace swrenderer
 
 	void RenderScene::RenderThreadSlice(RenderThread *thread)
 	{
+		TRACE_ZONE("RenderScene::RenderThreadSlice");
 		thread->FrameMemory->Clear();
 		thread->Clip3D->Cleanup();
 		thread->Clip3D->ResetClip(); // reset clips (floor/ceiling)
@@ -336,6 +346,7 @@ namespace swrenderer
 			int start_run_id = run_id;
 			thread->thread = std::thread([=]()
 			{
+				Trace_SetThreadName("Scene thread");
 				int last_run_id = start_run_id;
 				while (true)
 				{
@@ -455,6 +466,19 @@ namespace swrenderer
 		return out;
 	}
 
+	ADD_STAT(visplanes)
+	{
+		FString out;
+		for (size_t i = 0; i < PlaneStats.size(); i++)
+		{
+			const auto &stats = PlaneStats[i];
+			out.AppendFormat("%sthread %d: %d planes, %d buckets, %d lookups, %.2f avg probes, %d max probes",
+				i > 0 ? "\n" : "", (int)i, stats.Planes, stats.Buckets, stats.Lookups,
+				stats.Lookups > 0 ? stats.Probes / (double)stats.Lookups : 0., stats.MaxProbes);
+		}
+		return out;
+	}
+
 	static double bestwallcycles = HUGE_VAL;
 
 	ADD_STAT(wallcycles)
@@ -39,8 +39,18 @@
 #include "m_alloc.h"
 #include "imagehelpers.h"
 #include "texturemanager.h"
+#include "stats.h"
 #include <mutex>
 
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
+CUSTOM_CVAR(Int, r_swtexturecache, 1024, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// in MB, 0 means unlimited
+{
+	if (self < 0) self = 0;
+}
+
 inline EUpscaleFlags scaleFlagFromUseType(ETextureType useType)
 {
 	switch (useType)
@@ -192,6 +202,7 @@ const uint32_t *FSoftwareTexture::GetPixelsBgraLocked()
 //==========================================================================
 
 int FSoftwareTexture::CurrentUpdate = 0;
+int FSoftwareTexture::CurrentFrame = 0;
 namespace swrenderer { extern std::mutex loadmutex; }
 
 void FSoftwareTexture::UpdatePixels(int index)
@@ -199,11 +210,15 @@ void FSoftwareTexture::UpdatePixels(int index)
 	std::unique_lock<std::mutex> lock(swrenderer::loadmutex);
 	if (Unlockeddata[index].LastUpdate != CurrentUpdate)
 	{
+		bool resident = (index == 2 ? PixelsBgra.Size() : Pixels.Size()) > 0 && Spandata[index] != nullptr;
+		if (resident) CacheHits++;
+		else CacheMisses++;
+
 		if (index != 2)
 		{
 			const uint8_t* Pixeldata = GetPixelsLocked(index);
 			if (Spandata[index] == nullptr)
-				Spandata[index] = CreateSpans(Pixeldata);
+				Spandata[index] = CreateSpans(Pixeldata, SpanBytes[index]);
 			Unlockeddata[index].Pixels = Pixeldata;
 			Unlockeddata[index].LastUpdate = CurrentUpdate;
 		}
@@ -211,13 +226,114 @@ void FSoftwareTexture::UpdatePixels(int index)
 		{
 			const uint32_t* Pixeldata = GetPixelsBgraLocked();
 			if (Spandata[index] == nullptr)
-				Spandata[index] = CreateSpans(Pixeldata);
+				Spandata[index] = CreateSpans(Pixeldata, SpanBytes[index]);
 			Unlockeddata[index].Pixels = Pixeldata;
 			Unlockeddata[index].LastUpdate = CurrentUpdate;
 		}
+		Touch();
 	}
 }
 
+//==========================================================================
+//
+// Texture cache
+//
+// Every texture that has pixel data is kept in a list ordered by the last
+// time it was used. When the data of all textures exceeds the budget, the
+// ones at the end of the list get released before the next render pass
+// starts. A frame can have several passes, e.g. for camera textures, so
+// textures used anywhere in the current or the previous frame are never
+// released. This way a scene that needs more than the budget does not
+// thrash.
+//
+//==========================================================================
+
+FSoftwareTexture *FSoftwareTexture::CacheHead;
+FSoftwareTexture *FSoftwareTexture::CacheTail;
+size_t FSoftwareTexture::CacheBytes;
+unsigned FSoftwareTexture::CacheCount;
+unsigned FSoftwareTexture::CacheHits;
+unsigned FSoftwareTexture::CacheMisses;
+unsigned FSoftwareTexture::CacheEvictions;
+
+size_t FSoftwareTexture::GetResidentBytes() const
+{
+	return Pixels.Size() + PixelsBgra.Size() * sizeof(uint32_t) + SpanBytes[0] + SpanBytes[1] + SpanBytes[2];
+}
+
+void FSoftwareTexture::Touch()
+{
+	// Canvas textures own their render targets and cannot be recreated from the source image.
+	if (mTexture->isSoftwareCanvas()) return;
+
+	size_t bytes = GetResidentBytes();
+	CacheBytes = CacheBytes - CachedBytes + bytes;
+	CachedBytes = bytes;
+	LastUse = CurrentFrame;
+
+	if (CacheHead == this) return;
+	if (InCache)
+	{
+		CachePrev->CacheNext = CacheNext;
+		if (CacheNext) CacheNext->CachePrev = CachePrev;
+		else CacheTail = CachePrev;
+	}
+	else
+	{
+		InCache = true;
+		CacheCount++;
+	}
+	CachePrev = nullptr;
+	CacheNext = CacheHead;
+	if (CacheHead) CacheHead->CachePrev = this;
+	else CacheTail = this;
+	CacheHead = this;
+}
+
+void FSoftwareTexture::Uncache()
+{
+	if (!InCache) return;
+	if (CachePrev) CachePrev->CacheNext = CacheNext;
+	else CacheHead = CacheNext;
+	if (CacheNext) CacheNext->CachePrev = CachePrev;
+	else CacheTail = CachePrev;
+	CachePrev = CacheNext = nullptr;
+	CacheBytes -= CachedBytes;
+	CachedBytes = 0;
+	CacheCount--;
+	InCache = false;
+}
+
+void FSoftwareTexture::Evict()
+{
+	Unload();
+	FreeAllSpans();
+	Uncache();
+}
+
+void FSoftwareTexture::EvictTextures()
+{
+	std::unique_lock<std::mutex> lock(swrenderer::loadmutex);
+	size_t budget = size_t(*r_swtexturecache) << 20;
+	if (budget == 0) return;
+
+	while (CacheBytes > budget && CacheTail != nullptr && CacheTail->LastUse < CurrentFrame - 1)
+	{
+		CacheTail->Evict();
+		CacheEvictions++;
+	}
+}
+
+ADD_STAT(swtexcache)
+{
+	FString out;
+	unsigned lookups = FSoftwareTexture::CacheHits + FSoftwareTexture::CacheMisses;
+	out.Format("%u textures, %.1f MB resident, budget %d MB\n%u hits, %u misses (%.1f%% hit rate), %u evictions",
+		FSoftwareTexture::GetCacheCount(), FSoftwareTexture::GetCacheBytes() / 1048576., *r_swtexturecache,
+		FSoftwareTexture::CacheHits, FSoftwareTexture::CacheMisses, lookups ? FSoftwareTexture::CacheHits * 100. / lookups : 100., FSoftwareTexture::CacheEvictions);
+	return out;
+}
+
 //==========================================================================
 //
 // 
@@ -235,13 +351,14 @@ static bool isTranslucent(uint32_t val)
 }
 
 template<class T>
-FSoftwareTextureSpan **FSoftwareTexture::CreateSpans (const T *pixels)
+FSoftwareTextureSpan **FSoftwareTexture::CreateSpans (const T *pixels, size_t &bytes)
 {
 	FSoftwareTextureSpan **spans, *span;
 
 	if (!mTexture->isMasked())
 	{ // Texture does not have holes, so it can use a simpler span structure
-		spans = (FSoftwareTextureSpan **)M_Malloc (sizeof(FSoftwareTextureSpan*)*GetPhysicalWidth() + sizeof(FSoftwareTextureSpan)*2);
+		bytes = sizeof(FSoftwareTextureSpan*)*GetPhysicalWidth() + sizeof(FSoftwareTextureSpan)*2;
+		spans = (FSoftwareTextureSpan **)M_Malloc (bytes);
 		span = (FSoftwareTextureSpan *)&spans[GetPhysicalWidth()];
 		for (int x = 0; x < GetPhysicalWidth(); ++x)
 		{
@@ -286,7 +403,8 @@ FSoftwareTextureSpan **FSoftwareTexture::CreateSpans (const T *pixels)
 		}
 
 		// Allocate space for the spans
-		spans = (FSoftwareTextureSpan **)M_Malloc (sizeof(FSoftwareTextureSpan*)*numcols + sizeof(FSoftwareTextureSpan)*numspans);
+		bytes = sizeof(FSoftwareTextureSpan*)*numcols + sizeof(FSoftwareTextureSpan)*numspans;
+		spans = (FSoftwareTextureSpan **)M_Malloc (bytes);
 
 		// Fill in the spans
 		for (x = 0, span = (FSoftwareTextureSpan *)&spans[numcols], data_p = pixels; x < numcols; ++x)
@@ -384,42 +502,90 @@ int FSoftwareTexture::MipmapLevels()
 
 //==========================================================================
 //
-// 
+// Mipmap generation works on linear colors with 4 floats per pixel,
+// which map directly to one SSE register.
 //
 //==========================================================================
 
-void FSoftwareTexture::GenerateBgraMipmaps()
+namespace
 {
+#ifndef NO_SSE
+	struct Color4f
+	{
+		__m128 v;
+
+		Color4f() = default;
+		Color4f(__m128 v) : v(v) {}
+		Color4f operator+(const Color4f &o) const { return _mm_add_ps(v, o.v); }
+		Color4f operator-(const Color4f &o) const { return _mm_sub_ps(v, o.v); }
+		Color4f operator*(float s) const { return _mm_mul_ps(v, _mm_set1_ps(s)); }
+		void Store(float *out) const { _mm_storeu_ps(out, v); }
+		static Color4f Load(const float *in) { return _mm_loadu_ps(in); }
+		static Color4f Zero() { return _mm_setzero_ps(); }
+	};
+#else
 	struct Color4f
 	{
-		float a, r, g, b;
-		Color4f operator*(const Color4f &v) const { return Color4f{ a * v.a, r * v.r, g * v.g, b * v.b }; }
-		Color4f operator/(const Color4f &v) const { return Color4f{ a / v.a, r / v.r, g / v.g, b / v.b }; }
-		Color4f operator+(const Color4f &v) const { return Color4f{ a + v.a, r + v.r, g + v.g, b + v.b }; }
-		Color4f operator-(const Color4f &v) const { return Color4f{ a - v.a, r - v.r, g - v.g, b - v.b }; }
-		Color4f operator*(float s) const { return Color4f{ a * s, r * s, g * s, b * s }; }
-		Color4f operator/(float s) const { return Color4f{ a / s, r / s, g / s, b / s }; }
-		Color4f operator+(float s) const { return Color4f{ a + s, r + s, g + s, b + s }; }
-		Color4f operator-(float s) const { return Color4f{ a - s, r - s, g - s, b - s }; }
+		float c[4];
+
+		Color4f operator+(const Color4f &o) const { return Color4f{ { c[0] + o.c[0], c[1] + o.c[1], c[2] + o.c[2], c[3] + o.c[3] } }; }
+		Color4f operator-(const Color4f &o) const { return Color4f{ { c[0] - o.c[0], c[1] - o.c[1], c[2] - o.c[2], c[3] - o.c[3] } }; }
+		Color4f operator*(float s) const { return Color4f{ { c[0] * s, c[1] * s, c[2] * s, c[3] * s } }; }
+		void Store(float *out) const { memcpy(out, c, sizeof(c)); }
+		static Color4f Load(const float *in) { Color4f r; memcpy(r.c, in, sizeof(r.c)); return r; }
+		static Color4f Zero() { return Color4f{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	};
+#endif
+
+	// Conversion between 8 bit sRGB and linear values. The decoding table holds the exact values of the
+	// former per pixel powf calls. Encoding searches for the first value that would round up to the next
+	// step instead of calling powf for each channel.
+	struct SrgbTables
+	{
+		float ToLinear[256];
+		float Thresholds[256];
+
+		SrgbTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				ToLinear[i] = powf(i * (1.0f / 255.0f), 2.2f);
+				Thresholds[i] = i == 0 ? -FLT_MAX : powf((i - 0.5f) * (1.0f / 255.0f), 2.2f);
+			}
+		}
+
+		uint32_t ToSrgb(float x) const
+		{
+			uint32_t k = 0;
+			for (uint32_t step = 128; step > 0; step >>= 1)
+			{
+				if (x >= Thresholds[k + step]) k += step;
+			}
+			return k;
+		}
 	};
 
+	const SrgbTables &GetSrgbTables()
+	{
+		static SrgbTables tables;
+		return tables;
+	}
+}
+
+void FSoftwareTexture::GenerateBgraMipmaps()
+{
+	const SrgbTables &srgb = GetSrgbTables();
 	int levels = MipmapLevels();
 	std::vector<Color4f> image(PixelsBgra.Size());
 
 	// Convert to normalized linear colorspace
 	{
-		for (int x = 0; x < GetPhysicalWidth(); x++)
+		int count = GetPhysicalWidth() * GetPhysicalHeight();
+		for (int j = 0; j < count; j++)
 		{
-			for (int y = 0; y < GetPhysicalHeight(); y++)
-			{
-				uint32_t c8 = PixelsBgra[x * GetPhysicalHeight() + y];
-				Color4f c;
-				c.a = powf(APART(c8) * (1.0f / 255.0f), 2.2f);
-				c.r = powf(RPART(c8) * (1.0f / 255.0f), 2.2f);
-				c.g = powf(GPART(c8) * (1.0f / 255.0f), 2.2f);
-				c.b = powf(BPART(c8) * (1.0f / 255.0f), 2.2f);
-				image[x * GetPhysicalHeight() + y] = c;
-			}
+			uint32_t c8 = PixelsBgra[j];
+			float c[4] = { srgb.ToLinear[APART(c8)], srgb.ToLinear[RPART(c8)], srgb.ToLinear[GPART(c8)], srgb.ToLinear[BPART(c8)] };
+			image[j] = Color4f::Load(c);
 		}
 	}
 
@@ -440,42 +606,36 @@ void FSoftwareTexture::GenerateBgraMipmaps()
 			{
 				int sx0 = x * 2;
 				int sx1 = min((x + 1) * 2, srcw - 1);
+				const Color4f *col0 = src + sx0 * srch;
+				const Color4f *col1 = src + sx1 * srch;
 				for (int y = 0; y < h; y++)
 				{
 					int sy0 = y * 2;
 					int sy1 = min((y + 1) * 2, srch - 1);
-
-					Color4f src00 = src[sy0 + sx0 * srch];
-					Color4f src01 = src[sy1 + sx0 * srch];
-					Color4f src10 = src[sy0 + sx1 * srch];
-					Color4f src11 = src[sy1 + sx1 * srch];
-					Color4f c = (src00 + src01 + src10 + src11) * 0.25f;
-
-					dest[y + x * h] = c;
+					dest[y + x * h] = (col0[sy0] + col0[sy1] + col1[sy0] + col1[sy1]) * 0.25f;
 				}
 			}
 
 			// Sharpen filter with a 3x3 kernel:
 			for (int x = 0; x < w; x++)
 			{
+				const Color4f *cols[3] =
+				{
+					dest + (x == 0 ? w - 1 : x - 1) * h,
+					dest + x * h,
+					dest + (x == w - 1 ? 0 : x + 1) * h
+				};
 				for (int y = 0; y < h; y++)
 				{
-					Color4f c = { 0.0f, 0.0f, 0.0f, 0.0f };
-					for (int kx = -1; kx < 2; kx++)
+					int rows[3] = { y == 0 ? h - 1 : y - 1, y, y == h - 1 ? 0 : y + 1 };
+					Color4f c = Color4f::Zero();
+					for (auto col : cols)
 					{
-						for (int ky = -1; ky < 2; ky++)
-						{
-							int a = y + ky;
-							int b = x + kx;
-							if (a < 0) a = h - 1;
-							if (a == h) a = 0;
-							if (b < 0) b = w - 1;
-							if (b == w) b = 0;
-							c = c + dest[a + b * h];
-						}
+						c = c + col[rows[0]];
+						c = c + col[rows[1]];
+						c = c + col[rows[2]];
 					}
-					c = c * (1.0f / 9.0f);
-					smoothed[y + x * h] = c;
+					smoothed[y + x * h] = c * (1.0f / 9.0f);
 				}
 			}
 			float k = 0.08f;
@@ -491,20 +651,12 @@ void FSoftwareTexture::GenerateBgraMipmaps()
 	{
 		Color4f *src = image.data() + GetPhysicalWidth() * GetPhysicalHeight();
 		uint32_t *dest = PixelsBgra.Data() + GetPhysicalWidth() * GetPhysicalHeight();
-		for (int i = 1; i < levels; i++)
+		int count = int(PixelsBgra.Size()) - GetPhysicalWidth() * GetPhysicalHeight();
+		for (int j = 0; j < count; j++)
 		{
-			int w = max(GetPhysicalWidth() >> i, 1);
-			int h = max(GetPhysicalHeight() >> i, 1);
-			for (int j = 0; j < w * h; j++)
-			{
-				uint32_t a = (uint32_t)clamp(powf(max(src[j].a, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t r = (uint32_t)clamp(powf(max(src[j].r, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t g = (uint32_t)clamp(powf(max(src[j].g, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t b = (uint32_t)clamp(powf(max(src[j].b, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				dest[j] = (a << 24) | (r << 16) | (g << 8) | b;
-			}
-			src += w * h;
-			dest += w * h;
+			float c[4];
+			src[j].Store(c);
+			dest[j] = (srgb.ToSrgb(c[0]) << 24) | (srgb.ToSrgb(c[1]) << 16) | (srgb.ToSrgb(c[2]) << 8) | srgb.ToSrgb(c[3]);
 		}
 	}
 }
@@ -523,6 +675,7 @@ void FSoftwareTexture::FreeAllSpans()
 		{
 			FreeSpans (Spandata[i]);
 			Spandata[i] = nullptr;
+			SpanBytes[i] = 0;
 		}
 	}
 }
@@ -33,8 +33,23 @@ protected:
 	int mPhysicalScale;
 	int mBufferFlags;
 
+	// Texture cache bookkeeping. All of this is protected by swrenderer::loadmutex.
+	FSoftwareTexture *CachePrev = nullptr, *CacheNext = nullptr;
+	size_t CachedBytes = 0;
+	size_t SpanBytes[3] = {};
+	int LastUse = -1;	// value of CurrentFrame when the texture was last used
+	bool InCache = false;
+
+	static FSoftwareTexture *CacheHead, *CacheTail;
+	static size_t CacheBytes;
+	static unsigned CacheCount;
+
+	void Touch();
+	void Uncache();
+	virtual size_t GetResidentBytes() const;
+
 	void FreeAllSpans();
-	template<class T> FSoftwareTextureSpan **CreateSpans(const T *pixels);
+	template<class T> FSoftwareTextureSpan **CreateSpans(const T *pixels, size_t &bytes);
 	void FreeSpans(FSoftwareTextureSpan **spans);
 	void CalcBitSize();
 
@@ -43,6 +58,7 @@ public:
 	
 	virtual ~FSoftwareTexture()
 	{
+		Uncache();
 		FreeAllSpans();
 	}
 
@@ -107,6 +123,21 @@ public:
 	// is immediately followed by a call to GetPixels().
 	virtual bool CheckModified (int which) { return false; }
 
+	// Releases all pixel and span data. The next access recreates it.
+	void Evict();
+
+	// Frees the least recently used textures until the cache fits into r_swtexturecache.
+	// May only be called while nothing is being rendered.
+	static void EvictTextures();
+
+	// Starts a new frame for the cache. Textures used in this or the previous frame do not get evicted.
+	static void BeginFrame() { CurrentFrame++; }
+	static int CurrentFrame;
+
+	static unsigned CacheHits, CacheMisses, CacheEvictions;
+	static size_t GetCacheBytes() { return CacheBytes; }
+	static unsigned GetCacheCount() { return CacheCount; }
+
 	void GenerateBgraFromBitmap(const FBitmap &bitmap);
 	void CreatePixelsBgraWithMipmaps();
 	void GenerateBgraMipmaps();
@@ -221,8 +252,12 @@ public:
 	const uint32_t *GetPixelsBgraLocked() override;
 	const uint8_t *GetPixelsLocked(int style) override;
 	bool CheckModified (int which) override;
+	void Unload() override;
 	void GenerateBgraMipmapsFast();
 
+protected:
+	size_t GetResidentBytes() const override;
+
 private:
 
 	int NextPo2 (int v); // [mxd]
@@ -57,6 +57,19 @@ bool FWarpTexture::CheckModified (int style)
 	return screen->FrameTime != GenTime[style];
 }
 
+void FWarpTexture::Unload()
+{
+	for (auto &pix : WarpedPixels) pix.Reset();
+	WarpedPixelsRgba.Reset();
+	for (auto &time : GenTime) time = UINT64_MAX;
+	FSoftwareTexture::Unload();
+}
+
+size_t FWarpTexture::GetResidentBytes() const
+{
+	return FSoftwareTexture::GetResidentBytes() + WarpedPixels[0].Size() + WarpedPixels[1].Size() + WarpedPixelsRgba.Size() * sizeof(uint32_t);
+}
+
 const uint32_t *FWarpTexture::GetPixelsBgraLocked()
 {
 	uint64_t time = screen->FrameTime;
@@ -20,6 +20,8 @@
 //-----------------------------------------------------------------------------
 
 #include <stddef.h>
+#include <algorithm>
+#include <math.h>
 #include "r_drawerargs.h"
 
 namespace swrenderer
@@ -99,4 +101,76 @@ namespace swrenderer
 		}
 		return shadeConstants;
 	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void DrawerLightCuller::Cull(const DrawerLight *lights, int numlights, const float *center, const float *extent2, float origin, float step, int count)
+	{
+		Segments.Clear();
+		Lights.Clear();
+		Lo.Clear();
+		Hi.Clear();
+		Bounds.Clear();
+		if (count <= 0)
+			return;
+
+		// Find the pixel interval each light reaches. It is padded by a pixel on
+		// each side as the drawers evaluate the position at the pixel centers.
+		for (int i = 0; i < numlights; i++)
+		{
+			int lo = 0, hi = count - 1;
+			if (extent2[i] <= 0.0f)
+			{
+				lo = count;
+			}
+			else
+			{
+				float h = sqrtf(extent2[i]);
+				if (step != 0.0f)
+				{
+					float a = (center[i] - h - origin) / step;
+					float b = (center[i] + h - origin) / step;
+					if (a > b) std::swap(a, b);
+					a = clamp(floorf(a) - 1.0f, -1.0f, (float)count);
+					b = clamp(ceilf(b) + 1.0f, -1.0f, (float)count);
+					lo = max((int)a, 0);
+					hi = min((int)b, count - 1);
+				}
+				else if (fabsf(center[i] - origin) >= h)
+				{
+					lo = count;
+				}
+			}
+			Lo.Push(lo);
+			Hi.Push(hi);
+			if (lo <= hi)
+			{
+				Bounds.Push(lo);
+				Bounds.Push(hi + 1);
+			}
+		}
+		Bounds.Push(0);
+		Bounds.Push(count);
+		std::sort(Bounds.begin(), Bounds.end());
+
+		// Turn the boundaries into segments, dropping those that would make a segment too short to pay off.
+		int start = 0;
+		for (int bound : Bounds)
+		{
+			if (bound <= start || (bound < count && (bound - start < MIN_SEGMENT || count - bound < MIN_SEGMENT)))
+				continue;
+
+			SegmentInfo seg = { start, bound - start, Lights.Size(), 0 };
+			for (int i = 0; i < numlights; i++)
+			{
+				if (Lo[i] < bound && Hi[i] >= start)
+				{
+					Lights.Push(lights[i]);
+					seg.numlights++;
+				}
+			}
+			Segments.Push(seg);
+			start = bound;
+		}
+	}
 }
@@ -28,6 +28,51 @@ namespace swrenderer
 		float radius;
 	};
 
+	// Splits a run of pixels (a wall column or a span) into segments that
+	// only get the dynamic lights able to reach any of their pixels, so
+	// the drawers do not have to evaluate every light for every pixel.
+	class DrawerLightCuller
+	{
+	public:
+		struct Segment
+		{
+			int start;
+			int count;
+			DrawerLight *lights;
+			int numlights;
+		};
+
+		// 'center' is the position of each light along the run, measured in the same units as
+		// 'origin' and 'step', which give the position of the first pixel and the increment per pixel.
+		// 'extent2' is the squared distance from the run at which the light's radius is reached.
+		void Cull(const DrawerLight *lights, int numlights, const float *center, const float *extent2, float origin, float step, int count);
+
+		int NumSegments() const { return Segments.Size(); }
+		Segment GetSegment(int index)
+		{
+			auto &seg = Segments[index];
+			return { seg.start, seg.count, Lights.Data() + seg.first, seg.numlights };
+		}
+
+	private:
+		enum
+		{
+			MIN_SEGMENT = 8	// shorter segments are not worth a separate drawer call
+		};
+
+		struct SegmentInfo
+		{
+			int start;
+			int count;
+			unsigned first;
+			int numlights;
+		};
+
+		TArray<SegmentInfo> Segments;
+		TArray<DrawerLight> Lights;
+		TArray<int> Lo, Hi, Bounds;
+	};
+
 	class DrawerArgs
 	{
 	public:
@@ -25,6 +25,7 @@ namespace swrenderer
 		void SetTextureVPos(double v) { ds_yfrac = (uint32_t)(int64_t)(v * 4294967296.0); }
 		void SetTextureUStep(double ustep) { ds_xstep = (uint32_t)(int64_t)(ustep * 4294967296.0); }
 		void SetTextureVStep(double vstep) { ds_ystep = (uint32_t)(int64_t)(vstep * 4294967296.0); }
+		void SetTextureFrac(uint32_t u, uint32_t v) { ds_xfrac = u; ds_yfrac = v; }
 		void SetSolidColor(int colorIndex) { ds_color = colorIndex; }
 
 		void DrawDepthSpan(RenderThread *thread, float idepth1, float idepth2);
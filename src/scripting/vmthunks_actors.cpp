@@ -1478,6 +1478,20 @@ DEFINE_ACTION_FUNCTION_NATIVE(AActor, NewChaseDir, P_NewChaseDir)
 	return 0;
 }
 
+DEFINE_ACTION_FUNCTION_NATIVE(AActor, FlowMoveDir, P_FlowMoveDir)
+{
+	PARAM_SELF_PROLOGUE(AActor);
+	PARAM_OBJECT(goal, AActor);
+	ACTION_RETURN_INT(P_FlowMoveDir(self, goal));
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(AActor, FlowChaseDir, P_FlowChaseDir)
+{
+	PARAM_SELF_PROLOGUE(AActor);
+	PARAM_OBJECT(goal, AActor);
+	ACTION_RETURN_BOOL(P_FlowChaseDir(self, goal));
+}
+
 DEFINE_ACTION_FUNCTION_NATIVE(AActor, RandomChaseDir, P_RandomChaseDir)
 {
 	PARAM_SELF_PROLOGUE(AActor);
@@ -66,6 +66,7 @@
 #include "g_game.h"
 #include "s_music.h"
 #include "v_draw.h"
+#include "tracezones.h"
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
@@ -808,6 +809,7 @@ static void S_SetListener(AActor *listenactor)
 
 void S_UpdateSounds (AActor *listenactor)
 {
+	TRACE_ZONE("S_UpdateSounds");
 	// should never happen
 	S_SetListener(listenactor);
 	